@@ -0,0 +1,216 @@
+#pragma once
+#include "../include/locallru/local_lru.hpp"
+#include "../src/lock_cache.hpp"
+#include "workloads.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// engines.hpp
+// Uniform adapters over the cache implementations so that any workload or
+// benchmark can be replayed against any engine.
+// -----------------------------------------------------------------------------
+// An engine exposes:
+//   static constexpr const char* name;
+//   static constexpr bool virtual_time;            // honours `now` arguments
+//   static constexpr bool shared;                  // one instance may serve
+//                                                  // many threads at once
+//   static constexpr std::size_t max_ttl_classes;  // per-instance TTL stores
+//   Engine(std::size_t capacity, std::uint64_t ttl_seconds);
+//   std::optional<V> get(const K&, Clock::time_point now);
+//   void put(const K&, V, Clock::time_point now);
+//   bool erase(const K&);
+//   std::size_t get_many(std::span<const K>, std::span<std::optional<V>>);
+//
+// Engines that cannot honour a caller-supplied clock ignore `now` and use
+// real time instead; they advertise this with virtual_time = false.
+// -----------------------------------------------------------------------------
+
+namespace locallru::bench {
+
+    template<typename K, typename V>
+    class LruStoreEngine {
+      public:
+        using key_type = K;
+        using value_type = V;
+        static constexpr const char* name = "LruStore";
+        static constexpr std::size_t max_ttl_classes = 255;
+        static constexpr bool virtual_time = true;
+        static constexpr bool shared = false;
+
+        LruStoreEngine(std::size_t capacity, std::uint64_t ttl_seconds) : store_(capacity, ttl_seconds) {}
+
+        std::optional<V> get(const K& key, Clock::time_point now){ return store_.get(key, now); }
+        void put(const K& key, V value, Clock::time_point now){ store_.put(key, std::move(value), now); }
+        bool erase(const K& key){ return store_.erase(key); }
+        std::size_t get_many(std::span<const K> keys, std::span<std::optional<V>> out){ return store_.get_many(keys, out); }
+        std::size_t size() const { return store_.size(); }
+        void clear(){ store_.clear(); }
+
+      private:
+        LruStore<K, V> store_;
+    };
+
+    // LocalCache parameters are captured when a thread first touches its
+    // store, so each LocalCacheEngine must be used from a thread that has not
+    // used LocalCache<V> before (see run_workload).
+    template<typename V>
+    class LocalCacheEngine {
+      public:
+        using key_type = std::string;
+        using value_type = V;
+        static constexpr const char* name = "LocalCache";
+        static constexpr std::size_t max_ttl_classes = 1;
+        static constexpr bool virtual_time = false;
+        static constexpr bool shared = false; // Each thread sees its own store
+
+        LocalCacheEngine(std::size_t capacity, std::uint64_t ttl_seconds)
+            : cache_(LocalCache<V>::initialize(capacity, ttl_seconds)) {}
+
+        std::optional<V> get(const std::string& key, Clock::time_point){ return cache_.get_item(key); }
+        void put(const std::string& key, V value, Clock::time_point){ cache_.add_item(key, std::move(value)); }
+        bool erase(const std::string& key){ return cache_.remove_item(key); }
+        std::size_t get_many(std::span<const std::string> keys, std::span<std::optional<V>> out){ return cache_.get_items(keys, out); }
+        std::size_t size() const { return cache_.size(); }
+        void clear(){ cache_.clear(); }
+
+      private:
+        LocalCache<V> cache_;
+    };
+
+    // LockCache has no TTL; ttl_seconds is accepted and ignored.
+    template<typename K, typename V>
+    class LockCacheEngine {
+      public:
+        using key_type = K;
+        using value_type = V;
+        static constexpr const char* name = "LockCache";
+        static constexpr std::size_t max_ttl_classes = 1;
+        static constexpr bool virtual_time = false;
+        static constexpr bool shared = true;
+
+        LockCacheEngine(std::size_t capacity, std::uint64_t) : cache_(capacity) {}
+
+        std::optional<V> get(const K& key, Clock::time_point){ return cache_.get(key); }
+        void put(const K& key, V value, Clock::time_point){ cache_.put(key, std::move(value)); }
+        bool erase(const K& key){ return cache_.erase(key); }
+        std::size_t get_many(std::span<const K> keys, std::span<std::optional<V>> out){ return cache_.get_many(keys, out); }
+        std::size_t size() const { return cache_.size(); }
+        void clear(){ cache_.clear(); }
+
+      private:
+        lockedlru::LockCache<K, V> cache_;
+    };
+
+    // Short names for the key/value types used in reports.
+    template<typename T>
+    constexpr const char* type_label(){
+        if constexpr (std::is_same_v<T, std::string>) return "str";
+        else if constexpr (std::is_same_v<T, double>) return "f64";
+        else if constexpr (std::is_integral_v<T>) return sizeof(T) == 8 ? "u64" : "u32";
+        else return "obj";
+    }
+
+    // e.g. "LruStore<str,f64>"
+    template<typename Engine>
+    std::string label(){
+        return std::string(Engine::name) + "<" + type_label<typename Engine::key_type>() + ","
+            + type_label<typename Engine::value_type>() + ">";
+    }
+
+    // Maps a workload key id onto an engine's key type without allocating.
+    template<typename K>
+    decltype(auto) key_for(const Workload& w, std::uint32_t id){
+        if constexpr (std::is_same_v<K, std::string>) {
+            return static_cast<const std::string&>(w.key_names[id]);
+        } else {
+            return static_cast<K>(id);
+        }
+    }
+
+    struct WorkloadResult {
+        std::string engine;
+        std::string workload;
+        std::size_t capacity = 0;
+        std::uint64_t gets = 0;
+        std::uint64_t hits = 0;
+        std::uint64_t puts = 0;
+        double elapsed_ns = 0.0;
+        bool skipped = false;
+
+        double hit_ratio() const { return gets ? static_cast<double>(hits) / static_cast<double>(gets) : 0.0; }
+        double ns_per_op() const {
+            const auto ops = gets + puts;
+            return ops ? elapsed_ns / static_cast<double>(ops) : 0.0;
+        }
+    };
+
+    struct ReplayOptions {
+        std::size_t capacity = 10'000;
+        // Virtual time advanced per op, so TTLs expire at a rate independent
+        // of how fast the engine runs. Engines without clock injection use
+        // real time and will rarely see expiry within one replay.
+        std::chrono::nanoseconds virtual_ns_per_op{10'000};
+    };
+
+    // Replays `w` cache-aside style: a get that misses is followed by a put
+    // of the same key, as an application would after fetching from origin.
+    // Runs on a fresh thread so thread-local engines start cold.
+    template<typename Engine>
+    WorkloadResult run_workload(const Workload& w, const ReplayOptions& opt){
+        using K = typename Engine::key_type;
+        using V = typename Engine::value_type;
+
+        WorkloadResult r;
+        r.engine = label<Engine>();
+        r.workload = w.name;
+        r.capacity = opt.capacity;
+        const std::size_t classes = w.ttl_seconds.size();
+        if(classes > Engine::max_ttl_classes) {
+            r.skipped = true;
+            return r;
+        }
+
+        std::thread worker([&] {
+            // Capacity is split evenly so the total footprint is comparable.
+            std::vector<std::unique_ptr<Engine>> engines;
+            for(std::size_t c = 0; c < classes; c++){
+                engines.push_back(std::make_unique<Engine>(std::max<std::size_t>(1, opt.capacity / classes), w.ttl_seconds[c]));
+            }
+
+            const auto base = Clock::now();
+            std::uint64_t gets = 0, hits = 0, puts = 0;
+            const auto start = std::chrono::steady_clock::now();
+            for(std::size_t i = 0; i < w.ops.size(); i++){
+                const Op& op = w.ops[i];
+                const auto now = base + opt.virtual_ns_per_op * static_cast<long long>(i);
+                Engine& e = *engines[op.ttl_class];
+                decltype(auto) key = key_for<K>(w, op.key);
+                if(op.kind == OpKind::get){
+                    gets++;
+                    if(e.get(key, now)) {
+                        hits++;
+                        continue;
+                    }
+                }
+                puts++;
+                e.put(key, V{}, now);
+            }
+            const auto end = std::chrono::steady_clock::now();
+            r.gets = gets;
+            r.hits = hits;
+            r.puts = puts;
+            r.elapsed_ns = std::chrono::duration<double, std::nano>(end - start).count();
+        });
+        worker.join();
+        return r;
+    }
+}
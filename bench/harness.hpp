@@ -0,0 +1,451 @@
+#pragma once
+#include <algorithm>
+#include <barrier>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "perf_counters.hpp"
+#include "report.hpp"
+
+// -----------------------------------------------------------------------------
+// harness.hpp
+// A small, dependency-free microbenchmark harness modelled on Google
+// Benchmark, so the suite builds offline with nothing but the compiler.
+// -----------------------------------------------------------------------------
+// Writing a benchmark:
+//
+//   void bm_get(State& state){
+//       LruStore<int, int> s(state.range(0), 0);   // setup: not timed
+//       for (auto _ : state) {                     // timed loop
+//           do_not_optimize(s.get(42));
+//       }
+//       state.set_items_processed(state.iterations());
+//   }
+//   register_benchmark("get", bm_get)->range(1 << 10, 1 << 20);
+//
+// The runner grows the iteration count until one run takes at least
+// --min-time seconds, then reports ns per iteration. Every run executes on
+// freshly spawned threads, so thread_local caches start cold each time.
+//
+// Multi-threaded benchmarks (->threads(n)) run the function on n threads at
+// once. The timed loop starts on all of them together; state.sync() is a
+// barrier for coordinating shared setup, typically done by thread_index 0.
+//
+// With --perf-counters each thread also counts hardware events (see
+// perf_counters.hpp) over exactly the timed region; they are reported per
+// iteration next to the latency. If the counters cannot be opened the
+// runner says why once and reports latency only. A counter group that never
+// gets onto the PMU leaves its counters out; if none does, the run is
+// labelled "perf: not counted".
+//
+// --out=FILE additionally writes every repetition and aggregate, with the
+// build and machine description, as JSON (or CSV with --format=csv); see
+// report.hpp and scripts/compare_results.py.
+// -----------------------------------------------------------------------------
+
+namespace locallru::bench {
+
+    // Prevents the compiler from discarding a computed value.
+    template<typename T>
+    inline void do_not_optimize(const T& value){
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    template<typename T>
+    inline void do_not_optimize(T& value){
+        asm volatile("" : "+r,m"(value) : : "memory");
+    }
+
+    // Forces pending writes to be considered visible.
+    inline void clobber_memory(){
+        asm volatile("" : : : "memory");
+    }
+
+    class State {
+      public:
+        State(std::uint64_t max_iterations, const std::vector<std::int64_t>& args,
+              int thread_index, int threads, std::barrier<>& sync)
+            : max_iterations_(max_iterations), args_(args),
+              thread_index_(thread_index), threads_(threads), sync_(sync) {}
+
+        // Range-for support: `for (auto _ : state)` runs max_iterations times
+        // with the timer covering exactly the loop.
+        struct Iterator {
+            struct [[maybe_unused]] Value {};
+            State* state;
+            std::uint64_t remaining;
+
+            Value operator*() const { return {}; }
+            Iterator& operator++(){
+                --remaining;
+                return *this;
+            }
+            bool operator!=(const Iterator&){
+                if(remaining != 0) [[likely]] return true;
+                state->finish();
+                return false;
+            }
+        };
+
+        Iterator begin(){
+            start();
+            return Iterator{this, max_iterations_};
+        }
+        Iterator end(){ return Iterator{this, 0}; }
+
+        // Excludes a section of the timed loop (e.g. refilling a drained
+        // store). Each pause costs two clock reads; amortise over many ops.
+        void pause_timing(){
+            elapsed_ns_ += since(start_);
+            if(perf_) perf_->disable();
+        }
+        void resume_timing(){
+            if(perf_) perf_->enable();
+            start_ = Clock::now();
+        }
+
+        // Barrier across all threads of the current run.
+        void sync(){ sync_.arrive_and_wait(); }
+
+        std::int64_t range(std::size_t i = 0) const { return i < args_.size() ? args_[i] : 0; }
+        std::uint64_t iterations() const { return max_iterations_; }
+        int thread_index() const { return thread_index_; }
+        int threads() const { return threads_; }
+
+        void set_items_processed(std::uint64_t n){ items_processed_ = n; }
+        void set_label(std::string label){ label_ = std::move(label); }
+        void skip_with_error(std::string message){
+            error_ = std::move(message);
+            max_iterations_ = 0;
+        }
+
+        // Free-form per-run metrics, averaged across threads when reported.
+        std::map<std::string, double> counters;
+
+        double elapsed_ns() const { return elapsed_ns_; }
+        std::uint64_t items_processed() const { return items_processed_; }
+        const std::string& label() const { return label_; }
+        const std::string& error() const { return error_; }
+
+        // Counters must be opened on the thread that runs the benchmark.
+        void attach_perf_counters(PerfCounters* perf){ perf_ = perf; }
+
+      private:
+        using Clock = std::chrono::steady_clock;
+
+        static double since(Clock::time_point t){
+            return std::chrono::duration<double, std::nano>(Clock::now() - t).count();
+        }
+
+        void start(){
+            sync_.arrive_and_wait();
+            if(perf_) {
+                perf_->reset();
+                perf_->enable();
+            }
+            start_ = Clock::now();
+        }
+
+        void finish(){
+            elapsed_ns_ += since(start_);
+            if(perf_) perf_->disable();
+        }
+
+        std::uint64_t max_iterations_;
+        const std::vector<std::int64_t>& args_;
+        int thread_index_;
+        int threads_;
+        std::barrier<>& sync_;
+        PerfCounters* perf_ = nullptr;
+        Clock::time_point start_{};
+        double elapsed_ns_ = 0.0;
+        std::uint64_t items_processed_ = 0;
+        std::string label_;
+        std::string error_;
+    };
+
+    class Benchmark {
+      public:
+        using Function = std::function<void(State&)>;
+
+        Benchmark(std::string name, Function fn) : name_(std::move(name)), fn_(std::move(fn)) {}
+
+        Benchmark* arg(std::int64_t a){
+            args_.push_back({a});
+            return this;
+        }
+        Benchmark* args(std::vector<std::int64_t> a){
+            args_.push_back(std::move(a));
+            return this;
+        }
+        // lo, lo*multiplier, ..., hi (hi always included).
+        Benchmark* range(std::int64_t lo, std::int64_t hi, std::int64_t multiplier = 8){
+            for(std::int64_t v = lo; v < hi; v *= multiplier) arg(v);
+            return arg(hi);
+        }
+        Benchmark* threads(int n){
+            threads_.push_back(n);
+            return this;
+        }
+        Benchmark* min_time(double seconds){
+            min_time_ = seconds;
+            return this;
+        }
+
+        const std::string& name() const { return name_; }
+        const Function& function() const { return fn_; }
+        const std::vector<std::vector<std::int64_t>>& arg_sets() const { return args_; }
+        const std::vector<int>& thread_counts() const { return threads_; }
+        double min_time_or(double fallback) const { return min_time_ > 0 ? min_time_ : fallback; }
+
+      private:
+        std::string name_;
+        Function fn_;
+        std::vector<std::vector<std::int64_t>> args_;
+        std::vector<int> threads_;
+        double min_time_ = 0.0;
+    };
+
+    inline std::vector<std::unique_ptr<Benchmark>>& registry(){
+        static std::vector<std::unique_ptr<Benchmark>> benchmarks;
+        return benchmarks;
+    }
+
+    inline Benchmark* register_benchmark(std::string name, Benchmark::Function fn){
+        registry().push_back(std::make_unique<Benchmark>(std::move(name), std::move(fn)));
+        return registry().back().get();
+    }
+
+    struct RunOptions {
+        double min_time = 0.5;
+        int repetitions = 1;
+        std::string filter = ".*";
+        bool list_only = false;
+        bool perf_counters = false;
+        std::string out;              // Result file; empty = console only
+        std::string format = "json";  // json | csv
+    };
+
+    namespace detail {
+        inline std::string instance_name(const Benchmark& b, const std::vector<std::int64_t>& args, int threads){
+            std::string n = b.name();
+            for(auto a : args) n += "/" + std::to_string(a);
+            if(threads > 1) n += "/threads:" + std::to_string(threads);
+            return n;
+        }
+
+        inline RunResult run_once(const Benchmark& b, const std::vector<std::int64_t>& args,
+                                  int threads, std::uint64_t iterations, bool perf_counters){
+            std::barrier<> sync(threads);
+            std::vector<std::unique_ptr<State>> states;
+            for(int t = 0; t < threads; t++){
+                states.push_back(std::make_unique<State>(iterations, args, t, threads, sync));
+            }
+            std::vector<std::thread> workers;
+            for(int t = 0; t < threads; t++){
+                workers.emplace_back([&, t] {
+                    State& state = *states[t];
+                    PerfCounters perf;
+                    if(perf_counters && perf.open()) state.attach_perf_counters(&perf);
+                    b.function()(state);
+                    if(!perf.available() || iterations == 0) return;
+                    const auto totals = perf.read();
+                    if(totals.empty()) {
+                        state.set_label(state.label().empty() ? "perf: not counted" : state.label() + " perf: not counted");
+                        return;
+                    }
+                    for(const auto& [name, total] : totals){
+                        state.counters[name] = total / static_cast<double>(iterations);
+                    }
+                    if(state.counters.count("cycles") && state.counters["cycles"] > 0 && state.counters.count("instructions")){
+                        state.counters["IPC"] = state.counters["instructions"] / state.counters["cycles"];
+                    }
+                });
+            }
+            for(auto& w : workers) w.join();
+
+            RunResult r;
+            r.name = instance_name(b, args, threads);
+            r.run_name = r.name;
+            r.iterations = iterations;
+            r.threads = threads;
+            std::uint64_t items = 0;
+            for(const auto& s : states){
+                r.wall_ns = std::max(r.wall_ns, s->elapsed_ns());
+                r.ns_per_op += iterations ? s->elapsed_ns() / static_cast<double>(iterations) : 0.0;
+                items += s->items_processed();
+                for(const auto& [k, v] : s->counters) r.counters[k] += v / threads;
+                if(r.label.empty()) r.label = s->label();
+                if(r.error.empty()) r.error = s->error();
+            }
+            r.ns_per_op /= threads;
+            if(r.wall_ns > 0) r.items_per_second = static_cast<double>(items) * 1e9 / r.wall_ns;
+            return r;
+        }
+
+        // Grows the iteration count until a run lasts at least min_time.
+        inline RunResult calibrate(const Benchmark& b, const std::vector<std::int64_t>& args,
+                                   int threads, double min_time, bool perf_counters){
+            constexpr std::uint64_t max_iterations = 1'000'000'000;
+            std::uint64_t n = 1;
+            for(;;){
+                RunResult r = run_once(b, args, threads, n, perf_counters);
+                const double secs = r.wall_ns / 1e9;
+                if(!r.error.empty() || secs >= min_time || n >= max_iterations) return r;
+                double multiplier = secs > 0 ? (min_time * 1.4) / secs : 10.0;
+                if(secs / min_time <= 0.1) multiplier = std::min(multiplier, 10.0);
+                n = std::min(max_iterations, std::max(n + 1, static_cast<std::uint64_t>(static_cast<double>(n) * multiplier)));
+            }
+        }
+
+        inline std::string human_rate(double per_second){
+            char buf[32];
+            if(per_second >= 1e9) std::snprintf(buf, sizeof(buf), "%.2fG/s", per_second / 1e9);
+            else if(per_second >= 1e6) std::snprintf(buf, sizeof(buf), "%.2fM/s", per_second / 1e6);
+            else if(per_second >= 1e3) std::snprintf(buf, sizeof(buf), "%.2fk/s", per_second / 1e3);
+            else std::snprintf(buf, sizeof(buf), "%.2f/s", per_second);
+            return buf;
+        }
+
+        inline void print_header(){
+            std::printf("%-64s %14s %14s %12s\n", "Benchmark", "Time/op", "Iterations", "Items");
+            std::printf("%s\n", std::string(107, '-').c_str());
+        }
+
+        inline void print_result(const RunResult& r){
+            if(!r.error.empty()){
+                std::printf("%-64s ERROR: %s\n", r.name.c_str(), r.error.c_str());
+                return;
+            }
+            std::printf("%-64s %11.1f ns %14llu %12s", r.name.c_str(), r.ns_per_op,
+                        static_cast<unsigned long long>(r.iterations),
+                        r.items_per_second > 0 ? human_rate(r.items_per_second).c_str() : "");
+            for(const auto& [k, v] : r.counters) std::printf(" %s=%.4g", k.c_str(), v);
+            if(!r.label.empty()) std::printf(" %s", r.label.c_str());
+            std::printf("\n");
+            std::fflush(stdout);
+        }
+
+        inline RunResult aggregate(const std::vector<RunResult>& reps, const std::string& suffix){
+            RunResult a = reps.front();
+            a.name += "_" + suffix;
+            a.aggregate = suffix;
+            a.repetition = 0;
+            std::vector<double> v;
+            for(const auto& r : reps) v.push_back(r.ns_per_op);
+            std::sort(v.begin(), v.end());
+            double mean = 0.0;
+            for(double x : v) mean += x;
+            mean /= static_cast<double>(v.size());
+            if(suffix == "mean") a.ns_per_op = mean;
+            else if(suffix == "median") a.ns_per_op = v[v.size() / 2];
+            else {
+                double var = 0.0;
+                for(double x : v) var += (x - mean) * (x - mean);
+                a.ns_per_op = v.size() > 1 ? std::sqrt(var / static_cast<double>(v.size() - 1)) : 0.0;
+            }
+            a.items_per_second = 0.0;
+            return a;
+        }
+    }
+
+    inline RunOptions parse_options(int argc, char** argv){
+        RunOptions o;
+        for(int i = 1; i < argc; i++){
+            const char* arg = argv[i];
+            auto value = [&](const char* flag) -> const char* {
+                const std::size_t n = std::strlen(flag);
+                return std::strncmp(arg, flag, n) == 0 ? arg + n : nullptr;
+            };
+            if(auto v = value("--filter=")) o.filter = v;
+            else if(auto v = value("--min-time=")) o.min_time = std::strtod(v, nullptr);
+            else if(auto v = value("--repetitions=")) o.repetitions = std::max(1, std::atoi(v));
+            else if(std::strcmp(arg, "--list") == 0) o.list_only = true;
+            else if(std::strcmp(arg, "--perf-counters") == 0) o.perf_counters = true;
+            else if(auto v = value("--out=")) o.out = v;
+            else if(auto v = value("--format=")) o.format = v;
+            else {
+                std::fprintf(stderr, "usage: %s [--filter=REGEX] [--min-time=SECONDS] [--repetitions=N] [--perf-counters]\n"
+                                     "       [--out=FILE] [--format=json|csv] [--list]\n", argv[0]);
+                std::exit(2);
+            }
+        }
+        return o;
+    }
+
+    // Runs every registered benchmark instance matching the filter.
+    inline std::vector<RunResult> run_benchmarks(RunOptions opt){
+        const std::regex filter(opt.filter);
+        if(opt.perf_counters && !opt.list_only){
+            PerfCounters probe;
+            if(!probe.open()) {
+                std::fprintf(stderr, "perf counters unavailable (%s); reporting latency only\n", probe.error().c_str());
+                opt.perf_counters = false;
+            }
+        }
+        std::vector<RunResult> all;
+        if(!opt.list_only) detail::print_header();
+        for(const auto& b : registry()){
+            auto arg_sets = b->arg_sets();
+            if(arg_sets.empty()) arg_sets.push_back({});
+            auto thread_counts = b->thread_counts();
+            if(thread_counts.empty()) thread_counts.push_back(1);
+            for(const auto& args : arg_sets){
+                for(int threads : thread_counts){
+                    const std::string name = detail::instance_name(*b, args, threads);
+                    if(!std::regex_search(name, filter)) continue;
+                    if(opt.list_only){
+                        std::printf("%s\n", name.c_str());
+                        continue;
+                    }
+                    std::vector<RunResult> reps;
+                    reps.push_back(detail::calibrate(*b, args, threads, b->min_time_or(opt.min_time), opt.perf_counters));
+                    for(int rep = 1; rep < opt.repetitions && reps.front().error.empty(); rep++){
+                        reps.push_back(detail::run_once(*b, args, threads, reps.front().iterations, opt.perf_counters));
+                        reps.back().repetition = rep;
+                    }
+                    for(const auto& r : reps){
+                        detail::print_result(r);
+                        all.push_back(r);
+                    }
+                    if(reps.size() > 1){
+                        for(const char* s : {"mean", "median", "stddev"}){
+                            all.push_back(detail::aggregate(reps, s));
+                            detail::print_result(all.back());
+                        }
+                    }
+                }
+            }
+        }
+        return all;
+    }
+
+    inline int run_benchmarks(int argc, char** argv){
+        const RunOptions opt = parse_options(argc, argv);
+        if(opt.format != "json" && opt.format != "csv"){
+            std::fprintf(stderr, "unknown --format=%s (expected json or csv)\n", opt.format.c_str());
+            return 2;
+        }
+        const auto results = run_benchmarks(opt);
+        if(opt.out.empty() || opt.list_only) return 0;
+        const Environment env = collect_environment();
+        const bool ok = opt.format == "csv" ? write_csv(opt.out, env, results) : write_json(opt.out, env, results);
+        if(!ok){
+            std::fprintf(stderr, "failed to write %s\n", opt.out.c_str());
+            return 1;
+        }
+        std::printf("Results written to %s\n", opt.out.c_str());
+        return 0;
+    }
+}
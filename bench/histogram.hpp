@@ -0,0 +1,75 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// -----------------------------------------------------------------------------
+// histogram.hpp
+// Fixed-size latency histogram shared by the load generator and the replay
+// demos. Recording is a couple of instructions and never allocates, so it can
+// sit inside measured loops; per-thread histograms are merged afterwards.
+// -----------------------------------------------------------------------------
+
+namespace locallru::bench {
+
+    // Log-linear latency histogram in nanoseconds: exact below 128 ns, then
+    // 64 sub-buckets per power of two (<= 1.6% relative error) up to 2^63.
+    class LatencyHistogram {
+      public:
+        void record(std::uint64_t ns){
+            counts_[index_of(ns)]++;
+            total_++;
+            sum_ += static_cast<double>(ns);
+            max_ = std::max(max_, ns);
+        }
+
+        void merge(const LatencyHistogram& o){
+            for(std::size_t i = 0; i < kBuckets; i++) counts_[i] += o.counts_[i];
+            total_ += o.total_;
+            sum_ += o.sum_;
+            max_ = std::max(max_, o.max_);
+        }
+
+        std::uint64_t count() const { return total_; }
+        std::uint64_t max() const { return max_; }
+        double mean() const { return total_ ? sum_ / static_cast<double>(total_) : 0.0; }
+
+        // Value at quantile q in [0, 1], reported as the bucket's upper edge.
+        std::uint64_t percentile(double q) const {
+            if(total_ == 0) return 0;
+            const auto rank = static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(total_)));
+            std::uint64_t seen = 0;
+            for(std::size_t i = 0; i < kBuckets; i++){
+                seen += counts_[i];
+                if(seen >= std::max<std::uint64_t>(rank, 1)) return std::min(upper_edge(i), max_);
+            }
+            return max_;
+        }
+
+      private:
+        static constexpr unsigned kLinearBits = 7;                    // 0..127 exact
+        static constexpr std::uint64_t kSub = 1u << (kLinearBits - 1); // 64 per octave
+        static constexpr std::size_t kBuckets = (1u << kLinearBits) + (64 - kLinearBits) * kSub;
+
+        static std::size_t index_of(std::uint64_t v){
+            if(v < (1u << kLinearBits)) return static_cast<std::size_t>(v);
+            const unsigned shift = static_cast<unsigned>(std::bit_width(v)) - kLinearBits; // v >> shift in [64, 128)
+            return (1u << kLinearBits) + (shift - 1) * kSub + static_cast<std::size_t>((v >> shift) - kSub);
+        }
+
+        static std::uint64_t upper_edge(std::size_t i){
+            if(i < (1u << kLinearBits)) return i;
+            const std::size_t j = i - (1u << kLinearBits);
+            const unsigned shift = static_cast<unsigned>(j / kSub) + 1;
+            return (((j % kSub) + kSub + 1) << shift) - 1;
+        }
+
+        std::array<std::uint64_t, kBuckets> counts_{};
+        std::uint64_t total_ = 0;
+        double sum_ = 0.0;
+        std::uint64_t max_ = 0;
+    };
+}
@@ -0,0 +1,95 @@
+#include "engines.hpp"
+#include "open_loop.hpp"
+#include "workloads.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace locallru::bench;
+
+// Sweeps offered load for each engine with an open-loop, fixed-schedule
+// driver (see open_loop.hpp) and reports latency percentiles measured from
+// intended start, alongside service time, and the saturation knee.
+
+namespace {
+    struct Args {
+        OpenLoopOptions run;
+        SweepOptions sweep;
+        WorkloadParams workload;
+        std::string engine = "all";
+        double skew = 0.99;
+    };
+
+    Args parse_args(int argc, char** argv){
+        Args a;
+        a.workload.ops = 1'000'000;
+        for(int i = 1; i < argc; i++){
+            const char* arg = argv[i];
+            auto value = [&](const char* flag) -> const char* {
+                const std::size_t n = std::strlen(flag);
+                return std::strncmp(arg, flag, n) == 0 ? arg + n : nullptr;
+            };
+            if(auto v = value("--engine=")) a.engine = v;
+            else if(auto v = value("--workers=")) a.run.workers = std::atoi(v);
+            else if(auto v = value("--arrival=")) a.run.arrival = std::strcmp(v, "constant") == 0 ? Arrival::constant : Arrival::poisson;
+            else if(auto v = value("--seconds=")) a.run.seconds = std::strtod(v, nullptr);
+            else if(auto v = value("--capacity=")) a.run.capacity = std::strtoull(v, nullptr, 10);
+            else if(auto v = value("--min-rate=")) a.sweep.min_rate = std::strtod(v, nullptr);
+            else if(auto v = value("--max-rate=")) a.sweep.max_rate = std::strtod(v, nullptr);
+            else if(auto v = value("--step=")) a.sweep.step = std::strtod(v, nullptr);
+            else if(auto v = value("--universe=")) a.workload.universe = static_cast<std::uint32_t>(std::strtoul(v, nullptr, 10));
+            else if(auto v = value("--read-ratio=")) a.workload.read_ratio = std::strtod(v, nullptr);
+            else if(auto v = value("--skew=")) a.skew = std::strtod(v, nullptr);
+            else {
+                std::fprintf(stderr,
+                    "usage: %s [--engine=all|LruStore|LocalCache|LockCache] [--workers=N]\n"
+                    "          [--arrival=poisson|constant] [--seconds=S] [--capacity=N]\n"
+                    "          [--min-rate=OPS] [--max-rate=OPS] [--step=F]\n"
+                    "          [--universe=N] [--read-ratio=F] [--skew=S]\n", argv[0]);
+                std::exit(2);
+            }
+        }
+        if(a.sweep.step <= 1.0) a.sweep.step = 1.5;
+        return a;
+    }
+
+    void print_step(const OpenLoopResult& r, bool saturated){
+        std::printf("%12.0f %12.0f %9llu %9llu %9llu %11llu %9llu %9llu%s\n", r.offered, r.achieved,
+                    static_cast<unsigned long long>(r.latency.percentile(0.50)),
+                    static_cast<unsigned long long>(r.latency.percentile(0.99)),
+                    static_cast<unsigned long long>(r.latency.percentile(0.999)),
+                    static_cast<unsigned long long>(r.latency.max()),
+                    static_cast<unsigned long long>(r.service.percentile(0.50)),
+                    static_cast<unsigned long long>(r.service.percentile(0.99)),
+                    saturated ? "  <- saturated" : "");
+        std::fflush(stdout);
+    }
+
+    template<typename Engine>
+    void run(const Args& a, const Workload& w){
+        if(a.engine != "all" && a.engine != Engine::name) return;
+        std::printf("\n%s, %d worker(s), %s arrivals, %s\n", label<Engine>().c_str(), a.run.workers,
+                    a.run.arrival == Arrival::poisson ? "Poisson" : "constant", w.name.c_str());
+        std::printf("%12s %12s %9s %9s %9s %11s %9s %9s\n", "offered/s", "achieved/s", "p50 ns", "p99 ns",
+                    "p99.9 ns", "max ns", "svc p50", "svc p99");
+        const auto result = sweep<Engine>(w, a.run, a.sweep, print_step);
+        if(result.knee >= 0){
+            std::printf("knee: ~%.0f ops/s (last sustainable step %.0f ops/s)\n", result.steps[result.knee].offered,
+                        result.knee > 0 ? result.steps[result.knee - 1].offered : 0.0);
+        } else {
+            std::printf("knee: not reached below %.0f ops/s\n", a.sweep.max_rate);
+        }
+    }
+}
+
+int main(int argc, char** argv){
+    const Args args = parse_args(argc, argv);
+    const Workload w = zipf(args.workload, args.skew);
+    run<LruStoreEngine<std::string, double>>(args, w);
+    run<LocalCacheEngine<double>>(args, w);
+    run<LockCacheEngine<std::string, double>>(args, w);
+    return 0;
+}
@@ -0,0 +1,208 @@
+#include "engines.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <malloc.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace locallru;
+using namespace locallru::bench;
+
+// -----------------------------------------------------------------------------
+// Memory footprint per cached entry, for capacity planning.
+//
+// Each engine is filled to capacity in a forked child so that allocator
+// caches and RSS left behind by one engine never flatter the next. Views
+// reported per entry:
+//   allocated  live bytes from operator new, as malloc_usable_size (what the
+//              allocator hands out, including its size-class rounding)
+//   blocks     live heap blocks (each costs allocator metadata on top)
+//   rss        growth in resident set size (what the machine actually pays,
+//              including bucket arrays abandoned by rehashing)
+// "payload" is the key and value bytes an application thinks it is storing;
+// overhead = allocated / payload.
+// -----------------------------------------------------------------------------
+
+namespace {
+    std::atomic<std::int64_t> g_allocated{0};
+    std::atomic<std::int64_t> g_blocks{0};
+
+    void* counted_alloc(std::size_t n, std::size_t align){
+        void* p = align > alignof(std::max_align_t) ? std::aligned_alloc(align, (n + align - 1) / align * align)
+                                                    : std::malloc(n ? n : 1);
+        if(!p) throw std::bad_alloc();
+        g_allocated.fetch_add(static_cast<std::int64_t>(malloc_usable_size(p)), std::memory_order_relaxed);
+        g_blocks.fetch_add(1, std::memory_order_relaxed);
+        return p;
+    }
+
+    void counted_free(void* p){
+        if(!p) return;
+        g_allocated.fetch_sub(static_cast<std::int64_t>(malloc_usable_size(p)), std::memory_order_relaxed);
+        g_blocks.fetch_sub(1, std::memory_order_relaxed);
+        std::free(p);
+    }
+}
+
+void* operator new(std::size_t n){ return counted_alloc(n, 0); }
+void* operator new[](std::size_t n){ return counted_alloc(n, 0); }
+void* operator new(std::size_t n, std::align_val_t a){ return counted_alloc(n, static_cast<std::size_t>(a)); }
+void* operator new[](std::size_t n, std::align_val_t a){ return counted_alloc(n, static_cast<std::size_t>(a)); }
+void operator delete(void* p) noexcept { counted_free(p); }
+void operator delete[](void* p) noexcept { counted_free(p); }
+void operator delete(void* p, std::size_t) noexcept { counted_free(p); }
+void operator delete[](void* p, std::size_t) noexcept { counted_free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { counted_free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { counted_free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { counted_free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { counted_free(p); }
+
+namespace {
+    constexpr std::size_t kValueBytes = 100;
+
+    // A fixed-size record, e.g. a quote, stored by value.
+    struct Quote {
+        double bid, ask, bid_size, ask_size;
+        std::int64_t ts_ns;
+        std::uint32_t venue, flags;
+    };
+
+    std::int64_t rss_bytes(){
+        long pages = 0, resident = 0;
+        if(FILE* f = std::fopen("/proc/self/statm", "r")) {
+            if(std::fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+            std::fclose(f);
+        }
+        return static_cast<std::int64_t>(resident) * sysconf(_SC_PAGESIZE);
+    }
+
+    template<typename T>
+    std::size_t payload_bytes(const T& v){
+        if constexpr (std::is_same_v<T, std::string>) return v.size();
+        else return sizeof(T);
+    }
+
+    template<typename V>
+    V make_value(std::uint64_t i){
+        if constexpr (std::is_same_v<V, std::string>) return std::string(kValueBytes, static_cast<char>('a' + i % 26));
+        else if constexpr (std::is_same_v<V, Quote>) return Quote{1.0 * i, 1.0 * i + 0.01, 100, 200, static_cast<std::int64_t>(i), 1, 0};
+        else return static_cast<V>(i);
+    }
+
+    template<typename K>
+    K make_key(std::uint64_t i){
+        if constexpr (std::is_same_v<K, std::string>) return key_name(i);
+        else return static_cast<K>(i);
+    }
+
+    struct Footprint {
+        char engine[48];
+        std::uint64_t entries;
+        double payload, allocated, rss, blocks;
+    };
+
+    template<typename Engine>
+    Footprint measure(std::size_t capacity){
+        using K = typename Engine::key_type;
+        using V = typename Engine::value_type;
+
+        // Keys and values are built before the baseline so only the copies
+        // held by the engine are counted.
+        std::vector<K> keys;
+        std::vector<V> values;
+        keys.reserve(capacity);
+        values.reserve(capacity);
+        double payload = 0;
+        for(std::size_t i = 0; i < capacity; i++){
+            keys.push_back(make_key<K>(i));
+            values.push_back(make_value<V>(i));
+            payload += static_cast<double>(payload_bytes(keys.back()) + payload_bytes(values.back()));
+        }
+
+        const auto alloc0 = g_allocated.load(), blocks0 = g_blocks.load();
+        const auto rss0 = rss_bytes();
+        auto* engine = new Engine(capacity, 0);
+        const auto now = Clock::now();
+        for(std::size_t i = 0; i < capacity; i++) engine->put(keys[i], values[i], now);
+        const auto rss1 = rss_bytes();
+
+        const double n = static_cast<double>(capacity);
+        Footprint f{};
+        std::snprintf(f.engine, sizeof(f.engine), "%s", label<Engine>().c_str());
+        f.entries = capacity;
+        f.payload = payload / n;
+        f.allocated = static_cast<double>(g_allocated.load() - alloc0) / n;
+        f.blocks = static_cast<double>(g_blocks.load() - blocks0) / n;
+        f.rss = static_cast<double>(rss1 - rss0) / n;
+        return f; // engine deliberately leaked; the child exits right away
+    }
+
+    // Runs measure<Engine> in a child process and reads the result back.
+    template<typename Engine>
+    bool measure_isolated(std::size_t capacity, Footprint& out){
+        int fds[2];
+        if(pipe(fds) != 0) return false;
+        const pid_t pid = fork();
+        if(pid < 0) return false;
+        if(pid == 0){
+            ::close(fds[0]);
+            const Footprint f = measure<Engine>(capacity);
+            const bool ok = write(fds[1], &f, sizeof(f)) == static_cast<ssize_t>(sizeof(f));
+            _exit(ok ? 0 : 1);
+        }
+        ::close(fds[1]);
+        const bool ok = read(fds[0], &out, sizeof(out)) == static_cast<ssize_t>(sizeof(out));
+        ::close(fds[0]);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        return ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+
+    template<typename Engine>
+    void report(std::size_t capacity){
+        Footprint f{};
+        if(!measure_isolated<Engine>(capacity, f)){
+            std::printf("%-22s measurement failed\n", label<Engine>().c_str());
+            return;
+        }
+        std::printf("%-22s %10llu %9.1f %10.1f %9.1f %7.2f %9.2fx\n", f.engine,
+                    static_cast<unsigned long long>(f.entries), f.payload, f.allocated,
+                    f.rss, f.blocks, f.payload > 0 ? f.allocated / f.payload : 0.0);
+        std::fflush(stdout);
+    }
+}
+
+int main(int argc, char** argv){
+    std::size_t capacity = 1'000'000;
+    for(int i = 1; i < argc; i++){
+        if(std::strncmp(argv[i], "--capacity=", 11) == 0) capacity = std::strtoull(argv[i] + 11, nullptr, 10);
+        else {
+            std::fprintf(stderr, "usage: %s [--capacity=N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::printf("Bytes per entry at capacity %zu (string keys are %zu chars, string values %zu chars)\n\n",
+                capacity, key_name(0).size(), kValueBytes);
+    std::printf("%-22s %10s %9s %10s %9s %7s %10s\n", "engine", "entries", "payload",
+                "allocated", "rss", "blocks", "overhead");
+    report<LruStoreEngine<std::uint64_t, double>>(capacity);
+    report<LruStoreEngine<std::uint64_t, Quote>>(capacity);
+    report<LruStoreEngine<std::string, double>>(capacity);
+    report<LruStoreEngine<std::string, Quote>>(capacity);
+    report<LruStoreEngine<std::string, std::string>>(capacity);
+    report<LocalCacheEngine<double>>(capacity);
+    report<LocalCacheEngine<std::string>>(capacity);
+    report<LockCacheEngine<std::uint64_t, double>>(capacity);
+    report<LockCacheEngine<std::string, double>>(capacity);
+    report<LockCacheEngine<std::string, std::string>>(capacity);
+    return 0;
+}
@@ -0,0 +1,364 @@
+#include "engines.hpp"
+#include "harness.hpp"
+#include "../include/locallru/memoize.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace locallru;
+using namespace locallru::bench;
+
+// -----------------------------------------------------------------------------
+// Per-operation microbenchmarks for every engine, parameterised by capacity
+// (the benchmark argument) and key/value type (the template argument).
+//
+//   hit         get of a present key
+//   miss        get of an absent key
+//   insert_new  put of a new key into a store with free space
+//   update      put of a present key
+//   evict       put of a new key into a full store (evicts the LRU entry)
+//   expire      get of a present but expired key (virtual-time engines only)
+//   erase       erase of a present key
+//   multi_get   get_many of kMultiGetBatch present keys
+//   concurrent  get hits from 1..8 threads; LockCache instances are shared,
+//               LocalCache stores are per thread
+//   memo        cached calls of a 3-argument function, keyed by the
+//               arguments formatted into a std::string or by memoize<>
+// -----------------------------------------------------------------------------
+
+namespace {
+    constexpr std::size_t kMultiGetBatch = 16;
+    constexpr std::size_t kValueBytes = 100;
+
+    template<typename K>
+    std::vector<K> make_keys(std::uint64_t first, std::size_t n){
+        std::vector<K> keys;
+        keys.reserve(n);
+        for(std::size_t i = 0; i < n; i++){
+            if constexpr (std::is_same_v<K, std::string>) keys.push_back(key_name(first + i));
+            else keys.push_back(static_cast<K>(first + i));
+        }
+        return keys;
+    }
+
+    template<typename V>
+    V make_value(std::uint64_t i){
+        if constexpr (std::is_same_v<V, std::string>) return std::string(kValueBytes, static_cast<char>('a' + i % 26));
+        else return static_cast<V>(i);
+    }
+
+    // Lookups follow a fixed random permutation so that consecutive
+    // operations do not walk hash buckets or list nodes in allocation order.
+    template<typename K>
+    std::vector<K> shuffled(std::vector<K> keys){
+        std::mt19937_64 rng(1234);
+        std::shuffle(keys.begin(), keys.end(), rng);
+        return keys;
+    }
+
+    template<typename Engine, typename K>
+    void fill(Engine& e, const std::vector<K>& keys, Clock::time_point now){
+        using V = typename Engine::value_type;
+        for(std::size_t i = 0; i < keys.size(); i++) e.put(keys[i], make_value<V>(i), now);
+    }
+
+    std::size_t capacity_of(const State& state){
+        return static_cast<std::size_t>(state.range(0));
+    }
+
+    template<typename Engine>
+    void bm_hit(State& state){
+        using K = typename Engine::key_type;
+        const auto cap = capacity_of(state);
+        Engine e(cap, 0);
+        const auto now = Clock::now();
+        const auto keys = make_keys<K>(0, cap);
+        fill(e, keys, now);
+        const auto order = shuffled(keys);
+        std::size_t i = 0;
+        for(auto _ : state){
+            do_not_optimize(e.get(order[i], now));
+            if(++i == order.size()) i = 0;
+        }
+        state.set_items_processed(state.iterations());
+    }
+
+    template<typename Engine>
+    void bm_miss(State& state){
+        using K = typename Engine::key_type;
+        const auto cap = capacity_of(state);
+        Engine e(cap, 0);
+        const auto now = Clock::now();
+        fill(e, make_keys<K>(0, cap), now);
+        const auto absent = shuffled(make_keys<K>(cap, cap));
+        std::size_t i = 0;
+        for(auto _ : state){
+            do_not_optimize(e.get(absent[i], now));
+            if(++i == absent.size()) i = 0;
+        }
+        state.set_items_processed(state.iterations());
+    }
+
+    template<typename Engine>
+    void bm_insert_new(State& state){
+        using K = typename Engine::key_type;
+        using V = typename Engine::value_type;
+        const auto cap = capacity_of(state);
+        Engine e(cap, 0);
+        const auto now = Clock::now();
+        const auto keys = shuffled(make_keys<K>(0, cap));
+        const V value = make_value<V>(7);
+        std::size_t i = 0;
+        for(auto _ : state){
+            e.put(keys[i], value, now);
+            if(++i == keys.size()){
+                state.pause_timing();
+                e.clear();
+                i = 0;
+                state.resume_timing();
+            }
+        }
+        state.set_items_processed(state.iterations());
+    }
+
+    template<typename Engine>
+    void bm_update(State& state){
+        using K = typename Engine::key_type;
+        using V = typename Engine::value_type;
+        const auto cap = capacity_of(state);
+        Engine e(cap, 0);
+        const auto now = Clock::now();
+        const auto keys = make_keys<K>(0, cap);
+        fill(e, keys, now);
+        const auto order = shuffled(keys);
+        const V value = make_value<V>(7);
+        std::size_t i = 0;
+        for(auto _ : state){
+            e.put(order[i], value, now);
+            if(++i == order.size()) i = 0;
+        }
+        state.set_items_processed(state.iterations());
+    }
+
+    // Cycling through 2 * capacity distinct keys in order means every put
+    // targets a key evicted capacity puts ago, so each one evicts.
+    template<typename Engine>
+    void bm_evict(State& state){
+        using K = typename Engine::key_type;
+        using V = typename Engine::value_type;
+        const auto cap = capacity_of(state);
+        Engine e(cap, 0);
+        const auto now = Clock::now();
+        const auto keys = make_keys<K>(0, 2 * cap);
+        fill(e, std::vector<K>(keys.begin(), keys.begin() + static_cast<std::ptrdiff_t>(cap)), now);
+        const V value = make_value<V>(7);
+        std::size_t i = cap;
+        for(auto _ : state){
+            e.put(keys[i], value, now);
+            if(++i == keys.size()) i = 0;
+        }
+        state.set_items_processed(state.iterations());
+    }
+
+    // Entries are written at t0 and read at t0 + 2s with a 1s TTL, so every
+    // get finds an expired entry and removes it.
+    template<typename Engine>
+    void bm_expire(State& state){
+        using K = typename Engine::key_type;
+        const auto cap = capacity_of(state);
+        Engine e(cap, 1);
+        const auto t0 = Clock::now();
+        const auto later = t0 + std::chrono::seconds(2);
+        const auto keys = shuffled(make_keys<K>(0, cap));
+        fill(e, keys, t0);
+        std::size_t i = 0;
+        for(auto _ : state){
+            do_not_optimize(e.get(keys[i], later));
+            if(++i == keys.size()){
+                state.pause_timing();
+                fill(e, keys, t0);
+                i = 0;
+                state.resume_timing();
+            }
+        }
+        state.set_items_processed(state.iterations());
+    }
+
+    template<typename Engine>
+    void bm_erase(State& state){
+        using K = typename Engine::key_type;
+        const auto cap = capacity_of(state);
+        Engine e(cap, 0);
+        const auto now = Clock::now();
+        const auto keys = shuffled(make_keys<K>(0, cap));
+        fill(e, keys, now);
+        std::size_t i = 0;
+        for(auto _ : state){
+            do_not_optimize(e.erase(keys[i]));
+            if(++i == keys.size()){
+                state.pause_timing();
+                fill(e, keys, now);
+                i = 0;
+                state.resume_timing();
+            }
+        }
+        state.set_items_processed(state.iterations());
+    }
+
+    template<typename Engine>
+    void bm_multi_get(State& state){
+        using K = typename Engine::key_type;
+        using V = typename Engine::value_type;
+        const auto cap = std::max(capacity_of(state), kMultiGetBatch);
+        Engine e(cap, 0);
+        const auto now = Clock::now();
+        const auto keys = make_keys<K>(0, cap);
+        fill(e, keys, now);
+        const auto order = shuffled(keys);
+        std::array<std::optional<V>, kMultiGetBatch> out;
+        std::size_t i = 0;
+        for(auto _ : state){
+            do_not_optimize(e.get_many(std::span<const K>(order.data() + i, kMultiGetBatch), out));
+            i += kMultiGetBatch;
+            if(i + kMultiGetBatch > order.size()) i = 0;
+        }
+        state.set_items_processed(state.iterations() * kMultiGetBatch);
+    }
+
+    // Shared engines are built by thread 0 and used by all threads; per-thread
+    // engines (LocalCache) are built by each thread for itself.
+    template<typename Engine>
+    void bm_concurrent_hit(State& state){
+        constexpr bool Shared = Engine::shared;
+        using K = typename Engine::key_type;
+        static std::unique_ptr<Engine> shared;
+        const auto cap = capacity_of(state);
+        const auto now = Clock::now();
+        const auto keys = make_keys<K>(0, cap);
+        std::unique_ptr<Engine> own;
+        if(!Shared || state.thread_index() == 0){
+            auto e = std::make_unique<Engine>(cap, 0);
+            fill(*e, keys, now);
+            (Shared ? shared : own) = std::move(e);
+        }
+        state.sync();
+        Engine& e = Shared ? *shared : *own;
+        const auto order = shuffled(keys);
+        std::size_t i = (order.size() / state.threads()) * state.thread_index();
+        for(auto _ : state){
+            do_not_optimize(e.get(order[i], now));
+            if(++i == order.size()) i = 0;
+        }
+        state.set_items_processed(state.iterations());
+        state.sync();
+        if(Shared && state.thread_index() == 0) shared.reset();
+    }
+    // Arguments of the memoized function: every (symbol, venue, field)
+    // triple is distinct, and every call in the timed loop hits.
+    struct MemoArgs {
+        std::string symbol;
+        std::uint32_t venue;
+        std::uint32_t field;
+    };
+
+    double memo_fn(const std::string& symbol, std::uint32_t venue, std::uint32_t field){
+        return static_cast<double>(symbol.size() + venue * 4 + field);
+    }
+
+    std::vector<MemoArgs> memo_args(std::size_t n){
+        std::vector<MemoArgs> args;
+        args.reserve(n);
+        for(std::size_t i = 0; i < n; i++){
+            args.push_back(MemoArgs{key_name(i / 32), static_cast<std::uint32_t>(i / 4 % 8), static_cast<std::uint32_t>(i % 4)});
+        }
+        return shuffled(std::move(args));
+    }
+
+    void bm_memo_string_key(State& state){
+        const auto cap = capacity_of(state);
+        LruStore<std::string, double> store(cap, 0);
+        const auto args = memo_args(cap);
+        auto call = [&](const MemoArgs& a){
+            const std::string key = a.symbol + '|' + std::to_string(a.venue) + '|' + std::to_string(a.field);
+            if(auto v = store.get(key)) return *v;
+            const double v = memo_fn(a.symbol, a.venue, a.field);
+            store.put(key, v);
+            return v;
+        };
+        for(const auto& a : args) call(a);
+        std::size_t i = 0;
+        for(auto _ : state){
+            do_not_optimize(call(args[i]));
+            if(++i == args.size()) i = 0;
+        }
+        state.set_items_processed(state.iterations());
+    }
+
+    void bm_memo_tuple_key(State& state){
+        const auto cap = capacity_of(state);
+        auto memo = memoize<&memo_fn>(cap);
+        const auto args = memo_args(cap);
+        for(const auto& a : args) memo(a.symbol, a.venue, a.field);
+        std::size_t i = 0;
+        for(auto _ : state){
+            do_not_optimize(memo(args[i].symbol, args[i].venue, args[i].field));
+            if(++i == args.size()) i = 0;
+        }
+        state.set_items_processed(state.iterations());
+    }
+
+
+    constexpr std::int64_t kMinCapacity = 1 << 10;
+    constexpr std::int64_t kMaxCapacity = 1 << 18;
+
+    template<typename Engine>
+    void register_engine(){
+        const std::string l = label<Engine>();
+        register_benchmark("hit/" + l, bm_hit<Engine>)->range(kMinCapacity, kMaxCapacity, 16);
+        register_benchmark("miss/" + l, bm_miss<Engine>)->range(kMinCapacity, kMaxCapacity, 16);
+        register_benchmark("insert_new/" + l, bm_insert_new<Engine>)->range(kMinCapacity, kMaxCapacity, 16);
+        register_benchmark("update/" + l, bm_update<Engine>)->range(kMinCapacity, kMaxCapacity, 16);
+        register_benchmark("evict/" + l, bm_evict<Engine>)->range(kMinCapacity, kMaxCapacity, 16);
+        if constexpr (Engine::virtual_time) {
+            register_benchmark("expire/" + l, bm_expire<Engine>)->range(kMinCapacity, kMaxCapacity, 16);
+        }
+        register_benchmark("erase/" + l, bm_erase<Engine>)->range(kMinCapacity, kMaxCapacity, 16);
+        register_benchmark("multi_get/" + l, bm_multi_get<Engine>)->range(kMinCapacity, kMaxCapacity, 16);
+    }
+
+    template<typename Engine>
+    void register_concurrent(){
+        register_benchmark("concurrent_hit/" + label<Engine>(), bm_concurrent_hit<Engine>)
+            ->arg(1 << 14)->threads(1)->threads(2)->threads(4)->threads(8);
+    }
+
+    void register_all(){
+        register_engine<LruStoreEngine<std::uint64_t, double>>();
+        register_engine<LruStoreEngine<std::uint64_t, std::string>>();
+        register_engine<LruStoreEngine<std::string, double>>();
+        register_engine<LruStoreEngine<std::string, std::string>>();
+        register_engine<LocalCacheEngine<double>>();
+        register_engine<LocalCacheEngine<std::string>>();
+        register_engine<LockCacheEngine<std::uint64_t, double>>();
+        register_engine<LockCacheEngine<std::string, double>>();
+        register_engine<LockCacheEngine<std::string, std::string>>();
+
+        register_concurrent<LocalCacheEngine<double>>();
+        register_concurrent<LockCacheEngine<std::string, double>>();
+
+        register_benchmark("memo/string_key", bm_memo_string_key)->range(kMinCapacity, kMaxCapacity, 16);
+        register_benchmark("memo/tuple_key", bm_memo_tuple_key)->range(kMinCapacity, kMaxCapacity, 16);
+    }
+}
+
+int main(int argc, char** argv){
+    register_all();
+    return run_benchmarks(argc, argv);
+}
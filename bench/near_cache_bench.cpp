@@ -0,0 +1,212 @@
+#include "../include/locallru/local_lru.hpp"
+#include "../include/locallru/near_cache.hpp"
+#include "histogram.hpp"
+#include "workloads.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace locallru;
+using namespace locallru::bench;
+
+// -----------------------------------------------------------------------------
+// Near-cache payoff and freshness: reader threads replay Zipf gets against
+// an InProcessRemote with a simulated round trip, once directly and once
+// through a NearCache, while a writer thread keeps changing keys at the
+// remote as another service would.
+//
+//   locallru_near_cache_bench [--readers=N] [--seconds=S] [--keys=N]
+//                             [--skew=S] [--round-trip-us=U]
+//                             [--writes-per-sec=N] [--capacity=N]
+//
+// Every value carries a version. The writer publishes a key's version
+// after the remote write returns; a read that starts later and returns an
+// older version is counted as stale (expected: 0). Reported: get latency,
+// remote reads per get and, for the near cache, invalidations applied.
+// -----------------------------------------------------------------------------
+
+namespace {
+    struct Args {
+        int readers = 2;
+        double seconds = 2.0;
+        std::uint32_t keys = 10'000;
+        double skew = 0.99;
+        double round_trip_us = 50.0;
+        double writes_per_sec = 1000.0;
+        std::size_t capacity = 10'000;
+    };
+
+    Args parse_args(int argc, char** argv){
+        Args a;
+        for(int i = 1; i < argc; i++){
+            const char* arg = argv[i];
+            auto value = [&](const char* flag) -> const char* {
+                const std::size_t n = std::strlen(flag);
+                return std::strncmp(arg, flag, n) == 0 ? arg + n : nullptr;
+            };
+            if(auto v = value("--readers=")) a.readers = std::max(1, std::atoi(v));
+            else if(auto v = value("--seconds=")) a.seconds = std::strtod(v, nullptr);
+            else if(auto v = value("--keys=")) a.keys = std::max(1u, static_cast<std::uint32_t>(std::strtoul(v, nullptr, 10)));
+            else if(auto v = value("--skew=")) a.skew = std::strtod(v, nullptr);
+            else if(auto v = value("--round-trip-us=")) a.round_trip_us = std::strtod(v, nullptr);
+            else if(auto v = value("--writes-per-sec=")) a.writes_per_sec = std::strtod(v, nullptr);
+            else if(auto v = value("--capacity=")) a.capacity = std::strtoull(v, nullptr, 10);
+            else {
+                std::fprintf(stderr,
+                    "usage: %s [--readers=N] [--seconds=S] [--keys=N] [--skew=S] [--round-trip-us=U]\n"
+                    "          [--writes-per-sec=N] [--capacity=N]\n", argv[0]);
+                std::exit(2);
+            }
+        }
+        return a;
+    }
+
+    struct Versioned {
+        std::uint64_t version = 0;
+        std::string payload;
+    };
+
+    using Remote = InProcessRemote<Versioned>;
+
+    struct ReaderResult {
+        LatencyHistogram latency;
+        std::uint64_t gets = 0;
+        std::uint64_t stale = 0;
+        NearStats near;
+    };
+
+    struct Shared {
+        const Workload* workload = nullptr;
+        std::unique_ptr<std::atomic<std::uint64_t>[]> published;   // Per key
+        std::atomic<bool> stop{false};
+    };
+
+    // get(key) -> std::optional<Versioned>
+    template<typename Get>
+    ReaderResult read_loop(Shared& sh, std::size_t start, Get&& get){
+        ReaderResult r;
+        const Workload& w = *sh.workload;
+        for(std::size_t i = start; !sh.stop.load(std::memory_order_relaxed); i++){
+            const std::uint32_t k = w.ops[i % w.ops.size()].key;
+            const std::uint64_t floor = sh.published[k].load(std::memory_order_acquire);
+            const auto t0 = std::chrono::steady_clock::now();
+            const std::optional<Versioned> v = get(w.key_names[k]);
+            r.latency.record(static_cast<std::uint64_t>((std::chrono::steady_clock::now() - t0).count()));
+            r.gets++;
+            if(!v || v->version < floor) r.stale++;
+        }
+        return r;
+    }
+
+    // Changes random keys at the remote at the requested rate.
+    void write_loop(Shared& sh, Remote& remote, double per_sec, std::uint64_t& writes){
+        const Workload& w = *sh.workload;
+        const auto interval = std::chrono::duration<double>(per_sec > 0 ? 1.0 / per_sec : 1e9);
+        auto next = std::chrono::steady_clock::now();
+        for(std::size_t i = w.ops.size() / 2; !sh.stop.load(std::memory_order_relaxed); i++){
+            next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+            std::this_thread::sleep_until(next);
+            const std::uint32_t k = w.ops[i % w.ops.size()].key;
+            const std::uint64_t version = sh.published[k].load(std::memory_order_relaxed) + 1;
+            remote.put(w.key_names[k], Versioned{version, "v"});
+            sh.published[k].store(version, std::memory_order_release);
+            writes++;
+        }
+    }
+
+    template<typename MakeGet>
+    void run(const char* name, const Args& a, Shared& sh, Remote& remote, MakeGet&& make_get){
+        sh.stop = false;
+        const std::uint64_t remote_before = remote.reads();
+        std::vector<ReaderResult> results(static_cast<std::size_t>(a.readers));
+        std::vector<std::thread> threads;
+        for(int t = 0; t < a.readers; t++){
+            threads.emplace_back([&, t]{
+                auto get = make_get();
+                results[static_cast<std::size_t>(t)] = read_loop(sh, static_cast<std::size_t>(t) * 7919, get);
+                results[static_cast<std::size_t>(t)].near = get.stats();
+            });
+        }
+        std::uint64_t writes = 0;
+        std::thread writer([&]{ write_loop(sh, remote, a.writes_per_sec, writes); });
+        std::this_thread::sleep_for(std::chrono::duration<double>(a.seconds));
+        sh.stop = true;
+        for(auto& t : threads) t.join();
+        writer.join();
+
+        ReaderResult total;
+        for(const ReaderResult& r : results){
+            total.latency.merge(r.latency);
+            total.gets += r.gets;
+            total.stale += r.stale;
+            total.near.hits += r.near.hits;
+            total.near.not_cached += r.near.not_cached;
+            total.near.invalidations += r.near.invalidations;
+            total.near.resets += r.near.resets;
+        }
+        const double gets = static_cast<double>(std::max<std::uint64_t>(1, total.gets));
+        std::printf("%s: %.0f gets/s, %llu writes, %.3f remote reads per get, stale %llu\n", name, gets / a.seconds,
+                    static_cast<unsigned long long>(writes),
+                    static_cast<double>(remote.reads() - remote_before) / gets,
+                    static_cast<unsigned long long>(total.stale));
+        std::printf("  get ns: p50 %llu  p99 %llu  p99.9 %llu  max %llu\n",
+                    static_cast<unsigned long long>(total.latency.percentile(0.50)),
+                    static_cast<unsigned long long>(total.latency.percentile(0.99)),
+                    static_cast<unsigned long long>(total.latency.percentile(0.999)),
+                    static_cast<unsigned long long>(total.latency.max()));
+        if(total.near.hits || total.near.invalidations) {
+            std::printf("  local hits %.1f%%, invalidations applied %llu, raced reads not cached %llu, resets %llu\n",
+                        100.0 * static_cast<double>(total.near.hits) / gets,
+                        static_cast<unsigned long long>(total.near.invalidations),
+                        static_cast<unsigned long long>(total.near.not_cached),
+                        static_cast<unsigned long long>(total.near.resets));
+        }
+    }
+
+    // Direct remote access with the same interface as NearCache for run()
+    struct DirectGet {
+        Remote* remote;
+        std::optional<Versioned> operator()(const std::string& key){ return remote->get(key); }
+        NearStats stats() const { return {}; }
+    };
+
+    struct NearGet {
+        NearCache<Versioned, Remote>* near;
+        std::optional<Versioned> operator()(const std::string& key){ return near->get(key); }
+        NearStats stats() const { return near->stats(); }
+    };
+}
+
+int main(int argc, char** argv){
+    const Args a = parse_args(argc, argv);
+    WorkloadParams p;
+    p.universe = a.keys;
+    p.ops = 1'000'000;
+    const Workload w = zipf(p, a.skew);
+
+    Remote remote(std::chrono::nanoseconds(static_cast<std::int64_t>(a.round_trip_us * 1e3)));
+    Shared sh;
+    sh.workload = &w;
+    sh.published = std::make_unique<std::atomic<std::uint64_t>[]>(w.universe);
+    for(std::uint32_t k = 0; k < w.universe; k++){
+        remote.put(w.key_names[k], Versioned{0, "v"});
+        sh.published[k].store(0, std::memory_order_relaxed);
+    }
+    std::printf("zipf %.2f over %u keys, %d readers, %.0f us round trip, %.0f writes/s\n", a.skew, w.universe, a.readers,
+                a.round_trip_us, a.writes_per_sec);
+
+    run("remote only", a, sh, remote, [&]{ return DirectGet{&remote}; });
+
+    LocalCache<Versioned>::initialize(a.capacity, 0);
+    NearCache<Versioned, Remote> near(remote);
+    run("near cache", a, sh, remote, [&]{ return NearGet{&near}; });
+    return 0;
+}
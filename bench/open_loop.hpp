@@ -0,0 +1,188 @@
+#pragma once
+#include "engines.hpp"
+#include "histogram.hpp"
+#include "workloads.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// open_loop.hpp
+// Open-loop load generation: operations are issued on a fixed schedule that
+// does not wait for the cache, and latency is measured from each op's
+// *intended* start time.
+// -----------------------------------------------------------------------------
+// A closed loop (time op, next op) under-reports latency whenever the system
+// stalls: the ops that would have arrived during the stall are simply never
+// issued, so the stall shows up as one slow sample instead of many
+// ("coordinated omission"). Here each worker owns a precomputed arrival
+// schedule; if it falls behind it issues the overdue op immediately and the
+// time spent waiting counts toward that op's latency, as it would for a feed
+// handler whose packets keep arriving.
+//
+// Both views are recorded: `latency` (completion - intended start) and
+// `service` (completion - actual start). The gap between them is queueing.
+//
+// sweep() raises the offered rate geometrically and reports the knee: the
+// first rate at which the engine can no longer keep up (achieved rate falls
+// below the offered rate) or p99 latency blows up relative to light load.
+// -----------------------------------------------------------------------------
+
+namespace locallru::bench {
+
+    enum class Arrival { constant, poisson };
+
+    // Intended start times in ns from the start of the run.
+    inline std::vector<std::int64_t> arrival_schedule(double rate_per_sec, Arrival arrival,
+                                                      double seconds, std::uint64_t seed){
+        const auto n = static_cast<std::size_t>(rate_per_sec * seconds);
+        std::vector<std::int64_t> at;
+        at.reserve(n);
+        const double mean_gap_ns = 1e9 / rate_per_sec;
+        if(arrival == Arrival::constant){
+            for(std::size_t i = 0; i < n; i++) at.push_back(static_cast<std::int64_t>(static_cast<double>(i) * mean_gap_ns));
+        } else {
+            std::mt19937_64 rng(seed);
+            std::exponential_distribution<double> gap(1.0 / mean_gap_ns);
+            double t = 0.0;
+            for(std::size_t i = 0; i < n; i++){
+                at.push_back(static_cast<std::int64_t>(t));
+                t += gap(rng);
+            }
+        }
+        return at;
+    }
+
+    struct OpenLoopOptions {
+        double rate = 1e6;            // Offered ops/s across all workers
+        Arrival arrival = Arrival::poisson;
+        double seconds = 0.5;         // Schedule length per rate step
+        int workers = 1;
+        std::size_t capacity = 10'000;
+        std::uint64_t seed = 7;
+    };
+
+    struct OpenLoopResult {
+        double offered = 0.0;         // ops/s
+        double achieved = 0.0;        // ops/s, completions over elapsed time
+        LatencyHistogram latency;     // from intended start
+        LatencyHistogram service;     // from actual start
+    };
+
+    // Runs one fixed-rate step. Engines with `shared` are instantiated once
+    // and used by all workers; others get one instance per worker.
+    template<typename Engine>
+    OpenLoopResult run_open_loop(const Workload& w, const OpenLoopOptions& opt){
+        using K = typename Engine::key_type;
+        using V = typename Engine::value_type;
+        using SteadyClock = std::chrono::steady_clock;
+
+        const int workers = std::max(1, opt.workers);
+        std::vector<std::vector<std::int64_t>> schedules;
+        for(int t = 0; t < workers; t++){
+            schedules.push_back(arrival_schedule(opt.rate / workers, opt.arrival, opt.seconds, opt.seed + t));
+        }
+
+        std::unique_ptr<Engine> shared_engine;
+        if constexpr (Engine::shared) shared_engine = std::make_unique<Engine>(opt.capacity, 0);
+
+        std::vector<LatencyHistogram> latency(workers), service(workers);
+        std::vector<std::int64_t> finished_ns(workers, 0);
+        std::atomic<int> ready{0};
+        std::atomic<bool> go{false};
+        SteadyClock::time_point start;
+
+        auto worker = [&](int t){
+            std::unique_ptr<Engine> own;
+            if constexpr (!Engine::shared) own = std::make_unique<Engine>(opt.capacity / workers, 0);
+            Engine& e = Engine::shared ? *shared_engine : *own;
+
+            // Warm the cache so the run measures steady state, not cold misses.
+            const auto now = Clock::now();
+            const std::size_t warm = std::min(w.ops.size(), opt.capacity);
+            for(std::size_t i = 0; i < warm; i++) e.put(key_for<K>(w, w.ops[i].key), V{}, now);
+
+            ready.fetch_add(1);
+            while(!go.load(std::memory_order_acquire)) {}
+
+            const auto& at = schedules[t];
+            std::size_t op_index = (static_cast<std::size_t>(t) * 7919) % w.ops.size();
+            for(std::size_t i = 0; i < at.size(); i++){
+                const auto intended = start + std::chrono::nanoseconds(at[i]);
+                auto actual = SteadyClock::now();
+                while(actual < intended) actual = SteadyClock::now();
+
+                const Op& op = w.ops[op_index];
+                if(++op_index == w.ops.size()) op_index = 0;
+                decltype(auto) key = key_for<K>(w, op.key);
+                if(op.kind == OpKind::put || !e.get(key, actual)) e.put(key, V{}, actual);
+
+                const auto done = SteadyClock::now();
+                latency[t].record(static_cast<std::uint64_t>((done - intended).count()));
+                service[t].record(static_cast<std::uint64_t>((done - actual).count()));
+            }
+            finished_ns[t] = (SteadyClock::now() - start).count();
+        };
+
+        std::vector<std::thread> threads;
+        for(int t = 0; t < workers; t++) threads.emplace_back(worker, t);
+        while(ready.load() != workers) std::this_thread::yield();
+        start = SteadyClock::now() + std::chrono::milliseconds(1);
+        go.store(true, std::memory_order_release);
+        for(auto& th : threads) th.join();
+
+        OpenLoopResult r;
+        r.offered = opt.rate;
+        std::uint64_t ops = 0;
+        for(int t = 0; t < workers; t++){
+            r.latency.merge(latency[t]);
+            r.service.merge(service[t]);
+            ops += schedules[t].size();
+        }
+        const auto elapsed_ns = *std::max_element(finished_ns.begin(), finished_ns.end());
+        r.achieved = elapsed_ns > 0 ? static_cast<double>(ops) * 1e9 / static_cast<double>(elapsed_ns) : 0.0;
+        return r;
+    }
+
+    struct SweepOptions {
+        double min_rate = 100'000;
+        double max_rate = 50'000'000;
+        double step = 1.5;            // Geometric rate multiplier
+        double knee_p99_factor = 10.0; // p99 vs. lightest load
+        double min_achieved = 0.95;    // achieved / offered
+    };
+
+    struct SweepResult {
+        std::vector<OpenLoopResult> steps;
+        int knee = -1;                // Index into steps; -1 if never reached
+    };
+
+    // Steps the offered rate up until the knee, plus one step past it to
+    // confirm it. Each step reuses `base` with a different rate.
+    template<typename Engine, typename OnStep>
+    SweepResult sweep(const Workload& w, OpenLoopOptions base, const SweepOptions& s, OnStep&& on_step){
+        SweepResult result;
+        double baseline_p99 = 0.0;
+        for(double rate = s.min_rate; rate <= s.max_rate; rate *= s.step){
+            base.rate = rate;
+            result.steps.push_back(run_open_loop<Engine>(w, base));
+            const auto& r = result.steps.back();
+            const double p99 = static_cast<double>(r.latency.percentile(0.99));
+            if(result.steps.size() == 1) baseline_p99 = std::max(p99, 1.0);
+            const bool saturated = r.achieved < s.min_achieved * r.offered || p99 > s.knee_p99_factor * baseline_p99;
+            on_step(r, saturated);
+            // A single bad step can be a scheduling hiccup; the knee is only
+            // confirmed once the following step is saturated as well.
+            if(!saturated) result.knee = -1;
+            else if(result.knee >= 0) break;
+            else result.knee = static_cast<int>(result.steps.size() - 1);
+        }
+        return result;
+    }
+}
@@ -0,0 +1,180 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// -----------------------------------------------------------------------------
+// perf_counters.hpp
+// Hardware performance counters for the calling thread via perf_event_open.
+// -----------------------------------------------------------------------------
+// Events are opened in small groups (consecutive specs with the same
+// PerfEventSpec::group); the members of a group share the same
+// enabled/running time. Each group is scheduled onto the PMU all or nothing:
+// when other events compete for the counters the kernel rotates groups in
+// and out and read() scales each by its own running time, but a group
+// needing more counters than are free never runs at all (time_running stays
+// 0) and read() leaves its events out as not counted. Keeping groups small -
+// cycles with instructions, each miss event on its own - means one
+// oversized group cannot cost every count.
+//
+// Degradation is graceful at every level: events the CPU or hypervisor does
+// not expose are skipped individually, and if nothing can be opened (no PMU,
+// perf_event_paranoid too strict, seccomp, non-Linux) open() returns false
+// with a reason and the caller carries on reporting latency only.
+// Only user-space events are counted, which works with perf_event_paranoid
+// up to 2 without privileges.
+// -----------------------------------------------------------------------------
+
+namespace locallru::bench {
+
+    struct PerfEventSpec {
+        const char* name;
+        std::uint32_t type;
+        std::uint64_t config;
+        std::uint32_t group = 0;   // Consecutive specs with equal group share one
+    };
+
+    class PerfCounters {
+      public:
+        PerfCounters() = default;
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+        ~PerfCounters(){ close(); }
+
+        // cycles, instructions, L1d/LLC read misses, dTLB read misses and
+        // branch misses; the set reported next to latency. cycles and
+        // instructions form one group, so IPC compares like with like.
+        static std::vector<PerfEventSpec> default_events(){
+#if defined(__linux__)
+            auto cache = [](std::uint64_t id, std::uint64_t op, std::uint64_t result){
+                return id | (op << 8) | (result << 16);
+            };
+            return {
+                {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, 0},
+                {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, 0},
+                {"L1d_miss", PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS), 1},
+                {"LLC_miss", PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS), 2},
+                {"dTLB_miss", PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS), 3},
+                {"branch_miss", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, 4},
+            };
+#else
+            return {};
+#endif
+        }
+
+        // Opens the events for the calling thread, disabled. Returns true if
+        // at least one event is available.
+        bool open(const std::vector<PerfEventSpec>& specs = default_events()){
+            close();
+#if defined(__linux__)
+            int leader = -1;
+            std::uint32_t group = 0;
+            for(const auto& spec : specs){
+                if(spec.group != group) {
+                    group = spec.group;
+                    leader = -1;
+                }
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = spec.type;
+                attr.config = spec.config;
+                attr.disabled = leader == -1 ? 1 : 0;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                const int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+                if(fd < 0) {
+                    if(error_.empty()) error_ = std::string(spec.name) + ": " + std::strerror(errno);
+                    continue;
+                }
+                events_.push_back({spec.name, fd, leader == -1});
+                if(leader == -1) leader = fd;
+            }
+            if(events_.empty()) return false;
+            error_.clear();
+            return true;
+#else
+            (void)specs;
+            error_ = "perf_event_open is Linux-only";
+            return false;
+#endif
+        }
+
+        bool available() const { return !events_.empty(); }
+        const std::string& error() const { return error_; }
+
+        void reset(){ group_ioctl(reset_request()); }
+        void enable(){ group_ioctl(enable_request()); }
+        void disable(){ group_ioctl(disable_request()); }
+
+        // Current totals, each group scaled for multiplexing. Events of a
+        // group that never got scheduled onto the PMU are left out (not
+        // counted: no time ran to scale from), so the result is empty if
+        // no group ran.
+        std::vector<std::pair<std::string, double>> read() const {
+            std::vector<std::pair<std::string, double>> out;
+#if defined(__linux__)
+            std::vector<std::uint64_t> buf(3 + events_.size());
+            for(std::size_t first = 0; first < events_.size();){
+                std::size_t end = first + 1;
+                while(end < events_.size() && !events_[end].leader) end++;
+                const auto bytes = ::read(events_[first].fd, buf.data(), buf.size() * sizeof(std::uint64_t));
+                const std::uint64_t nr = bytes >= static_cast<ssize_t>(3 * sizeof(std::uint64_t)) ? buf[0] : 0;
+                const std::uint64_t enabled = buf[1], running = buf[2];
+                if(nr > 0 && running > 0) {
+                    const double scale = static_cast<double>(enabled) / static_cast<double>(running);
+                    for(std::size_t i = 0; i < nr && first + i < end; i++){
+                        out.emplace_back(events_[first + i].name, static_cast<double>(buf[3 + i]) * scale);
+                    }
+                }
+                first = end;
+            }
+#endif
+            return out;
+        }
+
+        void close(){
+#if defined(__linux__)
+            // Members first; a leader owns its group.
+            for(auto it = events_.rbegin(); it != events_.rend(); ++it) ::close(it->fd);
+#endif
+            events_.clear();
+        }
+
+      private:
+        struct Event {
+            std::string name;
+            int fd;
+            bool leader;
+        };
+
+#if defined(__linux__)
+        static unsigned long reset_request(){ return PERF_EVENT_IOC_RESET; }
+        static unsigned long enable_request(){ return PERF_EVENT_IOC_ENABLE; }
+        static unsigned long disable_request(){ return PERF_EVENT_IOC_DISABLE; }
+
+        void group_ioctl(unsigned long request){
+            for(const auto& e : events_) if(e.leader) ioctl(e.fd, request, PERF_IOC_FLAG_GROUP);
+        }
+#else
+        static unsigned long reset_request(){ return 0; }
+        static unsigned long enable_request(){ return 0; }
+        static unsigned long disable_request(){ return 0; }
+        void group_ioctl(unsigned long){}
+#endif
+
+        std::vector<Event> events_;
+        std::string error_;
+    };
+}
@@ -0,0 +1,225 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+// -----------------------------------------------------------------------------
+// report.hpp
+// Benchmark results and the machine-readable forms they are exported in.
+// -----------------------------------------------------------------------------
+// JSON layout (one file per run, consumed by scripts/compare_results.py):
+//
+//   { "context":    { "date", "host", "cpu", "num_cpus", "compiler",
+//                     "cxx_flags", "build_type", "git_revision" },
+//     "benchmarks": [ { "name", "run_name", "run_type", "aggregate",
+//                       "repetition", "iterations", "threads", "ns_per_op",
+//                       "items_per_second", "label", "error",
+//                       "counters": { ... } }, ... ] }
+//
+// run_name identifies a benchmark instance across files; every repetition
+// is a separate "iteration" row so comparisons can test the raw samples.
+// CSV carries the same rows with one column per counter name.
+//
+// Build flags are baked in by CMake via LOCALLRU_BENCH_CXX_FLAGS,
+// LOCALLRU_BENCH_BUILD_TYPE and LOCALLRU_GIT_REVISION.
+// -----------------------------------------------------------------------------
+
+#ifndef LOCALLRU_BENCH_CXX_FLAGS
+#define LOCALLRU_BENCH_CXX_FLAGS "unknown"
+#endif
+#ifndef LOCALLRU_BENCH_BUILD_TYPE
+#define LOCALLRU_BENCH_BUILD_TYPE "unknown"
+#endif
+#ifndef LOCALLRU_GIT_REVISION
+#define LOCALLRU_GIT_REVISION "unknown"
+#endif
+
+namespace locallru::bench {
+
+    // One timed execution of a benchmark instance, merged across threads.
+    struct RunResult {
+        std::string name;          // run_name plus "_mean" etc. for aggregates
+        std::string run_name;
+        std::string aggregate;     // empty for raw repetitions
+        int repetition = 0;
+        std::uint64_t iterations = 0;
+        int threads = 1;
+        double wall_ns = 0.0;      // Slowest thread's timed duration
+        double ns_per_op = 0.0;    // Mean over threads of elapsed / iterations
+        double items_per_second = 0.0;
+        std::string label;
+        std::string error;
+        std::map<std::string, double> counters;
+    };
+
+    struct Environment {
+        std::string date;
+        std::string host;
+        std::string cpu;
+        unsigned num_cpus = 0;
+        std::string compiler;
+        std::string cxx_flags;
+        std::string build_type;
+        std::string git_revision;
+    };
+
+    inline Environment collect_environment(){
+        Environment env;
+
+        const std::time_t t = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        char date[32];
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&t));
+        env.date = date;
+
+        char host[256] = {};
+        if(gethostname(host, sizeof(host) - 1) == 0) env.host = host;
+
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        while(std::getline(cpuinfo, line)){
+            if(line.rfind("model name", 0) == 0){
+                const auto colon = line.find(':');
+                if(colon != std::string::npos) env.cpu = line.substr(line.find_first_not_of(' ', colon + 1));
+                break;
+            }
+        }
+        if(env.cpu.empty()) env.cpu = "unknown";
+        env.num_cpus = std::thread::hardware_concurrency();
+
+#if defined(__clang__)
+        env.compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+        env.compiler = "gcc " __VERSION__;
+#else
+        env.compiler = "unknown";
+#endif
+        env.cxx_flags = LOCALLRU_BENCH_CXX_FLAGS;
+        env.build_type = LOCALLRU_BENCH_BUILD_TYPE;
+        env.git_revision = LOCALLRU_GIT_REVISION;
+        return env;
+    }
+
+    namespace detail {
+        inline std::string json_escape(const std::string& s){
+            std::string out;
+            out.reserve(s.size() + 2);
+            out += '"';
+            for(char c : s){
+                switch(c){
+                    case '"': out += "\\\""; break;
+                    case '\\': out += "\\\\"; break;
+                    case '\n': out += "\\n"; break;
+                    case '\t': out += "\\t"; break;
+                    default:
+                        if(static_cast<unsigned char>(c) < 0x20) {
+                            char buf[8];
+                            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                            out += buf;
+                        } else {
+                            out += c;
+                        }
+                }
+            }
+            out += '"';
+            return out;
+        }
+
+        inline std::string csv_escape(const std::string& s){
+            if(s.find_first_of(",\"\n") == std::string::npos) return s;
+            std::string out = "\"";
+            for(char c : s){
+                if(c == '"') out += '"';
+                out += c;
+            }
+            return out + '"';
+        }
+
+        inline std::string number(double v){
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.17g", v);
+            return buf;
+        }
+    }
+
+    inline bool write_json(const std::string& path, const Environment& env, const std::vector<RunResult>& results){
+        std::ofstream out(path);
+        if(!out) return false;
+        using detail::json_escape;
+        out << "{\n  \"context\": {\n"
+            << "    \"date\": " << json_escape(env.date) << ",\n"
+            << "    \"host\": " << json_escape(env.host) << ",\n"
+            << "    \"cpu\": " << json_escape(env.cpu) << ",\n"
+            << "    \"num_cpus\": " << env.num_cpus << ",\n"
+            << "    \"compiler\": " << json_escape(env.compiler) << ",\n"
+            << "    \"cxx_flags\": " << json_escape(env.cxx_flags) << ",\n"
+            << "    \"build_type\": " << json_escape(env.build_type) << ",\n"
+            << "    \"git_revision\": " << json_escape(env.git_revision) << "\n"
+            << "  },\n  \"benchmarks\": [";
+        for(std::size_t i = 0; i < results.size(); i++){
+            const auto& r = results[i];
+            out << (i ? ",\n" : "\n")
+                << "    {\"name\": " << json_escape(r.name)
+                << ", \"run_name\": " << json_escape(r.run_name)
+                << ", \"run_type\": " << (r.aggregate.empty() ? "\"iteration\"" : "\"aggregate\"")
+                << ", \"aggregate\": " << json_escape(r.aggregate)
+                << ", \"repetition\": " << r.repetition
+                << ", \"iterations\": " << r.iterations
+                << ", \"threads\": " << r.threads
+                << ", \"ns_per_op\": " << detail::number(r.ns_per_op)
+                << ", \"items_per_second\": " << detail::number(r.items_per_second)
+                << ", \"label\": " << json_escape(r.label)
+                << ", \"error\": " << json_escape(r.error)
+                << ", \"counters\": {";
+            bool first = true;
+            for(const auto& [k, v] : r.counters){
+                out << (first ? "" : ", ") << json_escape(k) << ": " << detail::number(v);
+                first = false;
+            }
+            out << "}}";
+        }
+        out << "\n  ]\n}\n";
+        return static_cast<bool>(out);
+    }
+
+    // Environment goes in leading "# key: value" comment lines.
+    inline bool write_csv(const std::string& path, const Environment& env, const std::vector<RunResult>& results){
+        std::ofstream out(path);
+        if(!out) return false;
+        out << "# date: " << env.date << "\n# host: " << env.host << "\n# cpu: " << env.cpu
+            << "\n# num_cpus: " << env.num_cpus << "\n# compiler: " << env.compiler
+            << "\n# cxx_flags: " << env.cxx_flags << "\n# build_type: " << env.build_type
+            << "\n# git_revision: " << env.git_revision << "\n";
+
+        std::set<std::string> counter_names;
+        for(const auto& r : results){
+            for(const auto& [k, v] : r.counters) counter_names.insert(k);
+        }
+        out << "name,run_name,run_type,aggregate,repetition,iterations,threads,ns_per_op,items_per_second,label,error";
+        for(const auto& c : counter_names) out << "," << detail::csv_escape(c);
+        out << "\n";
+        using detail::csv_escape;
+        for(const auto& r : results){
+            out << csv_escape(r.name) << "," << csv_escape(r.run_name) << ","
+                << (r.aggregate.empty() ? "iteration" : "aggregate") << "," << r.aggregate << ","
+                << r.repetition << "," << r.iterations << "," << r.threads << ","
+                << detail::number(r.ns_per_op) << "," << detail::number(r.items_per_second) << ","
+                << csv_escape(r.label) << "," << csv_escape(r.error);
+            for(const auto& c : counter_names){
+                out << ",";
+                auto it = r.counters.find(c);
+                if(it != r.counters.end()) out << detail::number(it->second);
+            }
+            out << "\n";
+        }
+        return static_cast<bool>(out);
+    }
+}
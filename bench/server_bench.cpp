@@ -0,0 +1,341 @@
+#include "../src/cache_server.hpp"
+#include "histogram.hpp"
+#include "workloads.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace locallru;
+using namespace locallru::bench;
+using namespace locallru::server;
+
+// -----------------------------------------------------------------------------
+// Load generator for the memcached-protocol cache server. Client threads
+// each drive several connections; every round sends a pipeline of --depth
+// requests on each connection with one send, then reads all responses.
+//
+//   locallru_server_bench [--address=IP] [--port=N] [--threads=N]
+//                         [--connections=N] [--depth=N] [--multiget=N]
+//                         [--seconds=S] [--keys=N] [--value-bytes=B]
+//                         [--read-ratio=F] [--skew=S]
+//                         [--server-threads=N] [--engine=shared|local]
+//                         [--backend=auto|posix|io_uring]
+//
+// Without --port an in-process server is started on a free port
+// (--server-threads, --engine, --backend); with it, an external server (e.g.
+// cache_server or memcached) is benchmarked. Keys are loaded first.
+// Reported: request throughput, hit ratio, and round-trip latency of a
+// pipeline (each request in it is recorded with the pipeline's time).
+// -----------------------------------------------------------------------------
+
+namespace {
+    struct Args {
+        std::string address = "127.0.0.1";
+        std::uint16_t port = 0;
+        int threads = 1;
+        int connections = 4;          // Per client thread
+        int depth = 16;               // Requests per pipeline
+        int multiget = 1;             // Keys per get
+        double seconds = 3.0;
+        std::uint32_t keys = 100'000;
+        std::size_t value_bytes = 64;
+        double read_ratio = 0.9;
+        double skew = 0.99;
+        int server_threads = 1;
+        std::string engine = "shared";
+        IoBackend backend = IoBackend::automatic;
+    };
+
+    Args parse_args(int argc, char** argv){
+        Args a;
+        for(int i = 1; i < argc; i++){
+            const char* arg = argv[i];
+            auto value = [&](const char* flag) -> const char* {
+                const std::size_t n = std::strlen(flag);
+                return std::strncmp(arg, flag, n) == 0 ? arg + n : nullptr;
+            };
+            if(auto v = value("--address=")) a.address = v;
+            else if(auto v = value("--port=")) a.port = static_cast<std::uint16_t>(std::atoi(v));
+            else if(auto v = value("--threads=")) a.threads = std::max(1, std::atoi(v));
+            else if(auto v = value("--connections=")) a.connections = std::max(1, std::atoi(v));
+            else if(auto v = value("--depth=")) a.depth = std::max(1, std::atoi(v));
+            else if(auto v = value("--multiget=")) a.multiget = std::max(1, std::atoi(v));
+            else if(auto v = value("--seconds=")) a.seconds = std::strtod(v, nullptr);
+            else if(auto v = value("--keys=")) a.keys = std::max(1u, static_cast<std::uint32_t>(std::strtoul(v, nullptr, 10)));
+            else if(auto v = value("--value-bytes=")) a.value_bytes = std::strtoull(v, nullptr, 10);
+            else if(auto v = value("--read-ratio=")) a.read_ratio = std::strtod(v, nullptr);
+            else if(auto v = value("--skew=")) a.skew = std::strtod(v, nullptr);
+            else if(auto v = value("--server-threads=")) a.server_threads = std::max(1, std::atoi(v));
+            else if(auto v = value("--engine=")) a.engine = v;
+            else if(auto v = value("--backend="); v && parse_io_backend(v, a.backend)) {}
+            else {
+                std::fprintf(stderr,
+                    "usage: %s [--address=IP] [--port=N] [--threads=N] [--connections=N] [--depth=N]\n"
+                    "          [--multiget=N] [--seconds=S] [--keys=N] [--value-bytes=B] [--read-ratio=F]\n"
+                    "          [--skew=S] [--server-threads=N] [--engine=shared|local]\n"
+                    "          [--backend=auto|posix|io_uring]\n", argv[0]);
+                std::exit(2);
+            }
+        }
+        return a;
+    }
+
+    // Blocking client connection that counts complete responses.
+    class Client {
+      public:
+        Client(const std::string& address, std::uint16_t port) : fd_(::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0)) {
+            if(fd_ < 0) throw std::system_error(errno, std::generic_category(), "socket");
+            sockaddr_in sa{};
+            sa.sin_family = AF_INET;
+            sa.sin_port = htons(port);
+            if(::inet_pton(AF_INET, address.c_str(), &sa.sin_addr) != 1) throw std::invalid_argument("not an IPv4 address: " + address);
+            if(::connect(fd_, reinterpret_cast<const sockaddr*>(&sa), sizeof(sa)) != 0) {
+                const int err = errno;
+                ::close(fd_);
+                throw std::system_error(err, std::generic_category(), "connect " + address);
+            }
+            const int one = 1;
+            ::setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+        Client(const Client&) = delete;
+        Client& operator=(const Client&) = delete;
+        ~Client(){ ::close(fd_); }
+
+        void send_all(std::string_view data){
+            while(!data.empty()){
+                const ssize_t n = ::send(fd_, data.data(), data.size(), MSG_NOSIGNAL);
+                if(n < 0) {
+                    if(errno == EINTR) continue;
+                    throw std::system_error(errno, std::generic_category(), "send");
+                }
+                data.remove_prefix(static_cast<std::size_t>(n));
+            }
+        }
+
+        // Reads until `responses` complete responses arrived; returns the
+        // VALUE blocks among them.
+        std::uint64_t receive(int responses){
+            std::uint64_t values = 0;
+            for(;;){
+                while(responses > 0){
+                    const std::size_t eol = buf_.find("\r\n", pos_);
+                    if(eol == std::string::npos) break;
+                    const std::string_view line(buf_.data() + pos_, eol - pos_);
+                    if(line.starts_with("VALUE ")) {
+                        // VALUE <key> <flags> <bytes> [<cas>]
+                        std::string_view rest = line.substr(6);
+                        for(int skip = 0; skip < 2; skip++) rest.remove_prefix(std::min(rest.size(), rest.find(' ') + 1));
+                        std::size_t bytes = 0;
+                        std::from_chars(rest.data(), rest.data() + rest.size(), bytes);
+                        if(buf_.size() < eol + 2 + bytes + 2) break;
+                        pos_ = eol + 2 + bytes + 2;
+                        values++;
+                        continue;
+                    }
+                    if(line.find("ERROR") != std::string_view::npos) errors_++;
+                    pos_ = eol + 2;
+                    responses--;
+                }
+                if(responses == 0) break;
+                buf_.erase(0, pos_);
+                pos_ = 0;
+                char chunk[64 << 10];
+                const ssize_t n = ::recv(fd_, chunk, sizeof(chunk), 0);
+                if(n < 0 && errno == EINTR) continue;
+                if(n <= 0) throw std::runtime_error("server closed the connection");
+                buf_.append(chunk, static_cast<std::size_t>(n));
+            }
+            return values;
+        }
+
+        std::uint64_t errors() const noexcept { return errors_; }
+
+      private:
+        int fd_;
+        std::string buf_;
+        std::size_t pos_ = 0;
+        std::uint64_t errors_ = 0;
+    };
+
+    void append_set(std::string& out, std::string_view key, std::string_view value){
+        out.append("set ").append(key).append(" 0 0 ").append(std::to_string(value.size())).append("\r\n");
+        out.append(value).append("\r\n");
+    }
+
+    struct ThreadResult {
+        LatencyHistogram latency;
+        std::uint64_t requests = 0;
+        std::uint64_t get_keys = 0;
+        std::uint64_t hits = 0;
+        std::uint64_t errors = 0;
+    };
+
+    ThreadResult run_client(const Args& a, std::uint16_t port, const Workload& w, std::size_t start){
+        std::vector<std::unique_ptr<Client>> conns;
+        for(int i = 0; i < a.connections; i++) conns.push_back(std::make_unique<Client>(a.address, port));
+        const std::string value(a.value_bytes, 'v');
+        std::vector<std::string> out(conns.size());
+        std::vector<std::uint64_t> gets(conns.size());
+        ThreadResult r;
+        std::size_t next = start;
+        auto next_op = [&]() -> const Op& { return w.ops[next++ % w.ops.size()]; };
+
+        const auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(a.seconds);
+        while(std::chrono::steady_clock::now() < end){
+            const auto t0 = std::chrono::steady_clock::now();
+            for(std::size_t c = 0; c < conns.size(); c++){
+                out[c].clear();
+                gets[c] = 0;
+                for(int d = 0; d < a.depth; d++){
+                    const Op& op = next_op();
+                    if(op.kind == OpKind::put) {
+                        append_set(out[c], w.key_names[op.key], value);
+                        continue;
+                    }
+                    out[c].append("get");
+                    out[c].append(" ").append(w.key_names[op.key]);
+                    for(int k = 1; k < a.multiget; k++) out[c].append(" ").append(w.key_names[next_op().key]);
+                    out[c].append("\r\n");
+                    gets[c] += static_cast<std::uint64_t>(a.multiget);
+                }
+                conns[c]->send_all(out[c]);
+            }
+            for(std::size_t c = 0; c < conns.size(); c++){
+                r.hits += conns[c]->receive(a.depth);
+                r.get_keys += gets[c];
+            }
+            const auto ns = static_cast<std::uint64_t>((std::chrono::steady_clock::now() - t0).count());
+            for(std::size_t i = 0; i < conns.size() * static_cast<std::size_t>(a.depth); i++) r.latency.record(ns);
+            r.requests += conns.size() * static_cast<std::size_t>(a.depth);
+        }
+        for(const auto& c : conns) r.errors += c->errors();
+        return r;
+    }
+
+    void preload(const Args& a, std::uint16_t port, const Workload& w){
+        Client c(a.address, port);
+        const std::string value(a.value_bytes, 'v');
+        std::string out;
+        constexpr int kBatch = 256;
+        for(std::uint32_t k = 0; k < w.universe; k += kBatch){
+            out.clear();
+            const std::uint32_t n = std::min<std::uint32_t>(kBatch, w.universe - k);
+            for(std::uint32_t i = 0; i < n; i++) append_set(out, w.key_names[k + i], value);
+            c.send_all(out);
+            c.receive(static_cast<int>(n));
+        }
+    }
+
+    template<typename Engine>
+    int run_bench(const Args& a, std::unique_ptr<CacheServer<Engine>> server){
+        std::thread server_thread;
+        std::uint16_t port = a.port;
+        if(server) {
+            port = server->port();
+            server_thread = std::thread([&]{ server->run(); });
+        }
+
+        WorkloadParams p;
+        p.ops = 1'000'000;
+        p.universe = a.keys;
+        p.read_ratio = a.read_ratio;
+        const Workload w = zipf(p, a.skew);
+
+        int status = 0;
+        try {
+            preload(a, port, w);
+            std::vector<ThreadResult> results(static_cast<std::size_t>(a.threads));
+            std::vector<std::thread> threads;
+            std::atomic<bool> failed{false};
+            for(int t = 0; t < a.threads; t++){
+                threads.emplace_back([&, t]{
+                    try {
+                        results[static_cast<std::size_t>(t)] = run_client(a, port, w, static_cast<std::size_t>(t) * (w.ops.size() / static_cast<std::size_t>(a.threads)));
+                    } catch(const std::exception& e) {
+                        std::fprintf(stderr, "client %d: %s\n", t, e.what());
+                        failed = true;
+                    }
+                });
+            }
+            for(auto& t : threads) t.join();
+
+            ThreadResult total;
+            for(const auto& r : results){
+                total.latency.merge(r.latency);
+                total.requests += r.requests;
+                total.get_keys += r.get_keys;
+                total.hits += r.hits;
+                total.errors += r.errors;
+            }
+            std::printf("%d client threads x %d connections, pipeline depth %d, %d keys per get, %zu B values\n",
+                        a.threads, a.connections, a.depth, a.multiget, a.value_bytes);
+            std::printf("  %.0f requests/s, %.0f get keys/s, hit ratio %.1f%%, errors %llu\n",
+                        static_cast<double>(total.requests) / a.seconds, static_cast<double>(total.get_keys) / a.seconds,
+                        total.get_keys ? 100.0 * static_cast<double>(total.hits) / static_cast<double>(total.get_keys) : 0.0,
+                        static_cast<unsigned long long>(total.errors));
+            std::printf("  pipeline round trip us: p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+                        static_cast<double>(total.latency.percentile(0.50)) / 1e3,
+                        static_cast<double>(total.latency.percentile(0.99)) / 1e3,
+                        static_cast<double>(total.latency.percentile(0.999)) / 1e3,
+                        static_cast<double>(total.latency.max()) / 1e3);
+            if(server) {
+                const ServerStats s = server->stats();
+                std::printf("  server (%s): %.1f requests per recv, %.1f per send, %.3f syscalls per request\n",
+                            to_string(server->backend()),
+                            static_cast<double>(s.requests) / static_cast<double>(std::max<std::uint64_t>(1, s.recv_calls)),
+                            static_cast<double>(s.requests) / static_cast<double>(std::max<std::uint64_t>(1, s.send_calls)),
+                            static_cast<double>(s.syscalls) / static_cast<double>(std::max<std::uint64_t>(1, s.requests)));
+            }
+            status = failed || total.errors ? 1 : 0;
+        } catch(const std::exception& e) {
+            std::fprintf(stderr, "Error: %s\n", e.what());
+            status = 1;
+        }
+        if(server) {
+            server->stop();
+            server_thread.join();
+        }
+        return status;
+    }
+}
+
+int main(int argc, char** argv){
+    const Args a = parse_args(argc, argv);
+    ServerOptions opt;
+    opt.address = a.address;
+    opt.port = 0;
+    opt.threads = a.server_threads;
+    opt.backend = a.backend;
+    try {
+        if(a.port != 0) return run_bench<SharedEngine>(a, nullptr);
+        if(a.engine == "local") {
+            // Each server thread has its own store; one client connection's
+            // keys all land in one of them
+            LocalCache<CacheItem>::initialize(a.keys, 0);
+            return run_bench(a, std::make_unique<CacheServer<LocalEngine>>(opt, LocalEngine{}));
+        }
+        SharedEngine::Store store(a.keys);
+        return run_bench(a, std::make_unique<CacheServer<SharedEngine>>(opt, SharedEngine(store)));
+    } catch(const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+}
@@ -0,0 +1,178 @@
+#include "../include/locallru/local_lru.hpp"
+#include "../include/locallru/snapshot.hpp"
+#include "../src/lock_cache.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace locallru;
+
+// -----------------------------------------------------------------------------
+// Warm restart cost: fills LocalCache stores on several threads (and one
+// LockCache), snapshots them to a file, then restores into fresh stores on
+// new threads, as a restarted process would.
+//
+//   locallru_snapshot_bench [--entries=N] [--threads=T] [--value-bytes=B]
+//                           [--ttl=S] [--path=FILE]
+//
+// Reported: snapshot (serialise + write) and restore (mmap + load) time,
+// file size, and a check that LRU order and values survived.
+// -----------------------------------------------------------------------------
+
+namespace {
+    struct Args {
+        std::size_t entries = 2'000'000;   // Total across threads
+        int threads = 4;
+        std::size_t value_bytes = 32;
+        std::uint64_t ttl = 300;
+        std::string path = "locallru_bench.snap";
+    };
+
+    Args parse_args(int argc, char** argv){
+        Args a;
+        for(int i = 1; i < argc; i++){
+            const char* arg = argv[i];
+            auto value = [&](const char* flag) -> const char* {
+                const std::size_t n = std::strlen(flag);
+                return std::strncmp(arg, flag, n) == 0 ? arg + n : nullptr;
+            };
+            if(auto v = value("--entries=")) a.entries = std::strtoull(v, nullptr, 10);
+            else if(auto v = value("--threads=")) a.threads = std::max(1, std::atoi(v));
+            else if(auto v = value("--value-bytes=")) a.value_bytes = std::strtoull(v, nullptr, 10);
+            else if(auto v = value("--ttl=")) a.ttl = std::strtoull(v, nullptr, 10);
+            else if(auto v = value("--path=")) a.path = v;
+            else {
+                std::fprintf(stderr,
+                    "usage: %s [--entries=N] [--threads=T] [--value-bytes=B] [--ttl=S] [--path=FILE]\n", argv[0]);
+                std::exit(2);
+            }
+        }
+        // The check in main evicts key 0, touches key 1, then expects key 2
+        // to go next and the last key to stay: 4 keys per thread at least
+        if(a.entries < 4 * static_cast<std::size_t>(a.threads)) {
+            std::fprintf(stderr, "%s: --entries must be at least 4 x --threads\n", argv[0]);
+            std::exit(2);
+        }
+        return a;
+    }
+
+    // Appended piecewise: "literal" + std::string&& trips GCC 12's -Wrestrict.
+    std::string key_of(int thread, std::size_t i){
+        const std::string t = std::to_string(thread);
+        const std::string n = std::to_string(i);
+        std::string k;
+        k.reserve(t.size() + n.size() + 3);
+        k.append("t").append(t).append(":k").append(n);
+        return k;
+    }
+
+    std::string value_of(std::size_t i, std::size_t bytes){
+        std::string v(bytes, 'v');
+        const std::string id = std::to_string(i);
+        std::memcpy(v.data(), id.data(), std::min(id.size(), v.size()));
+        return v;
+    }
+
+    double ms_since(std::chrono::steady_clock::time_point t0){
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    }
+
+    // Runs fn(i) on `threads` new threads and joins them.
+    template<typename F>
+    void on_threads(int threads, F&& fn){
+        std::vector<std::thread> ts;
+        for(int i = 0; i < threads; i++) ts.emplace_back([&fn, i]{ fn(i); });
+        for(auto& t : ts) t.join();
+    }
+}
+
+int main(int argc, char** argv){
+    const Args args = parse_args(argc, argv);
+    const std::size_t per_thread = args.entries / static_cast<std::size_t>(args.threads);
+    // One entry per thread more than the stores hold, so the oldest is evicted
+    auto cache = LocalCache<std::string>::initialize(per_thread - 1, args.ttl);
+    std::vector<SnapshotSection> sections(static_cast<std::size_t>(args.threads));
+
+    // Fill and snapshot; each thread's store dies with its thread. Key 0 is
+    // evicted by the last insert and key 1 is touched, so the LRU order is
+    // 2, 3, ..., per_thread - 1, 1.
+    std::vector<double> snapshot_ms(static_cast<std::size_t>(args.threads));
+    on_threads(args.threads, [&](int t){
+        for(std::size_t i = 0; i < per_thread; i++) cache.add_item(key_of(t, i), value_of(i, args.value_bytes));
+        cache.get_item(key_of(t, 1));
+        const auto s0 = std::chrono::steady_clock::now();
+        sections[static_cast<std::size_t>(t)] = snapshot(cache);
+        snapshot_ms[static_cast<std::size_t>(t)] = ms_since(s0);
+    });
+    double snapshot_max_ms = 0;
+    for(double ms : snapshot_ms) snapshot_max_ms = std::max(snapshot_max_ms, ms);
+
+    const auto w0 = std::chrono::steady_clock::now();
+    write_snapshot(args.path, sections);
+    const double write_ms = ms_since(w0);
+    const auto file_bytes = std::filesystem::file_size(args.path);
+    sections.clear();
+
+    // Restart: fresh threads have empty stores.
+    std::vector<std::size_t> loaded(static_cast<std::size_t>(args.threads));
+    std::vector<int> ok(static_cast<std::size_t>(args.threads));
+    const auto r0 = std::chrono::steady_clock::now();
+    Snapshot snap(args.path);
+    const double map_ms = ms_since(r0);
+    on_threads(args.threads, [&](int t){
+        loaded[static_cast<std::size_t>(t)] = restore(cache, snap.section(static_cast<std::size_t>(t)));
+    });
+    const double restore_ms = ms_since(r0);
+
+    // Verify on fresh threads' stores: restoring again is a warm restart of
+    // the same contents, then adding one entry must evict key 2.
+    on_threads(args.threads, [&](int t){
+        const std::size_t n = restore(cache, snap.section(static_cast<std::size_t>(t)));
+        bool good = n == per_thread - 1 && cache.size() == n && !cache.get_item(key_of(t, 0));
+        cache.add_item("extra", "x");
+        good = good && !cache.get_item(key_of(t, 2)) && cache.get_item(key_of(t, 1)) == value_of(1, args.value_bytes)
+                    && cache.get_item(key_of(t, per_thread - 1)) == value_of(per_thread - 1, args.value_bytes);
+        ok[static_cast<std::size_t>(t)] = good;
+    });
+
+    std::size_t total = 0;
+    bool all_ok = true;
+    for(int t = 0; t < args.threads; t++){
+        total += loaded[static_cast<std::size_t>(t)];
+        all_ok = all_ok && ok[static_cast<std::size_t>(t)];
+    }
+
+    // The shared cache: one section, loaded by one thread.
+    lockedlru::LockCache<std::string, std::string> shared(args.entries);
+    for(std::size_t i = 0; i < args.entries; i++) shared.put(key_of(0, i), value_of(i, args.value_bytes));
+    const auto ls0 = std::chrono::steady_clock::now();
+    SnapshotSection shared_section = snapshot(shared);
+    const double shared_snapshot_ms = ms_since(ls0);
+    lockedlru::LockCache<std::string, std::string> restarted(args.entries);
+    const auto lr0 = std::chrono::steady_clock::now();
+    const std::size_t shared_loaded = restore(restarted, shared_section);
+    const double shared_restore_ms = ms_since(lr0);
+
+    std::printf("LocalCache: %d threads x %zu entries (%zu B values, ttl %llu s)\n", args.threads, per_thread - 1,
+                args.value_bytes, static_cast<unsigned long long>(args.ttl));
+    std::printf("  snapshot          %8.1f ms  (slowest thread)\n", snapshot_max_ms);
+    std::printf("  write file        %8.1f ms  (%.1f MB, %.1f B/entry)\n", write_ms, static_cast<double>(file_bytes) / 1e6,
+                static_cast<double>(file_bytes) / static_cast<double>(total ? total : 1));
+    std::printf("  mmap              %8.1f ms\n", map_ms);
+    std::printf("  restore           %8.1f ms  (%zu entries, %.1f M entries/s) %s\n", restore_ms, total,
+                static_cast<double>(total) / restore_ms / 1e3, all_ok ? "verified" : "MISMATCH");
+    std::printf("LockCache: %zu entries\n", shared_loaded);
+    std::printf("  snapshot          %8.1f ms\n", shared_snapshot_ms);
+    std::printf("  restore           %8.1f ms  (%.1f M entries/s)\n", shared_restore_ms,
+                static_cast<double>(shared_loaded) / shared_restore_ms / 1e3);
+
+    std::filesystem::remove(args.path);
+    return all_ok && shared_loaded == args.entries ? 0 : 1;
+}
@@ -0,0 +1,203 @@
+#include "../include/locallru/local_lru.hpp"
+#include "../include/locallru/spill_tier.hpp"
+#include "histogram.hpp"
+#include "workloads.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace locallru;
+using namespace locallru::bench;
+
+// -----------------------------------------------------------------------------
+// Second tier payoff: replays a Zipf get/put stream with values too many to
+// keep in memory, against an LruStore alone and against a SpillStore whose
+// evictions go to disk. A miss is filled with a put, as a caller fetching
+// the value from a backend would.
+//
+//   locallru_spill_bench [--ops=N] [--universe=N] [--capacity=N]
+//                        [--value-bytes=B] [--skew=S] [--dir=PATH]
+//                        [--segment-mb=N] [--max-mb=N] [--batch=N]
+//                        [--io=auto|posix|io_uring]
+//
+// Reported: hit ratio per tier and get latency for memory hits, disk hits
+// and misses, plus disk usage and compaction counts. A last phase reads
+// every key left on disk once with get() and once with get_many() in
+// batches of --batch, reporting time and read syscalls per key.
+// -----------------------------------------------------------------------------
+
+namespace {
+    struct Args {
+        WorkloadParams workload;
+        std::size_t capacity = 10'000;
+        std::size_t value_bytes = 4096;
+        double skew = 0.99;
+        SpillOptions spill;
+        std::size_t batch = 32;
+    };
+
+    Args parse_args(int argc, char** argv){
+        Args a;
+        a.workload.ops = 500'000;
+        a.workload.universe = 100'000;
+        a.spill.directory = "locallru_spill";
+        for(int i = 1; i < argc; i++){
+            const char* arg = argv[i];
+            auto value = [&](const char* flag) -> const char* {
+                const std::size_t n = std::strlen(flag);
+                return std::strncmp(arg, flag, n) == 0 ? arg + n : nullptr;
+            };
+            if(auto v = value("--ops=")) a.workload.ops = std::strtoull(v, nullptr, 10);
+            else if(auto v = value("--universe=")) a.workload.universe = static_cast<std::uint32_t>(std::strtoul(v, nullptr, 10));
+            else if(auto v = value("--capacity=")) a.capacity = std::strtoull(v, nullptr, 10);
+            else if(auto v = value("--value-bytes=")) a.value_bytes = std::strtoull(v, nullptr, 10);
+            else if(auto v = value("--skew=")) a.skew = std::strtod(v, nullptr);
+            else if(auto v = value("--dir=")) a.spill.directory = v;
+            else if(auto v = value("--segment-mb=")) a.spill.segment_bytes = std::strtoull(v, nullptr, 10) << 20;
+            else if(auto v = value("--max-mb=")) a.spill.max_bytes = std::strtoull(v, nullptr, 10) << 20;
+            else if(auto v = value("--batch=")) a.batch = std::max<std::size_t>(1, std::strtoull(v, nullptr, 10));
+            else if(auto v = value("--io="); v && parse_io_backend(v, a.spill.io)) {}
+            else {
+                std::fprintf(stderr,
+                    "usage: %s [--ops=N] [--universe=N] [--capacity=N] [--value-bytes=B] [--skew=S]\n"
+                    "          [--dir=PATH] [--segment-mb=N] [--max-mb=N] [--batch=N]\n"
+                    "          [--io=auto|posix|io_uring]\n", argv[0]);
+                std::exit(2);
+            }
+        }
+        return a;
+    }
+
+    struct Result {
+        LatencyHistogram memory_hit;
+        LatencyHistogram disk_hit;
+        LatencyHistogram miss;
+        double seconds = 0.0;
+    };
+
+    std::string value_of(std::uint32_t key, std::size_t bytes){
+        std::string v(bytes, 'v');
+        const std::string id = std::to_string(key);
+        std::memcpy(v.data(), id.data(), std::min(id.size(), v.size()));
+        return v;
+    }
+
+    // on_disk(key) tells, before the get, whether a hit would come from disk.
+    template<typename Store, typename OnDisk>
+    Result run(Store& store, const Workload& w, std::size_t value_bytes, OnDisk&& on_disk){
+        Result r;
+        const auto start = std::chrono::steady_clock::now();
+        for(const Op& op : w.ops){
+            const std::string& key = w.key_names[op.key];
+            if(op.kind == OpKind::put) {
+                store.put(key, value_of(op.key, value_bytes));
+                continue;
+            }
+            const bool disk = on_disk(key);
+            const auto t0 = std::chrono::steady_clock::now();
+            const bool hit = store.get(key).has_value();
+            const auto ns = static_cast<std::uint64_t>((std::chrono::steady_clock::now() - t0).count());
+            (!hit ? r.miss : disk ? r.disk_hit : r.memory_hit).record(ns);
+            if(!hit) store.put(key, value_of(op.key, value_bytes));
+        }
+        r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return r;
+    }
+
+    void print(const char* name, const Result& r){
+        const double gets = static_cast<double>(r.memory_hit.count() + r.disk_hit.count() + r.miss.count());
+        std::printf("%s: %.2f s, hit ratio memory %.1f%% disk %.1f%% miss %.1f%%\n", name, r.seconds,
+                    100.0 * static_cast<double>(r.memory_hit.count()) / gets,
+                    100.0 * static_cast<double>(r.disk_hit.count()) / gets, 100.0 * static_cast<double>(r.miss.count()) / gets);
+        auto row = [](const char* what, const LatencyHistogram& h){
+            if(!h.count()) return;
+            std::printf("  %-12s %9llu %9llu %9llu %11llu\n", what, static_cast<unsigned long long>(h.percentile(0.50)),
+                        static_cast<unsigned long long>(h.percentile(0.99)),
+                        static_cast<unsigned long long>(h.percentile(0.999)), static_cast<unsigned long long>(h.max()));
+        };
+        std::printf("  %-12s %9s %9s %9s %11s\n", "get", "p50 ns", "p99 ns", "p99.9 ns", "max ns");
+        row("memory hit", r.memory_hit);
+        row("disk hit", r.disk_hit);
+        row("miss", r.miss);
+    }
+
+    // Reads each key in keys from the spill file, one get() at a time and
+    // then get_many() batch at a time.
+    template<typename File>
+    void read_phase(File& file, const std::vector<std::string>& keys, std::size_t batch){
+        if(keys.empty()) return;
+        const auto now = Clock::now();
+        std::size_t found = 0;
+        auto report = [&](const char* what, auto&& body){
+            found = 0;
+            const std::uint64_t reads = file.stats().reads;
+            const auto t0 = std::chrono::steady_clock::now();
+            body();
+            const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+            const double n = static_cast<double>(keys.size());
+            std::printf("  %-22s %8.0f ns/key %8.3f reads/key  (%zu of %zu found)\n", what, ns / n,
+                        static_cast<double>(file.stats().reads - reads) / n, found, keys.size());
+        };
+        std::printf("disk reads of %zu keys (%s):\n", keys.size(), to_string(file.io_backend()));
+        report("get", [&]{
+            for(const std::string& k : keys) found += file.get(k, now).has_value();
+        });
+        char name[32];
+        std::snprintf(name, sizeof(name), "get_many batch %zu", batch);
+        report(name, [&]{
+            std::vector<std::string> chunk;
+            for(std::size_t i = 0; i < keys.size(); i += batch){
+                chunk.assign(keys.begin() + static_cast<std::ptrdiff_t>(i),
+                             keys.begin() + static_cast<std::ptrdiff_t>(std::min(keys.size(), i + batch)));
+                for(const auto& v : file.get_many(chunk, now)) found += v.has_value();
+            }
+        });
+    }
+}
+
+int main(int argc, char** argv){
+    const Args args = parse_args(argc, argv);
+    const Workload w = zipf(args.workload, args.skew);
+    std::printf("zipf %.2f: %zu ops over %u keys, memory capacity %zu, %zu B values\n", args.skew, w.ops.size(),
+                w.universe, args.capacity, args.value_bytes);
+
+    LruStore<std::string, std::string> memory(args.capacity, 0);
+    print("LruStore", run(memory, w, args.value_bytes, [](const std::string&){ return false; }));
+
+    // Spill into a fresh directory under --dir and remove only that one:
+    // --dir may be a mount point holding unrelated files.
+    std::filesystem::create_directories(args.spill.directory);
+    std::string scratch = (std::filesystem::path(args.spill.directory) / "spill_bench-XXXXXX").string();
+    if(!::mkdtemp(scratch.data())) {
+        std::fprintf(stderr, "mkdtemp %s: %s\n", scratch.c_str(), std::strerror(errno));
+        return 1;
+    }
+    SpillOptions spill = args.spill;
+    spill.directory = scratch;
+    {
+        SpillStore<std::string, std::string> tiered(args.capacity, 0, spill);
+        print("SpillStore", run(tiered, w, args.value_bytes, [&](const std::string& key){ return tiered.spill().contains(key); }));
+        const SpillStats& s = tiered.spill().stats();
+        std::printf("  disk: %.1f MB in %zu segments (%.0f%% live), %llu writes, %.1f MB written, %.1f MB read, "
+                    "%llu compactions, %llu dropped\n",
+                    static_cast<double>(tiered.spill().file_bytes()) / 1e6, tiered.spill().segments(),
+                    100.0 * static_cast<double>(tiered.spill().live_bytes()) / static_cast<double>(std::max<std::uint64_t>(1, tiered.spill().file_bytes())),
+                    static_cast<unsigned long long>(s.writes), static_cast<double>(s.bytes_written) / 1e6,
+                    static_cast<double>(s.bytes_read) / 1e6, static_cast<unsigned long long>(s.compactions),
+                    static_cast<unsigned long long>(s.dropped));
+        tiered.spill().flush();
+        std::vector<std::string> on_disk;
+        for(const std::string& k : w.key_names) if(tiered.spill().contains(k)) on_disk.push_back(k);
+        read_phase(tiered.spill(), on_disk, args.batch);
+        tiered.clear();
+    }
+    std::filesystem::remove_all(scratch);
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include "engines.hpp"
+#include "workloads.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace locallru::bench;
+
+// Replays every standard workload against every engine and prints hit ratio
+// and mean cost per operation. Unlike trading_demo, most of these workloads
+// do not fit in the cache, so eviction and miss paths dominate.
+
+namespace {
+    struct Args {
+        WorkloadParams params;
+        std::vector<std::size_t> capacities{1'000, 10'000, 50'000};
+    };
+
+    Args parse_args(int argc, char** argv){
+        Args a;
+        for(int i = 1; i < argc; i++){
+            const char* arg = argv[i];
+            auto value = [&](const char* flag) -> const char* {
+                const std::size_t n = std::strlen(flag);
+                return std::strncmp(arg, flag, n) == 0 ? arg + n : nullptr;
+            };
+            if(auto v = value("--ops=")) a.params.ops = std::strtoull(v, nullptr, 10);
+            else if(auto v = value("--universe=")) a.params.universe = static_cast<std::uint32_t>(std::strtoul(v, nullptr, 10));
+            else if(auto v = value("--read-ratio=")) a.params.read_ratio = std::strtod(v, nullptr);
+            else if(auto v = value("--seed=")) a.params.seed = std::strtoull(v, nullptr, 10);
+            else if(auto v = value("--capacity=")) a.capacities = {std::strtoull(v, nullptr, 10)};
+            else {
+                std::fprintf(stderr, "usage: %s [--ops=N] [--universe=N] [--read-ratio=F] [--seed=N] [--capacity=N]\n", argv[0]);
+                std::exit(2);
+            }
+        }
+        return a;
+    }
+
+    void print(const WorkloadResult& r){
+        if(r.skipped){
+            std::printf("%-14s %-18s %9zu %9s %10s\n", r.workload.c_str(), r.engine.c_str(), r.capacity, "-", "n/a");
+            return;
+        }
+        std::printf("%-14s %-18s %9zu %8.2f%% %10.1f\n", r.workload.c_str(), r.engine.c_str(), r.capacity,
+                    100.0 * r.hit_ratio(), r.ns_per_op());
+    }
+}
+
+int main(int argc, char** argv){
+    const Args args = parse_args(argc, argv);
+    const auto workloads = standard_workloads(args.params);
+
+    std::printf("%-14s %-18s %9s %9s %10s\n", "workload", "engine", "capacity", "hit", "ns/op");
+    for(const auto& w : workloads){
+        for(auto capacity : args.capacities){
+            ReplayOptions opt;
+            opt.capacity = capacity;
+            print(run_workload<LruStoreEngine<std::uint64_t, double>>(w, opt));
+            print(run_workload<LruStoreEngine<std::string, double>>(w, opt));
+            print(run_workload<LocalCacheEngine<double>>(w, opt));
+            print(run_workload<LockCacheEngine<std::string, double>>(w, opt));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,234 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// workloads.hpp
+// Synthetic key-access patterns for exercising the cache engines.
+// -----------------------------------------------------------------------------
+// Every generator produces a fully precomputed Workload: a flat vector of Ops
+// plus the key universe rendered as strings once up front. Replaying a
+// workload is therefore a linear scan with no RNG, no formatting and no
+// allocation in the measured path.
+//
+// Keys are dense ids in [0, universe). Engines keyed by std::string use
+// Workload::key_names[id]; integer-keyed engines use the id directly.
+// Every generator throws std::invalid_argument if universe is 0.
+//
+// Available shapes:
+// - uniform:       every key equally likely
+// - zipf:          rank-frequency skew s (s = 0 is uniform, s ~ 1 is "web")
+// - scan:          sequential sweeps over a range, the classic LRU killer
+// - hotspot_shift: a small hot set that relocates every phase
+// - diurnal:       working set that breathes sinusoidally, with bursts of
+//                  never-before-seen keys at the peaks
+// - mixed_ttl:     zipf keys tagged with one of several TTL classes
+// -----------------------------------------------------------------------------
+
+namespace locallru::bench {
+
+    enum class OpKind : std::uint8_t { get, put };
+
+    struct Op {
+        std::uint32_t key;
+        OpKind kind;
+        std::uint8_t ttl_class; // Index into Workload::ttl_seconds
+    };
+
+    struct Workload {
+        std::string name;
+        std::uint32_t universe = 0;
+        std::vector<Op> ops;
+        std::vector<std::string> key_names;
+        std::vector<std::uint64_t> ttl_seconds{0}; // One entry per TTL class
+    };
+
+    struct WorkloadParams {
+        std::size_t ops = 1'000'000;
+        std::uint32_t universe = 100'000;
+        double read_ratio = 0.9;     // Fraction of Ops that are gets
+        std::uint64_t seed = 42;
+    };
+
+    // Key names are padded to a realistic length so string hashing and
+    // comparison costs resemble "SYMBOL:VENUE:FIELD"-style keys.
+    inline std::string key_name(std::uint64_t id){
+        std::string s = "key:" + std::to_string(id);
+        if(s.size() < 16) s.append(16 - s.size(), '_');
+        return s;
+    }
+
+    namespace detail {
+        inline std::vector<std::string> make_key_names(std::uint32_t universe){
+            std::vector<std::string> names;
+            names.reserve(universe);
+            for(std::uint32_t i = 0; i < universe; i++) names.push_back(key_name(i));
+            return names;
+        }
+
+        inline Workload make_workload(std::string name, const WorkloadParams& p){
+            if(p.universe == 0) throw std::invalid_argument("workload " + name + ": universe must be > 0");
+            Workload w;
+            w.name = std::move(name);
+            w.universe = p.universe;
+            w.ops.reserve(p.ops);
+            return w;
+        }
+
+        // Fills in op kinds and key names once the key sequence is known.
+        inline void finish(Workload& w, const WorkloadParams& p, std::mt19937_64& rng){
+            std::bernoulli_distribution is_read(p.read_ratio);
+            for(auto& op : w.ops) {
+                op.kind = is_read(rng) ? OpKind::get : OpKind::put;
+            }
+            w.key_names = make_key_names(w.universe);
+        }
+    }
+
+    // Zipf sampler over ranks [0, n) with exponent s, by inverse CDF.
+    // The CDF table costs 8 bytes per key but makes each draw a single
+    // binary search, which is irrelevant anyway since streams are precomputed.
+    class ZipfDistribution {
+      public:
+        ZipfDistribution(std::uint32_t n, double s) : cdf_(n) {
+            if(n == 0) throw std::invalid_argument("ZipfDistribution: n must be > 0");
+            double sum = 0.0;
+            for(std::uint32_t i = 0; i < n; i++){
+                sum += 1.0 / std::pow(static_cast<double>(i + 1), s);
+                cdf_[i] = sum;
+            }
+            for(auto& c : cdf_) c /= sum;
+        }
+
+        template<typename Rng>
+        std::uint32_t operator()(Rng& rng) const {
+            const double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+            auto it = std::lower_bound(cdf_.begin(), cdf_.end(), u);
+            if(it == cdf_.end()) --it;
+            return static_cast<std::uint32_t>(it - cdf_.begin());
+        }
+
+      private:
+        std::vector<double> cdf_;
+    };
+
+    // Ranks are scattered over the id space with a fixed odd multiplier so
+    // the hottest keys are not also the numerically smallest ones.
+    inline std::uint32_t scatter(std::uint32_t rank, std::uint32_t universe){
+        return static_cast<std::uint32_t>((static_cast<std::uint64_t>(rank) * 2654435761ULL) % universe);
+    }
+
+    inline Workload uniform(const WorkloadParams& p){
+        auto w = detail::make_workload("uniform", p);
+        std::mt19937_64 rng(p.seed);
+        std::uniform_int_distribution<std::uint32_t> dist(0, p.universe - 1);
+        for(std::size_t i = 0; i < p.ops; i++) w.ops.push_back({dist(rng), OpKind::get, 0});
+        detail::finish(w, p, rng);
+        return w;
+    }
+
+    inline Workload zipf(const WorkloadParams& p, double skew){
+        auto w = detail::make_workload("zipf_" + std::to_string(skew).substr(0, 4), p);
+        std::mt19937_64 rng(p.seed);
+        ZipfDistribution dist(p.universe, skew);
+        for(std::size_t i = 0; i < p.ops; i++){
+            w.ops.push_back({scatter(dist(rng), p.universe), OpKind::get, 0});
+        }
+        detail::finish(w, p, rng);
+        return w;
+    }
+
+    // Repeated sequential sweeps over [0, scan_length). Once scan_length
+    // exceeds the cache capacity a pure LRU store never hits.
+    inline Workload scan(const WorkloadParams& p, std::uint32_t scan_length){
+        auto w = detail::make_workload("scan", p);
+        std::mt19937_64 rng(p.seed);
+        const std::uint32_t len = std::max<std::uint32_t>(1, std::min(scan_length, p.universe));
+        for(std::size_t i = 0; i < p.ops; i++){
+            w.ops.push_back({static_cast<std::uint32_t>(i % len), OpKind::get, 0});
+        }
+        detail::finish(w, p, rng);
+        return w;
+    }
+
+    // hot_fraction of ops go to a hot set of hot_keys consecutive ids whose
+    // base jumps to a random location every phase_ops operations.
+    inline Workload hotspot_shift(const WorkloadParams& p, std::uint32_t hot_keys,
+                                  double hot_fraction, std::size_t phase_ops){
+        auto w = detail::make_workload("hotspot_shift", p);
+        std::mt19937_64 rng(p.seed);
+        hot_keys = std::max<std::uint32_t>(1, std::min(hot_keys, p.universe));
+        std::uniform_int_distribution<std::uint32_t> any(0, p.universe - 1);
+        std::uniform_int_distribution<std::uint32_t> in_hot(0, hot_keys - 1);
+        std::bernoulli_distribution is_hot(hot_fraction);
+        std::uint32_t base = 0;
+        for(std::size_t i = 0; i < p.ops; i++){
+            if(phase_ops != 0 && i % phase_ops == 0) base = any(rng);
+            const std::uint32_t key = is_hot(rng) ? (base + in_hot(rng)) % p.universe : any(rng);
+            w.ops.push_back({key, OpKind::get, 0});
+        }
+        detail::finish(w, p, rng);
+        return w;
+    }
+
+    // The active working set oscillates between min_keys and the full
+    // universe over period_ops. Near each peak, burst_fraction of ops touch
+    // keys from a disjoint region that is otherwise never accessed.
+    inline Workload diurnal(const WorkloadParams& p, std::uint32_t min_keys,
+                            std::size_t period_ops, double burst_fraction){
+        auto w = detail::make_workload("diurnal", p);
+        std::mt19937_64 rng(p.seed);
+        // Top quarter of the id space is reserved for burst traffic; below
+        // 4 keys there is none and the workload has no bursts.
+        const std::uint32_t steady = std::max<std::uint32_t>(1, p.universe - p.universe / 4);
+        const std::uint32_t burst_keys = p.universe - steady;
+        min_keys = std::max<std::uint32_t>(1, std::min(min_keys, steady));
+        std::uniform_real_distribution<double> u01(0.0, 1.0);
+        const double two_pi = 6.283185307179586;
+        for(std::size_t i = 0; i < p.ops; i++){
+            const double phase = period_ops ? static_cast<double>(i % period_ops) / static_cast<double>(period_ops) : 0.0;
+            const double level = 0.5 - 0.5 * std::cos(two_pi * phase); // 0 at trough, 1 at peak
+            const auto active = static_cast<std::uint32_t>(min_keys + level * (steady - min_keys));
+            std::uint32_t key;
+            if(burst_keys > 0 && level > 0.9 && u01(rng) < burst_fraction){
+                key = steady + static_cast<std::uint32_t>(u01(rng) * burst_keys) % burst_keys;
+            } else {
+                key = static_cast<std::uint32_t>(u01(rng) * active) % std::max<std::uint32_t>(1, active);
+            }
+            w.ops.push_back({key, OpKind::get, 0});
+        }
+        detail::finish(w, p, rng);
+        return w;
+    }
+
+    // Zipf keys, each statically assigned one of ttl_seconds.size() classes.
+    // Engines with a single store-wide TTL replay this with one store per class.
+    inline Workload mixed_ttl(const WorkloadParams& p, double skew, std::vector<std::uint64_t> ttl_seconds){
+        auto w = zipf(p, skew);
+        w.name = "mixed_ttl";
+        if(ttl_seconds.empty()) ttl_seconds.push_back(0);
+        const auto classes = static_cast<std::uint32_t>(ttl_seconds.size());
+        for(auto& op : w.ops) op.ttl_class = static_cast<std::uint8_t>(op.key % classes);
+        w.ttl_seconds = std::move(ttl_seconds);
+        return w;
+    }
+
+    // The standard set replayed by the workload benchmark.
+    inline std::vector<Workload> standard_workloads(const WorkloadParams& p){
+        std::vector<Workload> all;
+        all.push_back(uniform(p));
+        all.push_back(zipf(p, 0.8));
+        all.push_back(zipf(p, 0.99));
+        all.push_back(zipf(p, 1.2));
+        all.push_back(scan(p, p.universe / 2));
+        all.push_back(hotspot_shift(p, p.universe / 100, 0.9, p.ops / 10));
+        all.push_back(diurnal(p, p.universe / 50, p.ops / 4, 0.3));
+        all.push_back(mixed_ttl(p, 0.99, {0, 1, 60}));
+        return all;
+    }
+}
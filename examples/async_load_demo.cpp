@@ -0,0 +1,279 @@
+#include "../include/locallru/local_lru.hpp"
+#include "../src/lock_cache.hpp"
+#include "../bench/histogram.hpp"
+#include "../bench/workloads.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace locallru;
+using locallru::bench::LatencyHistogram;
+
+// Coroutine read-through in a non-blocking service. Requests for Zipf keys
+// arrive on one event-loop thread; each is a coroutine doing
+//
+//   auto v = co_await cache.get_or_load(key, loader);
+//
+// where the loader starts a backend fetch that completes --backend-ms later
+// on the same loop. The thread never blocks on a fetch, and misses for a key
+// already being fetched wait for that fetch instead of starting another.
+// A second run does the same against a LockCache whose fetches complete on
+// a separate backend thread.
+//
+//   ./async_load_demo [--requests=N] [--keys=N] [--skew=S]
+//                     [--interarrival-us=U] [--backend-ms=M]
+
+struct Options {
+    std::size_t requests = 20000;
+    std::uint32_t keys = 5000;
+    double skew = 0.99;
+    double interarrival_us = 20.0;
+    double backend_ms = 2.0;
+};
+
+static Options parse_args(int argc, char** argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (std::strncmp(arg, "--requests=", 11) == 0) o.requests = std::strtoull(arg + 11, nullptr, 10);
+        else if (std::strncmp(arg, "--keys=", 7) == 0) o.keys = static_cast<std::uint32_t>(std::strtoul(arg + 7, nullptr, 10));
+        else if (std::strncmp(arg, "--skew=", 7) == 0) o.skew = std::strtod(arg + 7, nullptr);
+        else if (std::strncmp(arg, "--interarrival-us=", 18) == 0) o.interarrival_us = std::strtod(arg + 18, nullptr);
+        else if (std::strncmp(arg, "--backend-ms=", 13) == 0) o.backend_ms = std::strtod(arg + 13, nullptr);
+        else {
+            std::fprintf(stderr,
+                         "usage: %s [--requests=N] [--keys=N] [--skew=S] [--interarrival-us=U] [--backend-ms=M]\n",
+                         argv[0]);
+            std::exit(2);
+        }
+    }
+    return o;
+}
+
+// Fire-and-forget coroutine: starts at once, frees itself when done.
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// Single-threaded timer loop: run() executes callbacks in due order,
+// sleeping in between, until none are left.
+class EventLoop {
+public:
+    using Time = std::chrono::steady_clock::time_point;
+
+    void at(Time when, std::function<void()> fn) { timers_.push(Timer{when, seq_++, std::move(fn)}); }
+
+    void run() {
+        while (!timers_.empty()) {
+            Timer t = timers_.top();
+            timers_.pop();
+            std::this_thread::sleep_until(t.when);
+            t.fn();
+        }
+    }
+
+private:
+    struct Timer {
+        Time when;
+        std::uint64_t seq;
+        std::function<void()> fn;
+        bool operator>(const Timer& o) const { return when != o.when ? when > o.when : seq > o.seq; }
+    };
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<>> timers_;
+    std::uint64_t seq_ = 0;
+};
+
+struct Tally {
+    LatencyHistogram latency;
+    std::uint64_t hits = 0;
+    std::uint64_t fetches = 0;
+    std::size_t in_flight = 0;
+    std::size_t max_in_flight = 0;
+};
+
+static std::string fetched_value(const std::string& key) {
+    return "value of " + key;
+}
+
+static Detached serve_local(EventLoop& loop, Tally& tally, const std::string& key, double backend_ms) {
+    const auto arrived = std::chrono::steady_clock::now();
+    tally.in_flight++;
+    tally.max_in_flight = std::max(tally.max_in_flight, tally.in_flight);
+    bool hit = true;
+    auto cache = LocalCache<std::string>{};
+    auto v = co_await cache.get_or_load(key, [&](const std::string& k, LoadCallback<std::string> done) {
+        hit = false;
+        tally.fetches++;
+        const auto due = std::chrono::steady_clock::now() +
+                         std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                             std::chrono::duration<double, std::milli>(backend_ms));
+        loop.at(due, [done, k] { done(fetched_value(k)); });
+    });
+    if (!v || *v != fetched_value(key)) std::terminate();
+    tally.hits += hit;
+    tally.latency.record(static_cast<std::uint64_t>((std::chrono::steady_clock::now() - arrived).count()));
+    tally.in_flight--;
+}
+
+static void report(const char* name, const Tally& t, std::size_t requests, std::uint64_t loads, std::uint64_t joined,
+                   double seconds) {
+    std::printf("%s: %zu requests in %.2f s\n", name, requests, seconds);
+    std::printf("  hits %llu, backend fetches %llu, misses joined to a fetch in flight %llu, max requests in flight %zu\n",
+                static_cast<unsigned long long>(t.hits), static_cast<unsigned long long>(loads),
+                static_cast<unsigned long long>(joined), t.max_in_flight);
+    std::printf("  latency us: p50 %.1f  p99 %.1f  max %.1f\n", static_cast<double>(t.latency.percentile(0.50)) / 1e3,
+                static_cast<double>(t.latency.percentile(0.99)) / 1e3, static_cast<double>(t.latency.max()) / 1e3);
+}
+
+static void run_local(const Options& o, const bench::Workload& w) {
+    LocalCache<std::string>::initialize(o.keys, 0);
+    EventLoop loop;
+    Tally tally;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < o.requests; i++) {
+        const auto when = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                      std::chrono::duration<double, std::micro>(o.interarrival_us * static_cast<double>(i)));
+        const std::string& key = w.key_names[w.ops[i % w.ops.size()].key];
+        loop.at(when, [&loop, &tally, &key, &o] { serve_local(loop, tally, key, o.backend_ms); });
+    }
+    loop.run();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const auto& loads = LocalCache<std::string>{}.pending_loads();
+    if (loads.loads() != tally.fetches) std::terminate();
+    report("LocalCache on one event-loop thread", tally, o.requests, loads.loads(), loads.joined(), seconds);
+}
+
+// Backend thread: completes each fetch backend_ms after it was queued.
+class Backend {
+public:
+    explicit Backend(double backend_ms) : delay_(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                              std::chrono::duration<double, std::milli>(backend_ms))) {
+        thread_ = std::thread([this] { run(); });
+    }
+
+    ~Backend() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        thread_.join();
+    }
+
+    void fetch(std::string key, LoadCallback<std::string> done) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(Fetch{std::chrono::steady_clock::now() + delay_, std::move(key), std::move(done)});
+        }
+        cv_.notify_one();
+    }
+
+private:
+    struct Fetch {
+        std::chrono::steady_clock::time_point due;
+        std::string key;
+        LoadCallback<std::string> done;
+    };
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) return;
+            Fetch f = std::move(queue_.front());
+            queue_.pop_front();
+            lock.unlock();
+            std::this_thread::sleep_until(f.due);
+            f.done(fetched_value(f.key));   // Waiters resume here
+            lock.lock();
+        }
+    }
+
+    std::chrono::steady_clock::duration delay_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Fetch> queue_;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+struct SharedTally {
+    std::mutex mutex;
+    Tally tally;
+    std::atomic<std::size_t> done{0};
+};
+
+static Detached serve_shared(lockedlru::LockCache<std::string, std::string>& cache, Backend& backend, SharedTally& st,
+                             const std::string& key) {
+    const auto arrived = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(st.mutex);
+        st.tally.in_flight++;
+        st.tally.max_in_flight = std::max(st.tally.max_in_flight, st.tally.in_flight);
+    }
+    bool hit = true;
+    auto v = co_await cache.get_or_load(key, [&](const std::string& k, LoadCallback<std::string> done) {
+        hit = false;
+        backend.fetch(k, std::move(done));
+    });
+    if (!v || *v != fetched_value(key)) std::terminate();
+    {
+        std::lock_guard<std::mutex> lock(st.mutex);
+        st.tally.hits += hit;
+        st.tally.in_flight--;
+        st.tally.latency.record(static_cast<std::uint64_t>((std::chrono::steady_clock::now() - arrived).count()));
+    }
+    st.done.fetch_add(1, std::memory_order_release);
+}
+
+static void run_shared(const Options& o, const bench::Workload& w) {
+    lockedlru::LockCache<std::string, std::string> cache(o.keys);
+    SharedTally st;
+    const auto start = std::chrono::steady_clock::now();
+    {
+        Backend backend(o.backend_ms);
+        for (std::size_t i = 0; i < o.requests; i++) {
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                      std::chrono::duration<double, std::micro>(o.interarrival_us * static_cast<double>(i))));
+            serve_shared(cache, backend, st, w.key_names[w.ops[i % w.ops.size()].key]);
+        }
+        while (st.done.load(std::memory_order_acquire) < o.requests) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report("LockCache with a backend thread", st.tally, o.requests, cache.pending_loads().loads(),
+           cache.pending_loads().joined(), seconds);
+}
+
+int main(int argc, char** argv) {
+    const Options o = parse_args(argc, argv);
+    bench::WorkloadParams p;
+    p.universe = o.keys;
+    p.ops = o.requests;
+    const bench::Workload w = bench::zipf(p, o.skew);
+    std::printf("%zu requests every %.0f us over %u keys (zipf %.2f), backend fetch %.1f ms\n", o.requests,
+                o.interarrival_us, o.keys, o.skew, o.backend_ms);
+    run_local(o, w);
+    run_shared(o, w);
+    return 0;
+}
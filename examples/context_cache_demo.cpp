@@ -0,0 +1,239 @@
+#include "../include/locallru/context_cache.hpp"
+#include "../bench/workloads.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace locallru;
+
+// Context-local caches under a work-stealing scheduler. Tasks are coroutines
+// that look up Zipf keys and yield to the scheduler between lookups; every
+// worker runs its own ExecutorContext, and idle workers steal queued tasks
+// from the others, so a task typically resumes on several workers over its
+// life. After each resumption the task takes cache.local() again and uses
+// the store of the worker it is on now - no locks, and no store ever used
+// by two threads at once, which a handle kept across the yield would break.
+//
+//   ./context_cache_demo [--workers=N] [--tasks=N] [--steps=N] [--keys=N]
+//                        [--skew=S] [--capacity=N]
+
+struct Options {
+    std::size_t workers = 4;
+    std::size_t tasks = 2000;
+    std::size_t steps = 50;
+    std::uint32_t keys = 20000;
+    double skew = 0.99;
+    std::size_t capacity = 4096;
+};
+
+static Options parse_args(int argc, char** argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (std::strncmp(arg, "--workers=", 10) == 0) o.workers = std::strtoull(arg + 10, nullptr, 10);
+        else if (std::strncmp(arg, "--tasks=", 8) == 0) o.tasks = std::strtoull(arg + 8, nullptr, 10);
+        else if (std::strncmp(arg, "--steps=", 8) == 0) o.steps = std::strtoull(arg + 8, nullptr, 10);
+        else if (std::strncmp(arg, "--keys=", 7) == 0) o.keys = static_cast<std::uint32_t>(std::strtoul(arg + 7, nullptr, 10));
+        else if (std::strncmp(arg, "--skew=", 7) == 0) o.skew = std::strtod(arg + 7, nullptr);
+        else if (std::strncmp(arg, "--capacity=", 11) == 0) o.capacity = std::strtoull(arg + 11, nullptr, 10);
+        else {
+            std::fprintf(stderr,
+                         "usage: %s [--workers=N] [--tasks=N] [--steps=N] [--keys=N] [--skew=S] [--capacity=N]\n",
+                         argv[0]);
+            std::exit(2);
+        }
+    }
+    if (o.workers == 0) o.workers = 1;
+    return o;
+}
+
+// Fire-and-forget coroutine: runs until its first yield, frees itself when
+// done.
+struct Task {
+    struct promise_type {
+        Task get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// Per-worker counters. Only code running on the worker's context touches
+// them, so plain integers suffice, as for the stores.
+struct alignas(64) WorkerStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t resumed = 0;
+    std::uint64_t stolen = 0;
+};
+
+// Toy work-stealing scheduler: one deque per worker. A worker takes from
+// the front of its own deque and steals from the back of the others'; a
+// yielding task goes to the back of the deque of the worker it ran on.
+class Scheduler {
+public:
+    explicit Scheduler(std::size_t workers) : queues_(workers), stats_(workers) {
+        for (std::size_t i = 0; i < workers; i++) contexts_.emplace_back(i);
+    }
+
+    std::size_t workers() const { return contexts_.size(); }
+    const WorkerStats& stats(std::size_t worker) const { return stats_[worker]; }
+
+    // Stats of the worker the caller runs on.
+    WorkerStats& local_stats() { return stats_[ExecutorContext::current()->index()]; }
+
+    struct Yield {
+        Scheduler& s;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) { s.post(ExecutorContext::current()->index(), h); }
+        void await_resume() const noexcept {}
+    };
+
+    Yield yield() { return Yield{*this}; }
+
+    void post(std::size_t worker, std::coroutine_handle<> h) {
+        std::lock_guard<std::mutex> lock(queues_[worker].mutex);
+        queues_[worker].tasks.push_back(h);
+    }
+
+    void task_done() { remaining_.fetch_sub(1, std::memory_order_acq_rel); }
+
+    // Runs until tasks_started tasks have finished.
+    void run(std::size_t tasks_started) {
+        remaining_.store(tasks_started, std::memory_order_relaxed);
+        std::vector<std::thread> threads;
+        for (std::size_t i = 0; i < workers(); i++) threads.emplace_back([this, i] { work(i); });
+        for (auto& t : threads) t.join();
+    }
+
+    // Starts fn on worker 0's context; the others get work by stealing.
+    template <typename F>
+    void spawn_on_first(F&& fn) {
+        ExecutorContext::Scope scope(contexts_[0]);
+        fn();
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::coroutine_handle<>> tasks;
+    };
+
+    void work(std::size_t self) {
+        ExecutorContext::Scope scope(contexts_[self]);
+        while (remaining_.load(std::memory_order_acquire) > 0) {
+            std::coroutine_handle<> h;
+            bool stolen = false;
+            {
+                std::lock_guard<std::mutex> lock(queues_[self].mutex);
+                if (!queues_[self].tasks.empty()) {
+                    h = queues_[self].tasks.front();
+                    queues_[self].tasks.pop_front();
+                }
+            }
+            for (std::size_t i = 1; !h && i < workers(); i++) {
+                Queue& victim = queues_[(self + i) % workers()];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (!victim.tasks.empty()) {
+                    h = victim.tasks.back();
+                    victim.tasks.pop_back();
+                    stolen = true;
+                }
+            }
+            if (!h) {
+                std::this_thread::yield();
+                continue;
+            }
+            stats_[self].resumed++;
+            stats_[self].stolen += stolen;
+            h.resume();
+        }
+    }
+
+    std::vector<ExecutorContext> contexts_;
+    std::vector<Queue> queues_;
+    std::vector<WorkerStats> stats_;
+    std::atomic<std::size_t> remaining_{0};
+};
+
+struct Totals {
+    std::atomic<std::uint64_t> migrations{0};
+    std::atomic<std::uint64_t> wrong{0};
+};
+
+static std::string computed_value(const std::string& key) {
+    return "value of " + key;
+}
+
+static Task request(Scheduler& sched, ContextCache<std::string>& cache, Totals& totals, const bench::Workload& w,
+                    std::size_t first_op, std::size_t steps) {
+    for (std::size_t i = 0; i < steps; i++) {
+        const std::string& key = w.key_names[w.ops[(first_op + i) % w.ops.size()].key];
+        // Re-taken after every resumption: the task may be on another worker
+        auto local = cache.local();
+        bool hit = true;
+        auto v = co_await local.get_or_load(key, [&](const std::string& k, LoadCallback<std::string> done) {
+            hit = false;
+            done(computed_value(k));
+        });
+        if (!v || *v != computed_value(key)) totals.wrong.fetch_add(1, std::memory_order_relaxed);
+        WorkerStats& s = sched.local_stats();
+        s.hits += hit;
+        s.misses += !hit;
+
+        const std::size_t before = ExecutorContext::current()->index();
+        co_await sched.yield();
+        if (ExecutorContext::current()->index() != before) totals.migrations.fetch_add(1, std::memory_order_relaxed);
+    }
+    sched.task_done();
+}
+
+int main(int argc, char** argv) {
+    const Options o = parse_args(argc, argv);
+    bench::WorkloadParams p;
+    p.universe = o.keys;
+    p.ops = o.tasks * o.steps;
+    const bench::Workload w = bench::zipf(p, o.skew);
+
+    Scheduler sched(o.workers);
+    ContextCache<std::string> cache(o.workers, o.capacity, 0);
+    Totals totals;
+    std::printf("%zu tasks x %zu lookups on %zu workers, %u keys (zipf %.2f), %zu entries per worker\n", o.tasks,
+                o.steps, o.workers, o.keys, o.skew, o.capacity);
+
+    const auto start = std::chrono::steady_clock::now();
+    sched.spawn_on_first([&] {
+        for (std::size_t t = 0; t < o.tasks; t++) request(sched, cache, totals, w, t * o.steps, o.steps);
+    });
+    sched.run(o.tasks);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const std::uint64_t resumptions = static_cast<std::uint64_t>(o.tasks) * o.steps;
+    std::printf("%.2f s; %llu of %llu resumptions on another worker, %llu wrong values\n", seconds,
+                static_cast<unsigned long long>(totals.migrations.load()),
+                static_cast<unsigned long long>(resumptions),
+                static_cast<unsigned long long>(totals.wrong.load()));
+    std::printf("worker   resumed    stolen      hits    misses  hit%%   entries\n");
+    for (std::size_t i = 0; i < sched.workers(); i++) {
+        const WorkerStats& s = sched.stats(i);
+        const std::uint64_t lookups = s.hits + s.misses;
+        std::printf("%6zu %9llu %9llu %9llu %9llu %5.1f %9zu\n", i, static_cast<unsigned long long>(s.resumed),
+                    static_cast<unsigned long long>(s.stolen), static_cast<unsigned long long>(s.hits),
+                    static_cast<unsigned long long>(s.misses),
+                    lookups ? 100.0 * static_cast<double>(s.hits) / static_cast<double>(lookups) : 0.0,
+                    cache.on(i).size());
+    }
+    return totals.wrong.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,255 @@
+#include "../include/locallru/local_lru.hpp"
+#include "../src/lock_cache.hpp"
+#include "../src/csv_ingest.hpp"
+#include "../src/mpsc_ring.hpp"
+#include "../src/spsc_ring.hpp"
+#include "../src/tick_file.hpp"
+#include "../src/tick_replay.hpp"
+#include "../src/wire_tick.hpp"
+#include "../bench/histogram.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace locallru;
+using namespace locallru::feed;
+using namespace lockedlru;
+using locallru::bench::LatencyHistogram;
+
+// Feed handler -> strategy pipeline. Feed threads decode wire-format ticks
+// and publish them to every strategy thread through lock-free rings (SPSC
+// with one feed, MPSC with several); strategies drain their ring in batches
+// and read the latest price from a cache. Two ways of sharing prices are
+// compared:
+//
+//   local   every strategy applies each update to its own LocalCache copy
+//           and reads from it (updates are propagated through the rings)
+//   shared  the feed writes each update once into a shared LockCache and
+//           strategies read it from there (the rings only carry the
+//           notification)
+//
+// Latency is end to end per event: from the feed starting to decode the
+// message to the strategy having read the price.
+//
+//   ./pipeline_demo [--mode=local|shared|both] [--strategies=N] [--feeds=N]
+//                   [--rate=MSGS_PER_SEC] [--repeat=N] [--batch=N]
+
+// Datetime,Open,High,Low,Close,Adj Close,Volume
+constexpr std::size_t kTimeColumn = 0;
+constexpr std::size_t kCloseColumn = 4;
+constexpr const char* kTickFilePath = "../data/ticks.bin";
+
+enum class Mode { local, shared };
+
+struct Options {
+    std::string mode = "both";
+    int strategies = 2;
+    int feeds = 1;
+    double rate = 500'000;   // Messages/s across all feeds; 0 = as fast as possible
+    int repeat = 10;         // Passes over the data
+    std::size_t batch = 64;  // Max events a strategy takes per drain
+};
+
+// What a feed publishes to each strategy
+struct Update {
+    std::uint32_t symbol = 0;
+    double price = 0.0;
+    std::int64_t t_feed_ns = 0;  // steady_clock, when decoding started
+};
+
+struct StrategyResult {
+    LatencyHistogram e2e;
+    std::uint64_t events = 0;
+    double checksum = 0.0;       // Keeps the reads observable
+};
+
+struct PipelineResult {
+    std::vector<StrategyResult> strategies;
+    double seconds = 0.0;
+    std::uint64_t messages = 0;
+    std::uint64_t stalls = 0;    // Publishes that found a ring full
+};
+
+static std::int64_t now_ns() {
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+template <typename Ring>
+PipelineResult run_pipeline(Mode mode, const Options& opt, const std::vector<std::string>& symbols,
+                            const std::vector<std::vector<WireTick>>& feed_messages) {
+    const size_t n_strategies = static_cast<size_t>(std::max(1, opt.strategies));
+    const SymbolTable table(symbols);
+    LockCache<std::string, double> shared(symbols.size());
+    std::vector<std::unique_ptr<Ring>> rings;
+    for (size_t i = 0; i < n_strategies; i++) rings.push_back(std::make_unique<Ring>(1 << 14));
+
+    PipelineResult result;
+    result.strategies.resize(n_strategies);
+    std::atomic<int> feeds_running{static_cast<int>(feed_messages.size())};
+    std::atomic<bool> go{false};
+    std::atomic<std::uint64_t> stalls{0};
+
+    std::vector<std::thread> threads;
+    for (size_t s = 0; s < n_strategies; s++) {
+        threads.emplace_back([&, s] {
+            auto local = LocalCache<double>::initialize(symbols.size(), 0);
+            StrategyResult& r = result.strategies[s];
+            auto on_update = [&](const Update& u) {
+                const std::string& sym = symbols[u.symbol];
+                std::optional<double> price;
+                if (mode == Mode::local) {
+                    local.add_item(sym, u.price);
+                    price = local.get_item(sym);
+                } else {
+                    price = shared.get(sym);
+                }
+                r.e2e.record(static_cast<std::uint64_t>(now_ns() - u.t_feed_ns));
+                r.events++;
+                if (price) r.checksum += *price;
+            };
+            Ring& ring = *rings[s];
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (;;) {
+                if (ring.consume(on_update, opt.batch) != 0) continue;
+                if (feeds_running.load(std::memory_order_acquire) == 0) {
+                    while (ring.consume(on_update, opt.batch) != 0) {}
+                    break;
+                }
+                std::this_thread::yield();
+            }
+        });
+    }
+
+    const double per_feed_rate = opt.rate / static_cast<double>(feed_messages.size());
+    for (size_t f = 0; f < feed_messages.size(); f++) {
+        threads.emplace_back([&, f] {
+            const auto& msgs = feed_messages[f];
+            std::uint64_t local_stalls = 0;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            const std::int64_t start = now_ns();
+            std::uint64_t sent = 0;
+            for (int pass = 0; pass < opt.repeat; pass++) {
+                for (const WireTick& w : msgs) {
+                    if (per_feed_rate > 0) {
+                        // Fixed schedule; a late feed sends immediately
+                        const auto due = start + static_cast<std::int64_t>(static_cast<double>(sent) * 1e9 / per_feed_rate);
+                        while (now_ns() < due) {}
+                    }
+                    sent++;
+
+                    Update u;
+                    u.t_feed_ns = now_ns();
+                    Tick t;
+                    if (!decode_tick(w, table, t)) continue;
+                    u.symbol = t.symbol;
+                    u.price = t.price;
+                    if (mode == Mode::shared) shared.put(symbols[t.symbol], t.price);
+                    for (auto& ring : rings) {
+                        if (ring->try_push(u)) continue;
+                        local_stalls++;
+                        while (!ring->try_push(u)) std::this_thread::yield();
+                    }
+                }
+            }
+            stalls.fetch_add(local_stalls);
+            feeds_running.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& t : threads) t.join();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (const auto& m : feed_messages) result.messages += m.size() * static_cast<std::uint64_t>(opt.repeat);
+    result.stalls = stalls.load();
+    return result;
+}
+
+static void report(const char* name, const Options& opt, const PipelineResult& r) {
+    LatencyHistogram all;
+    std::uint64_t events = 0;
+    for (const auto& s : r.strategies) {
+        all.merge(s.e2e);
+        events += s.events;
+    }
+    std::printf("%-7s %6d %6d %10llu %12.0f %9llu %9llu %9llu %11llu %8llu\n", name, opt.feeds, opt.strategies,
+                static_cast<unsigned long long>(r.messages), static_cast<double>(r.messages) / r.seconds,
+                static_cast<unsigned long long>(all.percentile(0.50)),
+                static_cast<unsigned long long>(all.percentile(0.99)),
+                static_cast<unsigned long long>(all.percentile(0.999)),
+                static_cast<unsigned long long>(all.max()), static_cast<unsigned long long>(r.stalls));
+    if (events != r.messages * r.strategies.size()) {
+        std::fprintf(stderr, "Warning: %s delivered %llu events, expected %llu\n", name,
+                     static_cast<unsigned long long>(events),
+                     static_cast<unsigned long long>(r.messages * r.strategies.size()));
+    }
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        if (std::strncmp(a, "--mode=", 7) == 0) opt.mode = a + 7;
+        else if (std::strncmp(a, "--strategies=", 13) == 0) opt.strategies = std::max(1, std::atoi(a + 13));
+        else if (std::strncmp(a, "--feeds=", 8) == 0) opt.feeds = std::max(1, std::atoi(a + 8));
+        else if (std::strncmp(a, "--rate=", 7) == 0) opt.rate = std::strtod(a + 7, nullptr);
+        else if (std::strncmp(a, "--repeat=", 9) == 0) opt.repeat = std::max(1, std::atoi(a + 9));
+        else if (std::strncmp(a, "--batch=", 8) == 0) opt.batch = std::max<std::size_t>(1, std::strtoull(a + 8, nullptr, 10));
+        else {
+            std::fprintf(stderr,
+                         "usage: %s [--mode=local|shared|both] [--strategies=N] [--feeds=N]\n"
+                         "          [--rate=MSGS_PER_SEC] [--repeat=N] [--batch=N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<std::string> symbols = {"AAPL", "MSFT", "GOOG", "TSLA"};
+    std::vector<TickSource> sources(symbols.size());
+    std::vector<TickColumns> parsed(symbols.size());
+    std::unique_ptr<TickFile> tick_file;
+    if (std::filesystem::exists(kTickFilePath)) {
+        tick_file = std::make_unique<TickFile>(kTickFilePath);
+        for (size_t i = 0; i < symbols.size(); i++) {
+            if (auto* t = tick_file->find(symbols[i])) sources[i] = TickSource{t->prices, t->timestamps};
+        }
+    } else {
+        for (size_t i = 0; i < symbols.size(); i++) {
+            try {
+                parsed[i] = load_ticks("../data/" + symbols[i] + ".csv", kTimeColumn, kCloseColumn);
+            } catch (const std::exception& e) {
+                std::cerr << "Error loading " << symbols[i] << ": " << e.what() << std::endl;
+            }
+            sources[i] = TickSource{parsed[i].prices, TimestampColumn(parsed[i].timestamps)};
+        }
+    }
+
+    // Encode the merged stream once, partitioned across feeds by symbol the
+    // way exchange feeds are split into channels
+    std::vector<std::vector<WireTick>> feed_messages(static_cast<size_t>(opt.feeds));
+    TickMerger merger(sources);
+    std::uint64_t seq = 0;
+    while (auto t = merger.next()) {
+        feed_messages[t->symbol % feed_messages.size()].push_back(encode_tick(symbols[t->symbol], *t, ++seq));
+    }
+
+    std::printf("%-7s %6s %6s %10s %12s %9s %9s %9s %11s %8s\n", "mode", "feeds", "strats", "messages", "msgs/s",
+                "p50 ns", "p99 ns", "p99.9 ns", "max ns", "stalls");
+    for (Mode mode : {Mode::local, Mode::shared}) {
+        const char* name = mode == Mode::local ? "local" : "shared";
+        if (opt.mode != "both" && opt.mode != name) continue;
+        PipelineResult r = opt.feeds == 1
+            ? run_pipeline<SpscRing<Update>>(mode, opt, symbols, feed_messages)
+            : run_pipeline<MpscRing<Update>>(mode, opt, symbols, feed_messages);
+        report(name, opt, r);
+    }
+    return 0;
+}
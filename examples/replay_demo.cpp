@@ -0,0 +1,192 @@
+#include "../include/locallru/local_lru.hpp"
+#include "../include/locallru/rolling_stats.hpp"
+#include "../include/locallru/compressed_series.hpp"
+#include "../src/lock_cache.hpp"
+#include "../src/csv_ingest.hpp"
+#include "../src/tick_file.hpp"
+#include "../src/tick_replay.hpp"
+#include "../bench/histogram.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace locallru;
+using namespace locallru::feed;
+using namespace lockedlru;
+using locallru::bench::LatencyHistogram;
+
+// Replays every symbol's ticks merged in timestamp order and fans them out to
+// several strategy threads. Each strategy keeps rolling statistics over the
+// recent ticks of each symbol (RollingStats) in its own LocalCache and in one
+// LockCache shared by all strategies, appends to them in place and reads the
+// moving average back in constant time. The cost of both is recorded per
+// tick.
+//
+//   ./replay_demo [--strategies=N] [--speed=X] [--max-gap=SECONDS]
+//
+// --speed=0 (default) replays as fast as possible; --speed=60 replays one
+// recorded minute per wall second. --max-gap shortens longer pauses in the
+// data, such as overnight closes, when pacing.
+
+// Datetime,Open,High,Low,Close,Adj Close,Volume
+constexpr std::size_t kTimeColumn = 0;
+constexpr std::size_t kCloseColumn = 4;
+constexpr const char* kTickFilePath = "../data/ticks.bin";
+
+constexpr std::size_t kAverageWindow = 50;  // Ticks in the moving average
+using Series = locallru::RollingStats<kAverageWindow>;
+using History = locallru::CompressedSeries<1 << 20>;
+
+struct StrategyResult {
+    LatencyHistogram local;
+    LatencyHistogram shared;
+    std::uint64_t above_average = 0;
+};
+
+// Per-thread strategy: append each tick to the symbol's series and compare
+// the price with its moving average, in both caches. Every strategy sees
+// every tick, so the shared series only takes a tick newer than its latest
+// one; each tick is appended there once.
+class MovingAverageStrategy {
+public:
+    MovingAverageStrategy(const std::vector<std::string>& symbols, LockCache<std::string, Series>& shared,
+                          StrategyResult& result)
+        : symbols_(symbols), shared_(shared), result_(result), local_(LocalCache<Series>::initialize(1000, 0)) {}
+
+    void operator()(const Tick& t) {
+        const std::string& sym = symbols_[t.symbol];
+        double local_avg = 0.0, shared_avg = 0.0;
+
+        auto t0 = std::chrono::steady_clock::now();
+        local_.upsert_item(sym, [&](Series& s) { s.append(t.ts_ns, t.price); });
+        local_.read_item(sym, [&](const Series& s) { local_avg = s.mean(); });
+        auto t1 = std::chrono::steady_clock::now();
+        shared_.upsert(sym, [&](Series& s) {
+            if (s.empty() || t.ts_ns > s.timestamp()) s.append(t.ts_ns, t.price);
+        });
+        shared_.read(sym, [&](const Series& s) { shared_avg = s.mean(); });
+        auto t2 = std::chrono::steady_clock::now();
+
+        result_.local.record(static_cast<std::uint64_t>((t1 - t0).count()));
+        result_.shared.record(static_cast<std::uint64_t>((t2 - t1).count()));
+        if (t.price > local_avg) result_.above_average++;
+        (void)shared_avg; // Same series as local; read for its cost
+    }
+
+private:
+    const std::vector<std::string>& symbols_;
+    LockCache<std::string, Series>& shared_;
+    StrategyResult& result_;
+    LocalCache<Series> local_;
+};
+
+static void print_row(const char* name, const LatencyHistogram& h) {
+    std::printf("  %-10s %12llu %9.0f %9llu %9llu %9llu\n", name, static_cast<unsigned long long>(h.count()), h.mean(),
+                static_cast<unsigned long long>(h.percentile(0.50)), static_cast<unsigned long long>(h.percentile(0.99)),
+                static_cast<unsigned long long>(h.max()));
+}
+
+int main(int argc, char** argv) {
+    ReplayOptions opt;
+    opt.strategies = 4;
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "--strategies=", 13) == 0) opt.strategies = std::atoi(argv[i] + 13);
+        else if (std::strncmp(argv[i], "--speed=", 8) == 0) opt.speed = std::strtod(argv[i] + 8, nullptr);
+        else if (std::strncmp(argv[i], "--max-gap=", 10) == 0) opt.max_gap_ns = static_cast<std::int64_t>(std::strtod(argv[i] + 10, nullptr) * 1e9);
+        else {
+            std::fprintf(stderr, "usage: %s [--strategies=N] [--speed=X] [--max-gap=SECONDS]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<std::string> symbols = {"AAPL", "MSFT", "GOOG", "TSLA"};
+    std::vector<TickSource> sources(symbols.size());
+    std::vector<TickColumns> parsed(symbols.size()); // Backing storage for the CSV path
+
+    // Same sources as trading_demo: the mapped tick file if present, else CSVs
+    auto load_start = std::chrono::steady_clock::now();
+    std::unique_ptr<TickFile> tick_file;
+    if (std::filesystem::exists(kTickFilePath)) {
+        tick_file = std::make_unique<TickFile>(kTickFilePath);
+        for (size_t i = 0; i < symbols.size(); i++) {
+            if (auto* t = tick_file->find(symbols[i])) sources[i] = TickSource{t->prices, t->timestamps};
+            else std::cerr << "Warning: " << symbols[i] << " not found in " << kTickFilePath << std::endl;
+        }
+    } else {
+        std::vector<std::thread> loaders;
+        for (size_t i = 0; i < symbols.size(); i++) {
+            loaders.emplace_back([&, i] {
+                try {
+                    parsed[i] = load_ticks("../data/" + symbols[i] + ".csv", kTimeColumn, kCloseColumn);
+                } catch (const std::exception& e) {
+                    std::cerr << "Error loading " << symbols[i] << ": " << e.what() << std::endl;
+                }
+            });
+        }
+        for (auto& t : loaders) t.join();
+        for (size_t i = 0; i < symbols.size(); i++) {
+            sources[i] = TickSource{parsed[i].prices, TimestampColumn(parsed[i].timestamps)};
+        }
+    }
+    double load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load_start).count();
+
+    LockCache<std::string, Series> shared(1000);
+    std::vector<StrategyResult> results(static_cast<size_t>(std::max(1, opt.strategies)));
+    ReplayStats stats = replay(sources, opt, [&](int i) {
+        return MovingAverageStrategy(symbols, shared, results[static_cast<size_t>(i)]);
+    });
+
+    std::printf("Loaded %zu symbols in %.1f ms (%s)\n", symbols.size(), load_ms, tick_file ? "tick file" : "CSV");
+    std::printf("Replayed %llu ticks to %d strategies in %.3f s (%.0f ticks/s), pacing %s",
+                static_cast<unsigned long long>(stats.ticks), opt.strategies, stats.seconds,
+                static_cast<double>(stats.ticks) / stats.seconds, opt.speed > 0 ? "on" : "off");
+    if (opt.speed > 0) std::printf(" at %gx, max lag %.1f us", opt.speed, static_cast<double>(stats.max_lag_ns) / 1e3);
+    std::printf(", feed stalls %llu\n\n", static_cast<unsigned long long>(stats.stalls));
+
+    std::printf("  %-10s %12s %9s %9s %9s %9s\n", "append+avg", "ops", "mean ns", "p50 ns", "p99 ns", "max ns");
+    LatencyHistogram local_all, shared_all;
+    for (size_t i = 0; i < results.size(); i++) {
+        std::printf("strategy %zu (above %zu-tick average: %llu)\n", i, kAverageWindow,
+                    static_cast<unsigned long long>(results[i].above_average));
+        print_row("LocalLRU", results[i].local);
+        print_row("LockCache", results[i].shared);
+        local_all.merge(results[i].local);
+        shared_all.merge(results[i].shared);
+    }
+    std::printf("all strategies\n");
+    print_row("LocalLRU", local_all);
+    print_row("LockCache", shared_all);
+
+    // Full history of every symbol, compressed, in a LocalCache on this thread
+    auto history = LocalCache<History>::initialize(symbols.size(), 0);
+    TickMerger merger(sources);
+    while (auto t = merger.next()) {
+        history.upsert_item(symbols[t->symbol], [&](History& h) { h.append(t->ts_ns, t->price); });
+    }
+    std::size_t history_ticks = 0, history_bytes = 0;
+    for (const auto& sym : symbols) {
+        history.read_item(sym, [&](const History& h) {
+            history_ticks += h.size();
+            history_bytes += h.bytes();
+        });
+    }
+    std::vector<std::int64_t> window_ts;
+    std::vector<double> window_prices;
+    auto d0 = std::chrono::steady_clock::now();
+    history.read_item(symbols[0], [&](const History& h) { h.decode(window_ts, window_prices, 1000); });
+    auto d1 = std::chrono::steady_clock::now();
+    double raw_kb = static_cast<double>(history_ticks * (sizeof(std::int64_t) + sizeof(double))) / 1024.0;
+    std::printf("\nhistory: %zu ticks in %.1f KB compressed (%.1f KB raw, %.1fx); last %zu %s ticks decoded in %.1f us\n",
+                history_ticks, static_cast<double>(history_bytes) / 1024.0, raw_kb,
+                raw_kb * 1024.0 / static_cast<double>(history_bytes ? history_bytes : 1), window_ts.size(),
+                symbols[0].c_str(), std::chrono::duration<double, std::micro>(d1 - d0).count());
+    return 0;
+}
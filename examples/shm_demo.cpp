@@ -0,0 +1,191 @@
+#include "../include/locallru/shm_cache.hpp"
+#include "../bench/histogram.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace locallru;
+using locallru::bench::LatencyHistogram;
+
+// Several processes sharing one cache. The parent creates a shared-memory
+// segment, fills it with quotes and keeps updating them; forked reader
+// processes attach to the segment by name and look quotes up lock-free, as
+// strategy processes would read reference data published by a feed handler.
+//
+//   ./shm_demo [--name=/SEGMENT] [--readers=N] [--keys=N] [--seconds=S]
+//
+// Each reader checks every quote it gets for torn values and reports hit
+// rate and lookup latency back to the parent over a pipe.
+
+struct Quote {
+    double bid;
+    double ask;            // Always bid + 1: a torn read would break this
+    std::int64_t ts_ns;
+    std::uint64_t version;
+};
+using QuoteCache = ShmCache<Quote, 16>;
+
+struct ReaderResult {
+    LatencyHistogram latency;
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t torn = 0;
+};
+static_assert(std::is_trivially_copyable_v<ReaderResult>, "sent over a pipe");
+
+static std::string key_of(std::size_t i) {
+    return "SYM" + std::to_string(i);
+}
+
+static Quote quote_of(std::uint64_t version) {
+    const double bid = 100.0 + static_cast<double>(version % 1000) * 0.01;
+    return Quote{bid, bid + 1.0, static_cast<std::int64_t>(std::chrono::steady_clock::now().time_since_epoch().count()),
+                 version};
+}
+
+static ReaderResult read_quotes(const std::string& name, std::size_t keys, double seconds, unsigned seed) {
+    QuoteCache cache = QuoteCache::open(name);
+    std::vector<std::string> names;
+    for (std::size_t i = 0; i < keys; i++) names.push_back(key_of(i));
+    std::mt19937_64 rng(seed);
+    ReaderResult r;
+    const auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+    while (std::chrono::steady_clock::now() < end) {
+        for (int i = 0; i < 1000; i++) {
+            const std::string& key = names[rng() % keys];
+            auto t0 = std::chrono::steady_clock::now();
+            auto q = cache.get(key);
+            auto t1 = std::chrono::steady_clock::now();
+            r.latency.record(static_cast<std::uint64_t>((t1 - t0).count()));
+            if (!q) {
+                r.misses++;
+                continue;
+            }
+            r.hits++;
+            if (q->ask != q->bid + 1.0) r.torn++;
+        }
+    }
+    return r;
+}
+
+int main(int argc, char** argv) {
+    std::string name = "/locallru_shm_demo";
+    int readers = 3;
+    std::size_t keys = 10000;
+    double seconds = 2.0;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        if (std::strncmp(a, "--name=", 7) == 0) name = a + 7;
+        else if (std::strncmp(a, "--readers=", 10) == 0) readers = std::max(1, std::atoi(a + 10));
+        else if (std::strncmp(a, "--keys=", 7) == 0) keys = std::max<std::size_t>(1, std::strtoull(a + 7, nullptr, 10));
+        else if (std::strncmp(a, "--seconds=", 10) == 0) seconds = std::strtod(a + 10, nullptr);
+        else {
+            std::fprintf(stderr, "usage: %s [--name=/SEGMENT] [--readers=N] [--keys=N] [--seconds=S]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    try {
+        QuoteCache::remove(name); // Left over from an earlier run that was killed
+        QuoteCache cache = QuoteCache::create(name, keys, 0);
+        for (std::size_t i = 0; i < keys; i++) cache.put(key_of(i), quote_of(i));
+
+        struct Child {
+            pid_t pid;
+            int fd;
+        };
+        std::vector<Child> children;
+        for (int r = 0; r < readers; r++) {
+            int fds[2];
+            if (::pipe(fds) != 0) throw std::system_error(errno, std::generic_category(), "pipe");
+            const pid_t pid = ::fork();
+            if (pid < 0) throw std::system_error(errno, std::generic_category(), "fork");
+            if (pid == 0) {
+                ::close(fds[0]);
+                int status = 0;
+                try {
+                    const ReaderResult result = read_quotes(name, keys, seconds, static_cast<unsigned>(r + 1));
+                    if (::write(fds[1], &result, sizeof(result)) != static_cast<ssize_t>(sizeof(result))) status = 1;
+                } catch (const std::exception& e) {
+                    std::cerr << "reader " << r << ": " << e.what() << std::endl;
+                    status = 1;
+                }
+                ::_exit(status);
+            }
+            ::close(fds[1]);
+            children.push_back(Child{pid, fds[0]});
+        }
+
+        // Publish updates while the readers run
+        std::mt19937_64 rng(0);
+        std::uint64_t writes = 0;
+        const auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+        while (std::chrono::steady_clock::now() < end) {
+            for (int i = 0; i < 100; i++) {
+                cache.put(key_of(rng() % keys), quote_of(keys + writes));
+                writes++;
+            }
+        }
+
+        ReaderResult total;
+        bool failed = false;
+        for (const Child& c : children) {
+            ReaderResult r;
+            std::size_t got = 0;
+            while (got < sizeof(r)) {
+                const ssize_t n = ::read(c.fd, reinterpret_cast<char*>(&r) + got, sizeof(r) - got);
+                if (n <= 0) break;
+                got += static_cast<std::size_t>(n);
+            }
+            ::close(c.fd);
+            int status = 0;
+            ::waitpid(c.pid, &status, 0);
+            if (got != sizeof(r) || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                failed = true;
+                continue;
+            }
+            total.latency.merge(r.latency);
+            total.hits += r.hits;
+            total.misses += r.misses;
+            total.torn += r.torn;
+        }
+
+        const double lookups = static_cast<double>(total.hits + total.misses);
+        std::printf("segment %s: %zu keys, %zu bytes\n", name.c_str(), cache.size(), cache.segment_bytes());
+        std::printf("writer: %llu updates (%.0f/s)\n", static_cast<unsigned long long>(writes),
+                    static_cast<double>(writes) / seconds);
+        std::printf("%d readers: %.0f lookups (%.0f/s), hit rate %.2f%%, torn %llu\n", readers, lookups,
+                    lookups / seconds, lookups ? 100.0 * static_cast<double>(total.hits) / lookups : 0.0,
+                    static_cast<unsigned long long>(total.torn));
+        std::printf("  get latency ns: p50 %llu  p99 %llu  p99.9 %llu  max %llu\n",
+                    static_cast<unsigned long long>(total.latency.percentile(0.50)),
+                    static_cast<unsigned long long>(total.latency.percentile(0.99)),
+                    static_cast<unsigned long long>(total.latency.percentile(0.999)),
+                    static_cast<unsigned long long>(total.latency.max()));
+        std::printf("memory: one shared copy %.1f MB vs %.1f MB for a copy per process\n",
+                    static_cast<double>(cache.segment_bytes()) / 1e6,
+                    static_cast<double>(cache.segment_bytes()) * (readers + 1) / 1e6);
+
+        QuoteCache::remove(name);
+        return failed || total.torn ? 1 : 0;
+    } catch (const std::exception& e) {
+        QuoteCache::remove(name);
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
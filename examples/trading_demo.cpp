@@ -1,5 +1,8 @@
 #include "../include/locallru/local_lru.hpp"
 #include "../src/lock_cache.hpp"
+#include "../src/async_log.hpp"
+#include "../src/csv_ingest.hpp"
+#include "../src/tick_file.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -7,54 +10,97 @@
 #include <thread>
 #include <vector>
 #include <string>
-#include <sstream>
 #include <filesystem>
 #include <algorithm>
-#include <mutex>
+#include <charconv>
+#include <cstdint>
+#include <memory>
+#include <span>
 
 using namespace locallru;
 using namespace lockedlru;
+using namespace locallru::logging;
 
+// Datetime,Open,High,Low,Close,Adj Close,Volume
+constexpr std::size_t kCloseColumn = 4;
+constexpr const char* kTickFilePath = "../data/ticks.bin";
+
+// Prices either point into a mapped tick file or into `storage` when
+// they were parsed from CSV.
 struct PriceData {
-    std::vector<double> prices;
+    std::vector<double> storage;
+    std::span<const double> prices;
+};
+
+// Binary log record produced inside the timed loop.
+struct LogRecord {
+    enum Kind : uint32_t { symbol_start, tick };
+    Kind kind;
+    uint32_t symbol;
+    double value;          // price, or row count for symbol_start
+    int64_t lockfree_ns;
+    int64_t locking_ns;
 };
 
-std::mutex cout_mutex;
+// Formats LogRecords on the logger thread. Text lines match the original
+// per-op "SYM price=... lockfree_ns=... locking_ns=..." format.
+class LogWriter {
+public:
+    LogWriter(std::ofstream& log, std::ofstream& csv, const std::vector<std::string>& symbols)
+        : log_(log), csv_(csv), symbols_(symbols) {}
+
+    void write(const LogRecord& r) {
+        const std::string& sym = symbols_[r.symbol];
+        if (r.kind == LogRecord::symbol_start) {
+            log_buf_ += sym;
+            log_buf_ += " processing ";
+            append(log_buf_, static_cast<uint64_t>(r.value));
+            log_buf_ += " rows\n";
+        } else {
+            log_buf_ += sym;
+            log_buf_ += " price=";
+            append(log_buf_, r.value);
+            log_buf_ += " lockfree_ns=";
+            append(log_buf_, r.lockfree_ns);
+            log_buf_ += " locking_ns=";
+            append(log_buf_, r.locking_ns);
+            log_buf_ += '\n';
+
+            csv_buf_ += "LocalLRU,";
+            append(csv_buf_, r.lockfree_ns / 1000.0);
+            csv_buf_ += "\nLockCache,";
+            append(csv_buf_, r.locking_ns / 1000.0);
+            csv_buf_ += '\n';
+        }
+        if (log_buf_.size() + csv_buf_.size() > (1 << 16)) flush();
+    }
 
-PriceData preload_csv(const std::string& filepath, const std::string& sym) {
-    PriceData pdata;
-    std::ifstream file(filepath);
-    if (!file.is_open()) {
-        std::lock_guard<std::mutex> lock(cout_mutex);
-        std::cerr << "Error opening file: " << filepath << std::endl;
-        return pdata;
+    void flush() {
+        log_.write(log_buf_.data(), static_cast<std::streamsize>(log_buf_.size()));
+        csv_.write(csv_buf_.data(), static_cast<std::streamsize>(csv_buf_.size()));
+        log_buf_.clear();
+        csv_buf_.clear();
     }
 
-    std::string line;
-    std::getline(file, line); // skip header
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string date, open, high, low, close, adjclose, volume;
-        std::getline(ss, date, ',');       
-        std::getline(ss, open, ',');       
-        std::getline(ss, high, ',');       
-        std::getline(ss, low, ',');        
-        std::getline(ss, close, ',');      
-        std::getline(ss, adjclose, ',');   
-        std::getline(ss, volume, ',');     
-
-        if (close.empty() || close == "null" || close == "N/A") continue;
-
-        try {
-            pdata.prices.push_back(std::stod(close));
-        } catch (const std::exception&) {
-            std::lock_guard<std::mutex> lock(cout_mutex);
-            std::cerr << "Warning: skipping invalid price '" << close << "' for symbol " << sym << std::endl;
+private:
+    template <typename T>
+    static void append(std::string& out, T v) {
+        char buf[32];
+        std::to_chars_result res;
+        if constexpr (std::is_floating_point_v<T>) {
+            res = std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::general, 6); // ostream default
+        } else {
+            res = std::to_chars(buf, buf + sizeof(buf), v);
         }
+        out.append(buf, res.ptr);
     }
 
-    return pdata;
-}
+    std::ofstream& log_;
+    std::ofstream& csv_;
+    const std::vector<std::string>& symbols_;
+    std::string log_buf_;
+    std::string csv_buf_;
+};
 
 int main() {
     std::filesystem::create_directories("../results");
@@ -62,10 +108,31 @@ int main() {
     std::vector<std::string> symbols = {"AAPL", "MSFT", "GOOG", "TSLA"};
     std::vector<PriceData> all_data(symbols.size());
 
-    // Preload CSVs
-    for (size_t i = 0; i < symbols.size(); i++) {
-        std::string path = "../data/" + symbols[i] + ".csv";
-        all_data[i] = preload_csv(path, symbols[i]);
+    // Prefer the binary tick file (see tools/tick_convert.cpp): it is mapped,
+    // not parsed, and the loop reads prices straight out of the mapping.
+    std::unique_ptr<feed::TickFile> tick_file;
+    if (std::filesystem::exists(kTickFilePath)) {
+        tick_file = std::make_unique<feed::TickFile>(kTickFilePath);
+        for (size_t i = 0; i < symbols.size(); i++) {
+            if (auto* t = tick_file->find(symbols[i])) all_data[i].prices = t->prices;
+            else std::cerr << "Warning: " << symbols[i] << " not found in " << kTickFilePath << std::endl;
+        }
+    } else {
+        // Preload CSVs: every file is mapped and parsed on its own thread
+        std::vector<std::string> paths;
+        for (auto& s : symbols) paths.push_back("../data/" + s + ".csv");
+        auto columns = feed::load_columns(paths, kCloseColumn);
+        for (size_t i = 0; i < symbols.size(); i++) {
+            if (!columns[i].error.empty()) {
+                std::cerr << "Error opening file: " << paths[i] << " (" << columns[i].error << ")" << std::endl;
+                continue;
+            }
+            if (columns[i].invalid) {
+                std::cerr << "Warning: skipped " << columns[i].invalid << " invalid price(s) for symbol " << symbols[i] << std::endl;
+            }
+            all_data[i].storage = std::move(columns[i].values);
+            all_data[i].prices = all_data[i].storage;
+        }
     }
 
     // Setup caches
@@ -77,41 +144,55 @@ int main() {
     for (auto& s : symbols) log_file << s << " ";
     log_file << "\n---------------------------------\n";
 
+    // The timed loop only copies a LogRecord into a per-thread ring; the
+    // logger's background thread formats the text log and the latency CSV
+    // for scripts/plot_results.py.
+    std::ofstream csv_file("../results/trading_latency.csv");
+    csv_file << "cache_type,latency_us\n";
+    LogWriter writer(log_file, csv_file, symbols);
     auto start_total = std::chrono::high_resolution_clock::now();
+    std::chrono::high_resolution_clock::time_point end_total;
+    {
+        AsyncLogger<LogRecord> logger([&writer](const LogRecord& r) { writer.write(r); });
+
+        for (size_t i = 0; i < symbols.size(); i++) {
+            auto& pdata = all_data[i];
+
+            logger.log(LogRecord{LogRecord::symbol_start, static_cast<uint32_t>(i),
+                                 static_cast<double>(pdata.prices.size()), 0, 0});
+
+            for (auto price : pdata.prices) {
+                // Lock-free
+                auto t1_start = std::chrono::high_resolution_clock::now();
+                lockfree.add_item(symbols[i], price);
+                auto val1 = lockfree.get_item(symbols[i]);
+                auto t1_end = std::chrono::high_resolution_clock::now();
+
+                // Locking
+                auto t2_start = std::chrono::high_resolution_clock::now();
+                locking.put(symbols[i], price);
+                auto val2 = locking.get(symbols[i]);
+                auto t2_end = std::chrono::high_resolution_clock::now();
+
+                logger.log(LogRecord{LogRecord::tick, static_cast<uint32_t>(i), price,
+                                     std::chrono::duration_cast<std::chrono::nanoseconds>(t1_end - t1_start).count(),
+                                     std::chrono::duration_cast<std::chrono::nanoseconds>(t2_end - t2_start).count()});
+            }
+        }
 
-    for (size_t i = 0; i < symbols.size(); i++) {
-        auto& pdata = all_data[i];
-
-        log_file << symbols[i] << " processing " << pdata.prices.size() << " rows\n";
-
-        for (auto price : pdata.prices) {
-            // Lock-free
-            auto t1_start = std::chrono::high_resolution_clock::now();
-            lockfree.add_item(symbols[i], price);
-            auto val1 = lockfree.get_item(symbols[i]);
-            auto t1_end = std::chrono::high_resolution_clock::now();
-
-            // Locking
-            auto t2_start = std::chrono::high_resolution_clock::now();
-            locking.put(symbols[i], price);
-            auto val2 = locking.get(symbols[i]);
-            auto t2_end = std::chrono::high_resolution_clock::now();
-
-            log_file << symbols[i] << " price=" << price 
-                     << " lockfree_ns=" 
-                     << std::chrono::duration_cast<std::chrono::nanoseconds>(t1_end - t1_start).count()
-                     << " locking_ns=" 
-                     << std::chrono::duration_cast<std::chrono::nanoseconds>(t2_end - t2_start).count()
-                     << "\n";
+        end_total = std::chrono::high_resolution_clock::now();
+        if (logger.stalls()) {
+            std::cerr << "Warning: logger ring was full " << logger.stalls() << " time(s)\n";
         }
-    }
+    } // Logger drains and joins here
 
-    auto end_total = std::chrono::high_resolution_clock::now();
+    writer.flush();
     double elapsed_sec = std::chrono::duration<double>(end_total - start_total).count();
     log_file << "Total elapsed time (s): " << elapsed_sec << "\n";
     log_file << "[Benchmark End]\n";
 
-    std::cout << "Benchmark complete. Results written to ../results/trading_benchmark.log\n";
+    std::cout << "Benchmark complete. Results written to ../results/trading_benchmark.log"
+              << " and ../results/trading_latency.csv\n";
 
     return 0;
 }
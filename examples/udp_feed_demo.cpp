@@ -0,0 +1,196 @@
+#include "../include/locallru/local_lru.hpp"
+#include "../src/csv_ingest.hpp"
+#include "../src/tick_file.hpp"
+#include "../src/tick_replay.hpp"
+#include "../src/udp_feed.hpp"
+#include "../src/wire_tick.hpp"
+#include "../bench/histogram.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace locallru;
+using namespace locallru::feed;
+using locallru::bench::LatencyHistogram;
+
+// Loopback market-data simulator. The sender replays data/*.csv (or
+// data/ticks.bin) as UDP datagrams at a configurable packet rate and burst
+// size; the receiver drains them with recvmmsg, decodes every tick and
+// applies it to a LocalCache, as a feed handler thread would.
+//
+//   ./udp_feed_demo [--role=both|send|recv] [--address=IP] [--port=N]
+//                   [--rate=PACKETS_PER_SEC] [--burst=N] [--ticks-per-packet=N]
+//                   [--batch=N] [--repeat=N]
+//
+// --role=both runs receiver and sender on two threads of one process;
+// send/recv run one side each so they can be started separately. A
+// multicast --address (e.g. 239.1.1.1) uses multicast on the loopback
+// interface instead of unicast.
+
+// Datetime,Open,High,Low,Close,Adj Close,Volume
+constexpr std::size_t kTimeColumn = 0;
+constexpr std::size_t kCloseColumn = 4;
+constexpr const char* kTickFilePath = "../data/ticks.bin";
+
+struct Options {
+    std::string role = "both";
+    UdpEndpoint endpoint;
+    SendOptions send;
+    std::size_t batch = 32;
+};
+
+struct ReceiveResult {
+    ReceiveStats stats;
+    LatencyHistogram one_way;     // Send timestamp to packet decoded
+    LatencyHistogram cache;       // Per-tick decode + LocalCache update
+    double seconds = 0.0;
+};
+
+static ReceiveResult receive(UdpReceiver& rx, const std::vector<std::string>& symbols, const std::atomic<bool>& stop) {
+    const SymbolTable table(symbols);
+    auto cache = LocalCache<double>::initialize(symbols.size(), 0);
+    ReceiveResult r;
+    auto on_packet = [&](const PacketHeader& h, std::span<const WireTick> ticks) {
+        r.one_way.record(static_cast<std::uint64_t>(std::max<std::int64_t>(0, steady_now_ns() - h.send_ns)));
+        for (const WireTick& w : ticks) {
+            auto t0 = steady_now_ns();
+            Tick t;
+            if (decode_tick(w, table, t)) cache.add_item(symbols[t.symbol], t.price);
+            r.cache.record(static_cast<std::uint64_t>(steady_now_ns() - t0));
+        }
+    };
+
+    // Wait up to 10 s for the first packet, polling in short slices so that
+    // `stop` is noticed, then stop at end of stream, when idle or on `stop`
+    const auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (rx.stats().packets == 0 && !stop.load(std::memory_order_relaxed) &&
+           std::chrono::steady_clock::now() < give_up) {
+        rx.poll(on_packet, std::chrono::milliseconds(100));
+    }
+    const std::int64_t first = steady_now_ns();
+    while (!stop.load(std::memory_order_relaxed) && rx.poll(on_packet, std::chrono::milliseconds(500))) {}
+    r.seconds = static_cast<double>(steady_now_ns() - first) / 1e9;
+    r.stats = rx.stats();
+    return r;
+}
+
+static void print_send(const SendStats& s) {
+    std::printf("sent     %10llu packets %10llu ticks in %.3f s (%.0f packets/s, %.1f packets per sendmmsg)\n",
+                static_cast<unsigned long long>(s.packets), static_cast<unsigned long long>(s.ticks), s.seconds,
+                static_cast<double>(s.packets) / s.seconds,
+                static_cast<double>(s.packets) / static_cast<double>(std::max<std::uint64_t>(1, s.send_calls)));
+}
+
+static void print_receive(const ReceiveResult& r) {
+    const auto& s = r.stats;
+    std::printf("received %10llu packets %10llu ticks, lost %llu, malformed %llu (%.1f packets per recvmmsg)\n",
+                static_cast<unsigned long long>(s.packets), static_cast<unsigned long long>(s.ticks),
+                static_cast<unsigned long long>(s.lost), static_cast<unsigned long long>(s.malformed),
+                static_cast<double>(s.packets) / static_cast<double>(std::max<std::uint64_t>(1, s.recv_calls)));
+    std::printf("  %-22s %9s %9s %9s %11s\n", "", "p50 ns", "p99 ns", "p99.9 ns", "max ns");
+    auto row = [](const char* name, const LatencyHistogram& h) {
+        std::printf("  %-22s %9llu %9llu %9llu %11llu\n", name, static_cast<unsigned long long>(h.percentile(0.50)),
+                    static_cast<unsigned long long>(h.percentile(0.99)),
+                    static_cast<unsigned long long>(h.percentile(0.999)), static_cast<unsigned long long>(h.max()));
+    };
+    row("send -> decode", r.one_way);
+    row("decode + cache update", r.cache);
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        if (std::strncmp(a, "--role=", 7) == 0) opt.role = a + 7;
+        else if (std::strncmp(a, "--address=", 10) == 0) opt.endpoint.address = a + 10;
+        else if (std::strncmp(a, "--port=", 7) == 0) opt.endpoint.port = static_cast<std::uint16_t>(std::atoi(a + 7));
+        else if (std::strncmp(a, "--rate=", 7) == 0) opt.send.packets_per_sec = std::strtod(a + 7, nullptr);
+        else if (std::strncmp(a, "--burst=", 8) == 0) opt.send.burst = std::strtoull(a + 8, nullptr, 10);
+        else if (std::strncmp(a, "--ticks-per-packet=", 19) == 0) opt.send.ticks_per_packet = std::strtoull(a + 19, nullptr, 10);
+        else if (std::strncmp(a, "--batch=", 8) == 0) opt.batch = std::strtoull(a + 8, nullptr, 10);
+        else if (std::strncmp(a, "--repeat=", 9) == 0) opt.send.repeat = std::max(1, std::atoi(a + 9));
+        else {
+            std::fprintf(stderr,
+                         "usage: %s [--role=both|send|recv] [--address=IP] [--port=N]\n"
+                         "          [--rate=PACKETS_PER_SEC] [--burst=N] [--ticks-per-packet=N]\n"
+                         "          [--batch=N] [--repeat=N]\n", argv[0]);
+            return 2;
+        }
+    }
+    const bool sending = opt.role == "both" || opt.role == "send";
+    const bool receiving = opt.role == "both" || opt.role == "recv";
+
+    std::vector<std::string> symbols = {"AAPL", "MSFT", "GOOG", "TSLA"};
+    try {
+        std::unique_ptr<UdpReceiver> rx;
+        if (receiving) rx = std::make_unique<UdpReceiver>(opt.endpoint, opt.batch); // Bound before anything is sent
+
+        std::vector<WireTick> wire;
+        if (sending) {
+            std::vector<TickSource> sources(symbols.size());
+            std::vector<TickColumns> parsed(symbols.size());
+            std::unique_ptr<TickFile> tick_file;
+            if (std::filesystem::exists(kTickFilePath)) {
+                tick_file = std::make_unique<TickFile>(kTickFilePath);
+                for (size_t i = 0; i < symbols.size(); i++) {
+                    if (auto* t = tick_file->find(symbols[i])) sources[i] = TickSource{t->prices, t->timestamps};
+                }
+            } else {
+                for (size_t i = 0; i < symbols.size(); i++) {
+                    parsed[i] = load_ticks("../data/" + symbols[i] + ".csv", kTimeColumn, kCloseColumn);
+                    sources[i] = TickSource{parsed[i].prices, TimestampColumn(parsed[i].timestamps)};
+                }
+            }
+            TickMerger merger(sources);
+            std::uint64_t seq = 0;
+            while (auto t = merger.next()) wire.push_back(encode_tick(symbols[t->symbol], *t, ++seq));
+        }
+
+        if (sending && receiving) {
+            ReceiveResult received;
+            std::exception_ptr rx_error;
+            std::atomic<bool> stop_receiving{false};
+            std::thread receiver([&] {
+                try {
+                    received = receive(*rx, symbols, stop_receiving);
+                } catch (...) {
+                    rx_error = std::current_exception();
+                }
+            });
+            SendStats sent;
+            try {
+                sent = send_ticks(opt.endpoint, wire, opt.send);
+            } catch (...) {
+                // A joinable std::thread must not be destroyed: stop and
+                // join the receiver before the error propagates
+                stop_receiving.store(true, std::memory_order_relaxed);
+                receiver.join();
+                throw;
+            }
+            receiver.join();
+            if (rx_error) std::rethrow_exception(rx_error);
+            print_send(sent);
+            print_receive(received);
+        } else if (sending) {
+            print_send(send_ticks(opt.endpoint, wire, opt.send));
+        } else {
+            std::printf("listening on %s:%u\n", opt.endpoint.address.c_str(), opt.endpoint.port);
+            const std::atomic<bool> never{false};
+            print_receive(receive(*rx, symbols, never));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
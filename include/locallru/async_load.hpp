@@ -0,0 +1,232 @@
+#pragma once
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "key_hash.hpp"
+
+// -----------------------------------------------------------------------------
+// async_load.hpp
+// C++20 coroutine read-through: co_await cache.get_or_load(key, loader).
+// -----------------------------------------------------------------------------
+// - get_or_load() returns an awaitable. On a hit it is ready at once and
+//   the coroutine never suspends. On a miss the coroutine suspends and the
+//   loader is started as loader(key, done) with a LoadCallback<V>; the
+//   loader begins its fetch (async I/O, a request to a backend thread) and
+//   returns, and whoever finishes the fetch calls done(value) - or
+//   done(std::nullopt) for "no such key", or done.fail(exception_ptr).
+// - Misses for a key whose load is still in flight join it instead of
+//   starting another: LoadJoiner keeps one pending load per key and
+//   resumes every waiter with a copy of its result.
+// - A loaded value is put in the cache before any waiter resumes, so
+//   requests that follow hit. Failures and nullopt are not cached; the
+//   next miss loads again.
+// - Waiters resume on the thread that calls done (inline if the loader
+//   completes before returning). LocalCache's joiner is thread-local like
+//   its store, so its loaders must complete on the calling thread, e.g.
+//   by posting done back to that thread's event loop; LockCache's accept
+//   any thread.
+// - LoadCallback is copyable (handy for std::function-based queues); the
+//   first call wins. If every copy is destroyed uncalled, waiters resume
+//   with an exception rather than hang.
+//
+//   auto v = co_await cache.get_or_load(symbol, [&](const std::string& key, auto done){
+//       backend.fetch_async(key, [done](std::optional<Book> b){ done(std::move(b)); });
+//   });
+// -----------------------------------------------------------------------------
+
+namespace locallru {
+
+    // Lock policy for a joiner that only one thread touches.
+    struct NoLock {
+        void lock() noexcept {}
+        void unlock() noexcept {}
+    };
+
+    namespace detail {
+        template<typename V>
+        class LoadCompletion {
+          public:
+            virtual ~LoadCompletion() = default;
+            virtual void finish(std::optional<V> value, std::exception_ptr error) = 0;
+        };
+
+        // One per loader call, shared by every LoadCallback copy; fails the
+        // load if the last copy goes away uncalled.
+        template<typename V>
+        struct LoadToken {
+            explicit LoadToken(std::shared_ptr<LoadCompletion<V>> c) : completion(std::move(c)) {}
+            LoadToken(const LoadToken&) = delete;
+            LoadToken& operator=(const LoadToken&) = delete;
+            ~LoadToken(){
+                if(!called.exchange(true, std::memory_order_acq_rel)) {
+                    completion->finish(std::nullopt, std::make_exception_ptr(std::runtime_error("loader dropped its callback")));
+                }
+            }
+
+            std::shared_ptr<LoadCompletion<V>> completion;
+            std::atomic<bool> called{false};
+        };
+    }
+
+    // Handed to a loader; call it exactly once with the result.
+    template<typename V>
+    class LoadCallback {
+      public:
+        explicit LoadCallback(std::shared_ptr<detail::LoadToken<V>> token) : token_(std::move(token)) {}
+
+        void operator()(std::optional<V> value) const { complete(std::move(value), nullptr); }
+        void fail(std::exception_ptr error) const { complete(std::nullopt, std::move(error)); }
+
+      private:
+        void complete(std::optional<V> value, std::exception_ptr error) const {
+            if(token_->called.exchange(true, std::memory_order_acq_rel)) return;
+            token_->completion->finish(std::move(value), std::move(error));
+        }
+
+        std::shared_ptr<detail::LoadToken<V>> token_;
+    };
+
+    // In-flight loads per key, and the awaitable that joins them.
+    template<typename K, typename V, typename Mutex = std::mutex>
+    class LoadJoiner {
+        struct Waiter {
+            static constexpr int kSuspending = 0, kSuspended = 1, kReady = 2;
+            std::coroutine_handle<> handle;
+            std::atomic<int> state{kSuspending};
+            std::optional<V> value;
+            std::exception_ptr error;
+        };
+
+        class Pending : public detail::LoadCompletion<V> {
+          public:
+            Pending(LoadJoiner& joiner, K key, std::function<void(const K&, const V&)> store)
+                : joiner_(joiner), key_(std::move(key)), store_(std::move(store)) {}
+
+            void finish(std::optional<V> value, std::exception_ptr error) override {
+                if(value && !error) store_(key_, *value);
+                std::vector<Waiter*> waiters;
+                {
+                    std::lock_guard<Mutex> lock(joiner_.mutex_);
+                    auto it = joiner_.pending_.find(key_);
+                    if(it != joiner_.pending_.end() && it->second.get() == this) joiner_.pending_.erase(it);
+                    waiters.swap(waiters_);
+                }
+                // A resumed waiter may destroy its frame, so each is only
+                // touched before its own resume
+                for(Waiter* w : waiters){
+                    w->value = value;
+                    w->error = error;
+                    if(w->state.exchange(Waiter::kReady, std::memory_order_acq_rel) == Waiter::kSuspended) w->handle.resume();
+                }
+            }
+
+          private:
+            friend class LoadJoiner;
+            LoadJoiner& joiner_;
+            K key_;
+            std::function<void(const K&, const V&)> store_;
+            std::vector<Waiter*> waiters_;   // Guarded by the joiner's mutex
+        };
+
+      public:
+        template<typename Loader>
+        class Awaiter {
+          public:
+            bool await_ready() const noexcept { return hit_; }
+
+            bool await_suspend(std::coroutine_handle<> h){
+                waiter_.handle = h;
+                std::shared_ptr<Pending> pending;
+                bool start = false;
+                {
+                    std::lock_guard<Mutex> lock(joiner_.mutex_);
+                    auto& slot = joiner_.pending_[key_];
+                    if(!slot) {
+                        slot = std::make_shared<Pending>(joiner_, key_, std::move(store_));
+                        start = true;
+                        joiner_.loads_++;
+                    } else {
+                        joiner_.joined_++;
+                    }
+                    slot->waiters_.push_back(&waiter_);
+                    pending = slot;
+                }
+                if(start) {
+                    auto token = std::make_shared<detail::LoadToken<V>>(pending);
+                    try {
+                        loader_(static_cast<const K&>(pending->key_), LoadCallback<V>(token));
+                    } catch(...) {
+                        LoadCallback<V>(token).fail(std::current_exception());
+                    }
+                }
+                return waiter_.state.exchange(Waiter::kSuspended, std::memory_order_acq_rel) != Waiter::kReady;
+            }
+
+            // The value, std::nullopt if the loader found none; rethrows a
+            // failed load.
+            std::optional<V> await_resume(){
+                if(waiter_.error) std::rethrow_exception(waiter_.error);
+                return std::move(waiter_.value);
+            }
+
+          private:
+            friend class LoadJoiner;
+            Awaiter(LoadJoiner& joiner, const K& key, std::optional<V> hit, Loader loader,
+                    std::function<void(const K&, const V&)> store)
+                : joiner_(joiner), key_(key), hit_(hit.has_value()), loader_(std::move(loader)), store_(std::move(store)) {
+                waiter_.value = std::move(hit);
+            }
+
+            LoadJoiner& joiner_;
+            K key_;
+            bool hit_;
+            Loader loader_;
+            std::function<void(const K&, const V&)> store_;
+            Waiter waiter_;
+        };
+
+        LoadJoiner() = default;
+        LoadJoiner(const LoadJoiner&) = delete;
+        LoadJoiner& operator=(const LoadJoiner&) = delete;
+
+        // hit is the cache's lookup result; store(key, value) puts a
+        // loaded value in the cache.
+        template<typename Loader>
+        Awaiter<std::decay_t<Loader>> await(const K& key, std::optional<V> hit, Loader&& loader,
+                                            std::function<void(const K&, const V&)> store){
+            return Awaiter<std::decay_t<Loader>>(*this, key, std::move(hit), std::forward<Loader>(loader), std::move(store));
+        }
+
+        std::size_t in_flight() const {
+            std::lock_guard<Mutex> lock(mutex_);
+            return pending_.size();
+        }
+
+        // Loads started, and misses that joined one already in flight.
+        std::uint64_t loads() const {
+            std::lock_guard<Mutex> lock(mutex_);
+            return loads_;
+        }
+
+        std::uint64_t joined() const {
+            std::lock_guard<Mutex> lock(mutex_);
+            return joined_;
+        }
+
+      private:
+        mutable Mutex mutex_;
+        std::unordered_map<K, std::shared_ptr<Pending>, KeyHash<K>, KeyEq<K>> pending_;
+        std::uint64_t loads_ = 0;
+        std::uint64_t joined_ = 0;
+    };
+}
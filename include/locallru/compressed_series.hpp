@@ -0,0 +1,508 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// -----------------------------------------------------------------------------
+// compressed_series.hpp
+// Long (timestamp, price) histories as a cache value, compressed with the
+// Gorilla scheme: delta-of-delta timestamps and XOR-encoded doubles.
+// -----------------------------------------------------------------------------
+// - Timestamps: the change in spacing between ticks is written with a
+//   prefix code: 1 bit when the spacing is unchanged, 9 bits for small
+//   changes and up to 69 for large ones. Changes are counted in the largest power
+//   of ten nanoseconds that the block's timestamps share, so second- or
+//   millisecond-aligned feeds get small codes.
+// - Prices: each double is XORed with the previous one. An unchanged price
+//   is 1 bit; otherwise only the differing middle bits are written, reusing
+//   the previous leading/trailing zero window when it fits.
+// - Decimal prices (e.g. 190.12) barely share mantissa bits, so blocks whose
+//   prices are exact decimals with up to 9 places store integer price
+//   changes in those units instead, with the same prefix code as timestamps.
+// - Points are grouped into blocks of up to BlockPoints that start from raw
+//   values, so a recent window is decoded from its block onwards instead of
+//   from the start of history. A point that does not fit the block's time
+//   unit or decimal places starts a new block. Full blocks are shrunk to
+//   size.
+// - At least MaxPoints of the most recent points are kept; the oldest block
+//   is dropped once the rest still hold MaxPoints.
+// - for_each() decodes one point at a time. decode() parses a block into
+//   raw changes first and rebuilds the values with prefix sums / XORs,
+//   which use AVX2 or SSE2 when available.
+//
+//   auto cache = LocalCache<CompressedSeries<100000>>::initialize(1000, 0);
+//   cache.upsert_item("AAPL", [&](auto& s){ s.append(ts, price); });
+//   cache.read_item("AAPL", [&](const auto& s){ s.decode(ts_out, px_out, 5000); });
+// -----------------------------------------------------------------------------
+
+namespace locallru {
+
+    namespace simd {
+        // In-place inclusive prefix sum / prefix XOR over n 64-bit values.
+        inline void prefix_sum(std::int64_t* x, std::size_t n){
+            std::size_t i = 0;
+#if defined(__AVX2__)
+            const __m256i zero = _mm256_setzero_si256();
+            __m256i carry = zero;
+            for(; i + 4 <= n; i += 4){
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+                v = _mm256_add_epi64(v, _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0x90), zero, 0x03));
+                v = _mm256_add_epi64(v, _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0x40), zero, 0x0F));
+                v = _mm256_add_epi64(v, carry);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(x + i), v);
+                carry = _mm256_permute4x64_epi64(v, 0xFF);
+            }
+#elif defined(__SSE2__)
+            // Two pairs per step: each pair's own prefix, the second pair
+            // offset by the first's total, then the running carry, so the
+            // loop-carried chain is one add and one shuffle per 4 values
+            __m128i carry = _mm_setzero_si128();
+            for(; i + 4 <= n; i += 4){
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i + 2));
+                a = _mm_add_epi64(a, _mm_slli_si128(a, 8));
+                b = _mm_add_epi64(b, _mm_slli_si128(b, 8));
+                b = _mm_add_epi64(b, _mm_shuffle_epi32(a, 0xEE));
+                a = _mm_add_epi64(a, carry);
+                b = _mm_add_epi64(b, carry);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(x + i), a);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(x + i + 2), b);
+                carry = _mm_shuffle_epi32(b, 0xEE);
+            }
+#endif
+            for(i = i ? i : 1; i < n; i++) x[i] += x[i - 1];
+        }
+
+        inline void prefix_xor(std::uint64_t* x, std::size_t n){
+            std::size_t i = 0;
+#if defined(__AVX2__)
+            const __m256i zero = _mm256_setzero_si256();
+            __m256i carry = zero;
+            for(; i + 4 <= n; i += 4){
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+                v = _mm256_xor_si256(v, _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0x90), zero, 0x03));
+                v = _mm256_xor_si256(v, _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0x40), zero, 0x0F));
+                v = _mm256_xor_si256(v, carry);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(x + i), v);
+                carry = _mm256_permute4x64_epi64(v, 0xFF);
+            }
+#elif defined(__SSE2__)
+            __m128i carry = _mm_setzero_si128();
+            for(; i + 4 <= n; i += 4){
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i + 2));
+                a = _mm_xor_si128(a, _mm_slli_si128(a, 8));
+                b = _mm_xor_si128(b, _mm_slli_si128(b, 8));
+                b = _mm_xor_si128(b, _mm_shuffle_epi32(a, 0xEE));
+                a = _mm_xor_si128(a, carry);
+                b = _mm_xor_si128(b, carry);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(x + i), a);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(x + i + 2), b);
+                carry = _mm_shuffle_epi32(b, 0xEE);
+            }
+#endif
+            for(i = i ? i : 1; i < n; i++) x[i] ^= x[i - 1];
+        }
+    }
+
+    template<std::size_t MaxPoints, std::size_t BlockPoints = 512>
+    class CompressedSeries {
+        static_assert(MaxPoints > 0 && BlockPoints > 1, "CompressedSeries needs room for at least one point");
+
+      public:
+        std::size_t size() const noexcept { return count_; }
+        bool empty() const noexcept { return count_ == 0; }
+
+        // Latest point; series must not be empty
+        std::int64_t timestamp() const noexcept { return prev_ts_; }
+        double price() const noexcept { return std::bit_cast<double>(prev_bits_); }
+
+        // Heap and object bytes held, including unused capacity of the block
+        // being written.
+        std::size_t bytes() const noexcept {
+            std::size_t total = sizeof(*this);
+            for(const Block& b : blocks_) total += sizeof(Block) + b.words.capacity() * sizeof(std::uint64_t);
+            return total;
+        }
+
+        void append(std::int64_t ts_ns, double price){
+            const std::uint64_t bits = std::bit_cast<std::uint64_t>(price);
+            if(blocks_.empty() || blocks_.back().count == BlockPoints || !try_encode(blocks_.back(), ts_ns, price, bits))
+                start_block(ts_ns, price, bits);
+            blocks_.back().count++;
+            prev_ts_ = ts_ns;
+            prev_bits_ = bits;
+            count_++;
+            if(count_ - blocks_.front().count >= MaxPoints) {
+                count_ -= blocks_.front().count;
+                blocks_.pop_front();
+            }
+        }
+
+        void clear() noexcept {
+            blocks_.clear();
+            count_ = 0;
+        }
+
+        // Calls fn(ts_ns, price) for the `last` most recent points (clamped
+        // to size()), oldest first, decoding one point at a time.
+        template<typename F>
+        void for_each(F&& fn, std::size_t last = std::numeric_limits<std::size_t>::max()) const {
+            std::size_t skip = 0;
+            const std::size_t first = first_block(last, skip);
+            for(std::size_t b = first; b < blocks_.size(); b++){
+                Reader r(blocks_[b]);
+                for(std::uint32_t i = 0; i < blocks_[b].count; i++){
+                    r.next();
+                    if(skip) {
+                        skip--;
+                        continue;
+                    }
+                    fn(r.ts, r.price());
+                }
+            }
+        }
+
+        // Decodes the `last` most recent points (clamped to size()), oldest
+        // first, into ts / prices (resized). Returns the number of points.
+        std::size_t decode(std::vector<std::int64_t>& ts, std::vector<double>& prices,
+                           std::size_t last = std::numeric_limits<std::size_t>::max()) const {
+            std::size_t skip = 0;
+            const std::size_t first = first_block(last, skip);
+            std::size_t total = 0;
+            for(std::size_t b = first; b < blocks_.size(); b++) total += blocks_[b].count;
+            ts.resize(total);
+            prices.resize(total);
+            std::vector<std::uint64_t> scratch(BlockPoints);
+            std::size_t at = 0;
+            for(std::size_t b = first; b < blocks_.size(); b++){
+                decode_block(blocks_[b], ts.data() + at, prices.data() + at, scratch.data());
+                at += blocks_[b].count;
+            }
+            if(skip) {
+                ts.erase(ts.begin(), ts.begin() + static_cast<std::ptrdiff_t>(skip));
+                prices.erase(prices.begin(), prices.begin() + static_cast<std::ptrdiff_t>(skip));
+            }
+            return ts.size();
+        }
+
+      private:
+        static constexpr std::uint32_t kNoWindow = 0xFF;
+        static constexpr int kXorPrices = -1;
+        static constexpr int kMaxDecimals = 9;
+        static constexpr double kMaxScaled = 9007199254740992.0; // 2^53
+
+        // Field bits for control codes 0, 10, 110, 1110, 11110, 11111
+        static constexpr unsigned kFieldBits[6] = {0, 7, 12, 20, 32, 64};
+
+        static constexpr std::int64_t pow10(int e){
+            std::int64_t v = 1;
+            while(e-- > 0) v *= 10;
+            return v;
+        }
+
+        // Bit stream, most significant bit first within each word.
+        struct Block {
+            std::vector<std::uint64_t> words;
+            std::size_t bits = 0;
+            std::uint32_t count = 0;
+            std::int64_t ts_unit = 1;         // ns per timestamp unit
+            std::int8_t decimals = kXorPrices;
+
+            // Appends the low n bits of v, n in 1..64.
+            void put(std::uint64_t v, unsigned n){
+                if(n < 64) v &= (std::uint64_t{1} << n) - 1;
+                const unsigned off = static_cast<unsigned>(bits % 64);
+                if(off == 0) words.push_back(0);
+                const unsigned free = 64 - off;
+                if(n <= free) {
+                    words.back() |= v << (free - n);
+                } else {
+                    words.back() |= v >> (n - free);
+                    words.push_back(v << (64 - (n - free)));
+                }
+                bits += n;
+            }
+
+            // Prefix-coded signed integer: 0 as one bit, then the shortest
+            // field that holds v.
+            void put_int(std::int64_t v){
+                if(v == 0) {
+                    put(0, 1);
+                    return;
+                }
+                for(unsigned code = 1; code < 5; code++){
+                    const std::int64_t lim = std::int64_t{1} << (kFieldBits[code] - 1);
+                    if(v >= -lim && v < lim) {
+                        put((std::uint64_t{1} << (code + 1)) - 2, code + 1);   // `code` ones, then a zero
+                        put(static_cast<std::uint64_t>(v), kFieldBits[code]);
+                        return;
+                    }
+                }
+                put(0x1F, 5);
+                put(static_cast<std::uint64_t>(v), 64);
+            }
+        };
+
+        class Reader {
+          public:
+            explicit Reader(const Block& b)
+                : words_(b.words.data()), nwords_(b.words.size()), unit_(b.ts_unit), decimals_(b.decimals),
+                  scale_(static_cast<double>(pow10(std::max(0, static_cast<int>(b.decimals))))) {}
+
+            // Current point after next()
+            std::int64_t ts = 0;
+            std::uint64_t bits = 0;       // XOR blocks
+            std::int64_t scaled = 0;      // Decimal blocks
+            double price() const { return decimals_ == kXorPrices ? std::bit_cast<double>(bits) : static_cast<double>(scaled) / scale_; }
+
+            // Raw changes read by next_raw(): delta-of-delta in ns, and the
+            // price XOR or scaled price change. The first point of a block
+            // yields its raw timestamp and price instead.
+            std::int64_t dod = 0;
+            std::uint64_t change = 0;
+
+            void next_raw(){
+                if(first_) {
+                    first_ = false;
+                    dod = static_cast<std::int64_t>(get(64));
+                    change = get(64);
+                    if(decimals_ != kXorPrices) change = static_cast<std::uint64_t>(std::llround(std::bit_cast<double>(change) * scale_));
+                    return;
+                }
+                bool raw = false;
+                dod = get_int(raw);
+                if(!raw) dod *= unit_;
+                if(decimals_ != kXorPrices) {
+                    change = static_cast<std::uint64_t>(get_int(raw));
+                    return;
+                }
+                const std::uint64_t w = peek();
+                if(!(w >> 63)) {
+                    pos_ += 1;
+                    change = 0;
+                    return;
+                }
+                if(w >> 62 & 1) {
+                    leading_ = static_cast<unsigned>(w >> 57 & 31);
+                    const unsigned len = static_cast<unsigned>(w >> 51 & 63);
+                    meaningful_ = len ? len : 64;
+                    trailing_ = 64 - leading_ - meaningful_;
+                    pos_ += 13;
+                } else {
+                    pos_ += 2;
+                }
+                change = get(meaningful_) << trailing_;
+            }
+
+            // Streaming decode: advances ts and the price to the next point.
+            void next(){
+                const bool first = first_;
+                next_raw();
+                if(first) {
+                    ts = dod;
+                    bits = scaled = 0;
+                    if(decimals_ == kXorPrices) bits = change;
+                    else scaled = static_cast<std::int64_t>(change);
+                    return;
+                }
+                delta_ += dod;
+                ts += delta_;
+                if(decimals_ == kXorPrices) bits ^= change;
+                else scaled += static_cast<std::int64_t>(change);
+            }
+
+          private:
+            // Prefix-coded integer (Block::put_int). A code and its field are
+            // taken from one 64-bit peek; `raw` is set for the 64-bit escape.
+            std::int64_t get_int(bool& raw){
+                const std::uint64_t w = peek();
+                const unsigned ones = std::min(5u, static_cast<unsigned>(std::countl_one(w)));
+                raw = ones == 5;
+                if(raw) {
+                    pos_ += 5;
+                    return static_cast<std::int64_t>(get(64));
+                }
+                // Branch-free over the common codes; a 0-bit field yields 0
+                const unsigned n = kFieldBits[ones];
+                pos_ += ones + 1 + n;
+                const std::int64_t v = static_cast<std::int64_t>(w << (ones + 1)) >> (63 - n) >> 1;
+                return n ? v : 0;
+            }
+
+            // Next 64 bits of the stream, zero-padded past the end
+            std::uint64_t peek() const {
+                const std::size_t w = pos_ / 64;
+                const unsigned off = static_cast<unsigned>(pos_ % 64);
+                std::uint64_t v = words_[w] << off;
+                if(off && w + 1 < nwords_) v |= words_[w + 1] >> (64 - off);
+                return v;
+            }
+
+            // Reads n bits, n in 1..64
+            std::uint64_t get(unsigned n){
+                const std::uint64_t v = peek() >> (64 - n);
+                pos_ += n;
+                return v;
+            }
+
+            const std::uint64_t* words_;
+            std::size_t nwords_;
+            std::int64_t unit_;
+            int decimals_;
+            double scale_;
+            std::size_t pos_ = 0;
+            bool first_ = true;
+            std::int64_t delta_ = 0;
+            unsigned leading_ = 0;
+            unsigned meaningful_ = 64;
+            unsigned trailing_ = 0;
+        };
+
+        // Scaled integer for price at `decimals` places, if it converts back
+        // to exactly the same double (bit for bit, so -0.0 stays XOR-coded).
+        static bool to_scaled(double price, int decimals, std::int64_t& out){
+            const double scale = static_cast<double>(pow10(decimals));
+            const double v = std::nearbyint(price * scale);
+            if(!(std::fabs(v) < kMaxScaled)) return false;
+            out = static_cast<std::int64_t>(v);
+            return std::bit_cast<std::uint64_t>(static_cast<double>(out) / scale) == std::bit_cast<std::uint64_t>(price);
+        }
+
+        void start_block(std::int64_t ts_ns, double price, std::uint64_t bits){
+            if(!blocks_.empty()) blocks_.back().words.shrink_to_fit();
+            Block& b = blocks_.emplace_back();
+            b.put(static_cast<std::uint64_t>(ts_ns), 64);
+            b.put(bits, 64);
+            for(int e = 9; e > 0; e--){
+                if(ts_ns % pow10(e) == 0) {
+                    b.ts_unit = pow10(e);
+                    break;
+                }
+            }
+            for(int d = 0; d <= kMaxDecimals; d++){
+                if(to_scaled(price, d, prev_scaled_)) {
+                    b.decimals = static_cast<std::int8_t>(d);
+                    break;
+                }
+            }
+            prev_delta_ = 0;
+            prev_leading_ = kNoWindow;
+        }
+
+        // Appends the point to b; false (and nothing written) if it does not
+        // fit the block's time unit or decimal places.
+        bool try_encode(Block& b, std::int64_t ts_ns, double price, std::uint64_t bits){
+            const std::int64_t delta = ts_ns - prev_ts_;
+            const std::int64_t dod = delta - prev_delta_;
+            std::int64_t scaled = 0;
+            if(dod % b.ts_unit != 0) return false;
+            if(b.decimals != kXorPrices && !to_scaled(price, b.decimals, scaled)) return false;
+
+            prev_delta_ = delta;
+            const std::int64_t units = dod / b.ts_unit;
+            const std::int64_t lim = std::int64_t{1} << (kFieldBits[4] - 1);
+            if(units >= -lim && units < lim) {
+                b.put_int(units);
+            } else {
+                b.put(0x1F, 5);                                  // Out of range: raw ns
+                b.put(static_cast<std::uint64_t>(dod), 64);
+            }
+
+            if(b.decimals != kXorPrices) {
+                b.put_int(scaled - prev_scaled_);
+                prev_scaled_ = scaled;
+            } else {
+                encode_xor(b, bits);
+            }
+            return true;
+        }
+
+        void encode_xor(Block& b, std::uint64_t bits){
+            const std::uint64_t x = bits ^ prev_bits_;
+            if(x == 0) {
+                b.put(0, 1);
+                return;
+            }
+            const unsigned leading = std::min(31u, static_cast<unsigned>(std::countl_zero(x)));
+            const unsigned trailing = static_cast<unsigned>(std::countr_zero(x));
+            if(prev_leading_ != kNoWindow && leading >= prev_leading_ && trailing >= prev_trailing_) {
+                b.put(0b10, 2);
+                b.put(x >> prev_trailing_, 64 - prev_leading_ - prev_trailing_);
+                return;
+            }
+            const unsigned meaningful = 64 - leading - trailing;
+            b.put(0b11, 2);
+            b.put(leading, 5);
+            b.put(meaningful & 63, 6);   // 64 is written as 0
+            b.put(x >> trailing, meaningful);
+            prev_leading_ = leading;
+            prev_trailing_ = trailing;
+        }
+
+        // Index of the first block holding the `last` most recent points, and
+        // the number of its points to skip.
+        std::size_t first_block(std::size_t last, std::size_t& skip) const {
+            std::size_t want = std::min(last, count_);
+            skip = 0;
+            std::size_t b = blocks_.size();
+            while(want && b > 0){
+                const std::size_t n = blocks_[--b].count;
+                if(n >= want) {
+                    skip = n - want;
+                    return b;
+                }
+                want -= n;
+            }
+            return b;
+        }
+
+        // Two passes: parse the bit stream into raw changes, then rebuild
+        // timestamps with two prefix sums and prices with a prefix XOR (or a
+        // prefix sum of scaled prices).
+        static void decode_block(const Block& block, std::int64_t* ts, double* prices, std::uint64_t* scratch){
+            const std::size_t n = block.count;
+            Reader r(block);
+            for(std::size_t i = 0; i < n; i++){
+                r.next_raw();
+                ts[i] = r.dod;
+                scratch[i] = r.change;
+            }
+            const std::int64_t t0 = ts[0];
+            ts[0] = 0;
+            simd::prefix_sum(ts, n);    // Deltas
+            ts[0] = t0;
+            simd::prefix_sum(ts, n);    // Timestamps
+
+            if(block.decimals == kXorPrices) {
+                simd::prefix_xor(scratch, n);
+                std::memcpy(prices, scratch, n * sizeof(double));
+                return;
+            }
+            auto* scaled = reinterpret_cast<std::int64_t*>(scratch);
+            simd::prefix_sum(scaled, n);
+            const double scale = static_cast<double>(pow10(block.decimals));
+            for(std::size_t i = 0; i < n; i++) prices[i] = static_cast<double>(scaled[i]) / scale;
+        }
+
+        std::deque<Block> blocks_;
+        std::size_t count_ = 0;
+        // Encoder state for the block being written
+        std::int64_t prev_ts_ = 0;
+        std::int64_t prev_delta_ = 0;
+        std::uint64_t prev_bits_ = 0;
+        std::int64_t prev_scaled_ = 0;
+        std::uint32_t prev_leading_ = kNoWindow;
+        std::uint32_t prev_trailing_ = 0;
+    };
+}
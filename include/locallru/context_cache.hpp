@@ -0,0 +1,195 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "async_load.hpp"
+#include "local_lru.hpp"
+
+// -----------------------------------------------------------------------------
+// context_cache.hpp
+// Caches keyed to executor contexts (the workers of a scheduler) instead of
+// OS threads, for coroutine and fiber workloads where a task can resume on
+// a different thread than it started on.
+// -----------------------------------------------------------------------------
+// - ExecutorContext stands for one worker: at most one task runs on it at a
+//   time, whatever thread that is. The scheduler enters it with a Scope
+//   around each stretch of work; entering a context that is already entered
+//   on another thread throws, so two threads can never share a store.
+// - ContextCache<T> owns one LruStore per context, each on its own cache
+//   lines. on(ctx) returns a Handle to ctx's store with the LocalCache item
+//   API; access is lock-free, because only the code running on ctx uses it.
+// - Under migration the rule is: get the handle after every suspension
+//   point, never keep one across it. Ideally the scheduler hands the task
+//   its context on resumption; local() looks the context up instead,
+//   through ExecutorContext::current(), which is kept out of line so a
+//   coroutine cannot reuse a thread-local address computed before it
+//   moved threads.
+// - Unlike LocalCache, stores belong to the cache object, not to threads:
+//   several caches of one T can coexist, stores outlive the threads that
+//   used them and are freed with the cache, and a context may run on a
+//   different thread each time it is entered.
+// - get_or_load() joins misses per context (see async_load.hpp); the
+//   loader's done must be called on the same context.
+// - The all-context operations (size_all, clear_all) are only safe while
+//   no context is entered.
+//
+//   std::vector<ExecutorContext> workers;           // one per worker thread
+//   for(std::size_t i = 0; i < n; i++) workers.emplace_back(i);
+//   ContextCache<Book> books(n, 10'000, 60);
+//   // worker i's loop:  ExecutorContext::Scope s(workers[i]);  run tasks
+//   // in a task:        books.local().add_item("AAPL", book);
+// -----------------------------------------------------------------------------
+
+namespace locallru {
+
+    class ExecutorContext {
+      public:
+        explicit ExecutorContext(std::size_t index) : index_(index) {}
+
+        ExecutorContext(const ExecutorContext&) = delete;
+        ExecutorContext& operator=(const ExecutorContext&) = delete;
+        ExecutorContext(ExecutorContext&& o) noexcept : index_(o.index_) {}
+
+        std::size_t index() const noexcept { return index_; }
+        bool entered() const noexcept { return entered_.load(std::memory_order_relaxed); }
+
+        // Context the calling thread is running, or null.
+        [[gnu::noinline]] static ExecutorContext* current() noexcept { return current_ref(); }
+
+        // Marks ctx as running on this thread until destroyed; nests.
+        class Scope {
+          public:
+            explicit Scope(ExecutorContext& ctx) : ctx_(ctx), previous_(current_ref()) {
+                if(ctx_.entered_.exchange(true, std::memory_order_acquire)) {
+                    throw std::logic_error("ExecutorContext " + std::to_string(ctx_.index_) + " is already entered");
+                }
+                current_ref() = &ctx_;
+            }
+
+            ~Scope(){
+                current_ref() = previous_;
+                ctx_.entered_.store(false, std::memory_order_release);
+            }
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+          private:
+            ExecutorContext& ctx_;
+            ExecutorContext* previous_;
+        };
+
+      private:
+        [[gnu::noinline]] static ExecutorContext*& current_ref() noexcept {
+            static thread_local ExecutorContext* current = nullptr;
+            return current;
+        }
+
+        std::size_t index_;
+        std::atomic<bool> entered_{false};
+    };
+
+    template<typename T>
+    class ContextCache {
+        struct alignas(64) Slot {
+            Slot(std::size_t capacity, std::uint64_t ttl_seconds) : store(capacity, ttl_seconds) {}
+            LruStore<std::string, T> store;
+            LoadJoiner<std::string, T, NoLock> loads;
+        };
+
+      public:
+        using key_type = std::string;
+        using value_type = T;
+
+        // One context's store; cheap to copy, valid as long as the cache.
+        class Handle {
+          public:
+            void add_item(const key_type& key, value_type value){ slot_->store.put(key, std::move(value)); }
+            std::optional<value_type> get_item(const key_type& key){ return slot_->store.get(key); }
+
+            template<typename F>
+            bool read_item(const key_type& key, F&& fn){ return slot_->store.read(key, std::forward<F>(fn)); }
+
+            template<typename F>
+            bool update_item(const key_type& key, F&& fn){ return slot_->store.update(key, std::forward<F>(fn)); }
+
+            template<typename F>
+            void upsert_item(const key_type& key, F&& fn){ slot_->store.upsert(key, std::forward<F>(fn)); }
+
+            std::size_t get_items(std::span<const key_type> keys, std::span<std::optional<value_type>> out){
+                return slot_->store.get_many(keys, out);
+            }
+
+            bool remove_item(const key_type& key){ return slot_->store.erase(key); }
+
+            template<typename Loader>
+            auto get_or_load(const key_type& key, Loader&& loader){
+                Slot* slot = slot_;
+                return slot->loads.await(key, slot->store.get(key), std::forward<Loader>(loader),
+                                         [slot](const key_type& k, const value_type& v){ slot->store.put(k, v); });
+            }
+
+            const LoadJoiner<key_type, value_type, NoLock>& pending_loads() const noexcept { return slot_->loads; }
+
+            std::size_t size() const { return slot_->store.size(); }
+            std::size_t capacity() const { return slot_->store.capacity(); }
+            std::uint64_t ttl_seconds() const { return slot_->store.ttl_seconds(); }
+            void clear(){ slot_->store.clear(); }
+
+            // The context's store, for snapshot() / restore() in snapshot.hpp.
+            LruStore<std::string, T>& backing_store() const noexcept { return slot_->store; }
+
+          private:
+            friend class ContextCache;
+            explicit Handle(Slot* slot) : slot_(slot) {}
+            Slot* slot_;
+        };
+
+        // Stores for contexts 0 .. contexts-1, each with capacity entries.
+        ContextCache(std::size_t contexts, std::size_t capacity, std::uint64_t ttl_seconds){
+            if(contexts == 0) throw std::invalid_argument("ContextCache: contexts must be > 0");
+            slots_.reserve(contexts);
+            for(std::size_t i = 0; i < contexts; i++) slots_.push_back(std::make_unique<Slot>(capacity, ttl_seconds));
+        }
+
+        ContextCache(const ContextCache&) = delete;
+        ContextCache& operator=(const ContextCache&) = delete;
+
+        Handle on(const ExecutorContext& ctx){ return on(ctx.index()); }
+
+        Handle on(std::size_t index){
+            if(index >= slots_.size()) throw std::out_of_range("ContextCache: no context " + std::to_string(index));
+            return Handle(slots_[index].get());
+        }
+
+        // Store of the context entered on the calling thread.
+        Handle local(){
+            const ExecutorContext* ctx = ExecutorContext::current();
+            if(!ctx) throw std::logic_error("ContextCache::local() outside an ExecutorContext::Scope");
+            return on(*ctx);
+        }
+
+        std::size_t contexts() const noexcept { return slots_.size(); }
+
+        std::size_t size_all() const {
+            std::size_t n = 0;
+            for(const auto& s : slots_) n += s->store.size();
+            return n;
+        }
+
+        void clear_all(){
+            for(auto& s : slots_) s->store.clear();
+        }
+
+      private:
+        std::vector<std::unique_ptr<Slot>> slots_;
+    };
+}
@@ -0,0 +1,384 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// -----------------------------------------------------------------------------
+// io_uring.hpp
+// Minimal io_uring over the raw syscalls (no liburing dependency), used by
+// the cache server and the spill tier to batch many I/O operations into one
+// io_uring_enter.
+// -----------------------------------------------------------------------------
+// - IoUring owns one ring: sqe() hands out submission entries, submit()
+//   submits everything queued and optionally waits for completions in the
+//   same syscall, and for_each_cqe() consumes completions without any.
+// - BufferRing is a group of provided buffers (a registered buffer ring,
+//   or PROVIDE_BUFFERS where rings do not work): the kernel picks a buffer
+//   per completion, which is what lets one multishot recv serve a
+//   connection for its whole life.
+// - register_buffers() registers fixed buffers for READ_FIXED/WRITE_FIXED,
+//   saving the per-operation page pinning.
+// - Each ring is used by one thread. Counters report how many syscalls the
+//   ring made, for comparing against plain syscalls.
+// - io_uring_supported() probes once whether the kernel allows rings at all
+//   (it may be disabled by sysctl or seccomp); callers with
+//   IoBackend::automatic fall back to plain syscalls otherwise.
+// -----------------------------------------------------------------------------
+
+namespace locallru {
+
+    enum class IoBackend {
+        automatic,   // io_uring if the kernel allows it, else posix
+        posix,       // epoll + recv/send, pread/pwrite
+        io_uring
+    };
+
+    inline const char* to_string(IoBackend b){
+        switch(b){
+        case IoBackend::automatic: return "automatic";
+        case IoBackend::posix: return "posix";
+        case IoBackend::io_uring: return "io_uring";
+        }
+        return "?";
+    }
+
+    // "auto"/"automatic", "posix" or "io_uring"; false for anything else.
+    inline bool parse_io_backend(std::string_view s, IoBackend& out){
+        if(s == "auto" || s == "automatic") out = IoBackend::automatic;
+        else if(s == "posix") out = IoBackend::posix;
+        else if(s == "io_uring") out = IoBackend::io_uring;
+        else return false;
+        return true;
+    }
+
+    class IoUring {
+      public:
+        explicit IoUring(unsigned entries, unsigned flags = 0){
+            io_uring_params p{};
+            p.flags = flags;
+            fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+            if(fd_ < 0) throw std::system_error(errno, std::generic_category(), "io_uring_setup");
+            try {
+                map(p);
+            } catch(...) {
+                unmap();
+                ::close(fd_);
+                throw;
+            }
+        }
+
+        IoUring(const IoUring&) = delete;
+        IoUring& operator=(const IoUring&) = delete;
+        ~IoUring(){
+            unmap();
+            ::close(fd_);
+        }
+
+        int fd() const noexcept { return fd_; }
+        std::uint64_t enters() const noexcept { return enters_; }
+
+        // Next submission entry, zeroed. Submits what is queued first if the
+        // submission queue is full.
+        io_uring_sqe* sqe(){
+            if(sq_tail_ - std::atomic_ref<unsigned>(*sq_head_).load(std::memory_order_acquire) >= sq_entries_) submit(0);
+            const unsigned index = sq_tail_ & sq_mask_;
+            io_uring_sqe* e = &sqes_[index];
+            std::memset(e, 0, sizeof(*e));
+            sq_array_[index] = index;
+            sq_tail_++;
+            return e;
+        }
+
+        // Submits queued entries and waits until at least wait_nr
+        // completions are available, in one syscall. Returns entries
+        // submitted.
+        unsigned submit(unsigned wait_nr = 0){
+            const unsigned to_submit = sq_tail_ - submitted_;
+            std::atomic_ref<unsigned>(*sq_ktail_).store(sq_tail_, std::memory_order_release);
+            if(to_submit == 0 && wait_nr == 0) return 0;
+            for(;;){
+                const long r = ::syscall(__NR_io_uring_enter, fd_, to_submit, wait_nr, wait_nr ? IORING_ENTER_GETEVENTS : 0u,
+                                         nullptr, 0);
+                enters_++;
+                if(r >= 0) {
+                    submitted_ += static_cast<unsigned>(r);
+                    return static_cast<unsigned>(r);
+                }
+                if(errno == EINTR) {
+                    if(wait_nr) return 0; // Let the caller look at its completions
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "io_uring_enter");
+            }
+        }
+
+        // Calls fn(const io_uring_cqe&) for each available completion and
+        // marks them consumed; returns how many there were.
+        template<typename F>
+        unsigned for_each_cqe(F&& fn){
+            unsigned head = *cq_head_;
+            const unsigned tail = std::atomic_ref<unsigned>(*cq_tail_).load(std::memory_order_acquire);
+            const unsigned n = tail - head;
+            for(; head != tail; head++){
+                const io_uring_cqe c = cqes_[head & cq_mask_]; // The slot is reusable once head moves
+                std::atomic_ref<unsigned>(*cq_head_).store(head + 1, std::memory_order_release);
+                fn(c);
+            }
+            return n;
+        }
+
+        // Registers buffers for READ_FIXED / WRITE_FIXED (buf_index = i).
+        void register_buffers(const iovec* iov, unsigned n){
+            if(::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_BUFFERS, iov, n) < 0) {
+                throw std::system_error(errno, std::generic_category(), "IORING_REGISTER_BUFFERS");
+            }
+        }
+
+        int register_raw(unsigned opcode, void* arg, unsigned n){
+            return static_cast<int>(::syscall(__NR_io_uring_register, fd_, opcode, arg, n));
+        }
+
+      private:
+        void map(const io_uring_params& p){
+            sq_bytes_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+            cq_bytes_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+            const bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+            if(single) sq_bytes_ = cq_bytes_ = std::max(sq_bytes_, cq_bytes_);
+            sq_ring_ = ::mmap(nullptr, sq_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+            if(sq_ring_ == MAP_FAILED) {
+                sq_ring_ = nullptr;
+                throw std::system_error(errno, std::generic_category(), "mmap io_uring sq");
+            }
+            if(single) {
+                cq_ring_ = sq_ring_;
+            } else {
+                cq_ring_ = ::mmap(nullptr, cq_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+                if(cq_ring_ == MAP_FAILED) {
+                    cq_ring_ = nullptr;
+                    throw std::system_error(errno, std::generic_category(), "mmap io_uring cq");
+                }
+            }
+            sqes_bytes_ = p.sq_entries * sizeof(io_uring_sqe);
+            void* s = ::mmap(nullptr, sqes_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+            if(s == MAP_FAILED) throw std::system_error(errno, std::generic_category(), "mmap io_uring sqes");
+            sqes_ = static_cast<io_uring_sqe*>(s);
+
+            auto* sq = static_cast<char*>(sq_ring_);
+            auto* cq = static_cast<char*>(cq_ring_);
+            sq_head_ = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+            sq_ktail_ = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+            sq_mask_ = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+            sq_entries_ = p.sq_entries;
+            sq_array_ = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+            sq_tail_ = submitted_ = *sq_ktail_;
+            cq_head_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+            cq_tail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+            cq_mask_ = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+            cqes_ = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+        }
+
+        void unmap() noexcept {
+            if(sqes_) ::munmap(sqes_, sqes_bytes_);
+            if(cq_ring_ && cq_ring_ != sq_ring_) ::munmap(cq_ring_, cq_bytes_);
+            if(sq_ring_) ::munmap(sq_ring_, sq_bytes_);
+            sqes_ = nullptr;
+            sq_ring_ = cq_ring_ = nullptr;
+        }
+
+        int fd_ = -1;
+        void* sq_ring_ = nullptr;
+        void* cq_ring_ = nullptr;
+        std::size_t sq_bytes_ = 0;
+        std::size_t cq_bytes_ = 0;
+        std::size_t sqes_bytes_ = 0;
+        io_uring_sqe* sqes_ = nullptr;
+        unsigned* sq_head_ = nullptr;
+        unsigned* sq_ktail_ = nullptr;
+        unsigned* sq_array_ = nullptr;
+        unsigned sq_mask_ = 0;
+        unsigned sq_entries_ = 0;
+        unsigned sq_tail_ = 0;        // Local tail, published by submit()
+        unsigned submitted_ = 0;
+        unsigned* cq_head_ = nullptr;
+        unsigned* cq_tail_ = nullptr;
+        unsigned cq_mask_ = 0;
+        io_uring_cqe* cqes_ = nullptr;
+        std::uint64_t enters_ = 0;
+    };
+
+    namespace detail {
+        // Whether a registered buffer ring actually hands out buffers: some
+        // kernels and sandboxes accept the registration yet fail every
+        // selection with -ENOBUFS. Probed once with a one-byte pipe read.
+        inline bool buffer_ring_works(){
+            static const bool works = []{
+                int p[2] = {-1, -1};
+                if(::pipe(p) != 0) return false;
+                bool ok = false;
+                try {
+                    IoUring ring(2);
+                    alignas(4096) static char page[4096];
+                    static char byte[1];
+                    auto* mem = reinterpret_cast<io_uring_buf_ring*>(page);
+                    io_uring_buf_reg reg{};
+                    reg.ring_addr = reinterpret_cast<std::uint64_t>(mem);
+                    reg.ring_entries = 1;
+                    reg.bgid = 0;
+                    if(ring.register_raw(IORING_REGISTER_PBUF_RING, &reg, 1) == 0) {
+                        mem->bufs[0].addr = reinterpret_cast<std::uint64_t>(byte);
+                        mem->bufs[0].len = 1;
+                        mem->bufs[0].bid = 0;
+                        std::atomic_ref<std::uint16_t>(mem->tail).store(1, std::memory_order_release);
+                        if(::write(p[1], "x", 1) == 1) {
+                            io_uring_sqe* e = ring.sqe();
+                            e->opcode = IORING_OP_READ;
+                            e->fd = p[0];
+                            e->flags = IOSQE_BUFFER_SELECT;
+                            e->buf_group = 0;
+                            ring.submit(1);
+                            ring.for_each_cqe([&](const io_uring_cqe& c){ ok = c.res == 1; });
+                        }
+                        ring.register_raw(IORING_UNREGISTER_PBUF_RING, &reg, 1);
+                    }
+                } catch(const std::system_error&) {
+                }
+                ::close(p[0]);
+                ::close(p[1]);
+                return ok;
+            }();
+            return works;
+        }
+    }
+
+    // Provided buffers for one buffer group: count buffers of size bytes
+    // each (count a power of two). Completions carry the buffer id, and the
+    // consumer hands the buffer back with recycle() once done with it.
+    // Uses a registered buffer ring (Linux 5.19) where it works, else the
+    // older IORING_OP_PROVIDE_BUFFERS: recycling then costs an SQE (no CQE)
+    // that goes out with the next submit, but still no syscall of its own.
+    class BufferRing {
+      public:
+        BufferRing(IoUring& ring, std::uint16_t group, unsigned count, std::size_t size)
+            : ring_(ring), group_(group), count_(count), size_(size) {
+            data_ = static_cast<char*>(::mmap(nullptr, count * size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+            if(data_ == MAP_FAILED) throw std::system_error(errno, std::generic_category(), "mmap buffers");
+            if(!detail::buffer_ring_works()) {
+                provide(0, count);
+                return;
+            }
+            ring_bytes_ = count * sizeof(io_uring_buf);
+            void* r = ::mmap(nullptr, ring_bytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(r == MAP_FAILED) {
+                const int err = errno;
+                ::munmap(data_, count * size);
+                throw std::system_error(err, std::generic_category(), "mmap buffer ring");
+            }
+            ring_mem_ = static_cast<io_uring_buf_ring*>(r);
+            io_uring_buf_reg reg{};
+            reg.ring_addr = reinterpret_cast<std::uint64_t>(ring_mem_);
+            reg.ring_entries = count;
+            reg.bgid = group;
+            if(ring_.register_raw(IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+                const int err = errno;
+                ::munmap(data_, count * size);
+                ::munmap(ring_mem_, ring_bytes_);
+                throw std::system_error(err, std::generic_category(), "IORING_REGISTER_PBUF_RING");
+            }
+            for(unsigned i = 0; i < count; i++) add(static_cast<std::uint16_t>(i));
+            publish();
+        }
+
+        BufferRing(const BufferRing&) = delete;
+        BufferRing& operator=(const BufferRing&) = delete;
+        ~BufferRing(){
+            if(ring_mem_) {
+                io_uring_buf_reg reg{};
+                reg.bgid = group_;
+                ring_.register_raw(IORING_UNREGISTER_PBUF_RING, &reg, 1);
+                ::munmap(ring_mem_, ring_bytes_);
+            }
+            ::munmap(data_, count_ * size_);
+        }
+
+        std::uint16_t group() const noexcept { return group_; }
+        bool registered_ring() const noexcept { return ring_mem_ != nullptr; }
+        const char* data(std::uint16_t id) const noexcept { return data_ + static_cast<std::size_t>(id) * size_; }
+
+        // Returns a buffer to the kernel.
+        void recycle(std::uint16_t id){
+            if(!ring_mem_) {
+                provide(id, 1);
+                return;
+            }
+            add(id);
+            publish();
+        }
+
+      private:
+        void add(std::uint16_t id){
+            io_uring_buf& b = ring_mem_->bufs[tail_ & (count_ - 1)];
+            b.addr = reinterpret_cast<std::uint64_t>(data_ + static_cast<std::size_t>(id) * size_);
+            b.len = static_cast<std::uint32_t>(size_);
+            b.bid = id;
+            tail_++;
+        }
+
+        void publish(){
+            std::atomic_ref<std::uint16_t>(ring_mem_->tail).store(tail_, std::memory_order_release);
+        }
+
+        // Buffers [first, first + n) back to the group; user_data 0, and a
+        // completion only on failure.
+        void provide(unsigned first, unsigned n){
+            io_uring_sqe* e = ring_.sqe();
+            e->opcode = IORING_OP_PROVIDE_BUFFERS;
+            e->fd = static_cast<int>(n);
+            e->addr = reinterpret_cast<std::uint64_t>(data_ + static_cast<std::size_t>(first) * size_);
+            e->len = static_cast<std::uint32_t>(size_);
+            e->off = first;
+            e->buf_group = group_;
+            e->flags = IOSQE_CQE_SKIP_SUCCESS;
+        }
+
+        IoUring& ring_;
+        std::uint16_t group_;
+        unsigned count_;
+        std::size_t size_;
+        std::size_t ring_bytes_ = 0;
+        io_uring_buf_ring* ring_mem_ = nullptr;   // Null: PROVIDE_BUFFERS mode
+        char* data_ = nullptr;
+        std::uint16_t tail_ = 0;
+    };
+
+    // Whether io_uring rings can be created here; probed once.
+    inline bool io_uring_supported(){
+        static const bool supported = []{
+            try {
+                IoUring probe(2);
+                return true;
+            } catch(const std::system_error&) {
+                return false;
+            }
+        }();
+        return supported;
+    }
+
+    // Resolves automatic to what this kernel supports.
+    inline IoBackend resolve(IoBackend b){
+        if(b == IoBackend::automatic) return io_uring_supported() ? IoBackend::io_uring : IoBackend::posix;
+        return b;
+    }
+}
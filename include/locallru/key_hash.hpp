@@ -0,0 +1,128 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// -----------------------------------------------------------------------------
+// key_hash.hpp
+// Hashing and equality for keys made of several values, so they can be used
+// as they are instead of being formatted into one std::string.
+// -----------------------------------------------------------------------------
+// - Composite keys are std::tuple, std::pair, and structured keys: types
+//   with a key_fields() member returning a tuple of their fields (usually
+//   std::tie). Their hash combines the hashes of the fields with
+//   hash_combine(), recursively; equality compares them field by field.
+// - KeyHash<K> and KeyEq<K> are the LruStore / LocalCache defaults. For
+//   ordinary types they are std::hash and std::equal_to. For composite and
+//   string keys they are transparent: a key can be looked up from a view
+//   of it without building a K, e.g. a std::string key from a
+//   std::string_view or literal, and a (symbol, venue, field) key from a
+//   std::tuple<std::string_view, std::string_view, Field>.
+// - A view must have the key's structure, with a field of the same type
+//   as the key's or, for std::string fields, anything convertible to
+//   std::string_view; other substitutes may hash differently and miss.
+// - Specialise KeyHash for your own leaf types, or std::hash as usual.
+//
+//   struct QuoteKey {
+//       std::string symbol, venue;
+//       Field field;
+//       auto key_fields() const { return std::tie(symbol, venue, field); }
+//   };
+//   LocalCache<double, QuoteKey> quotes;
+//   quotes.add_item(QuoteKey{"AAPL", "XNAS", Field::bid}, 187.5);
+//   auto bid = quotes.get_item(std::tuple{std::string_view(sym), std::string_view(venue), Field::bid});
+// -----------------------------------------------------------------------------
+
+namespace locallru {
+
+    // Mixes h into seed. 64-bit variant of boost::hash_combine, with an
+    // extra multiply so that small integer fields spread over all bits.
+    inline std::size_t hash_combine(std::size_t seed, std::size_t h) noexcept {
+        std::uint64_t x = static_cast<std::uint64_t>(seed) ^ (static_cast<std::uint64_t>(h) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+        x ^= x >> 32;
+        x *= 0xd6e8feb86659fd93ULL;
+        x ^= x >> 32;
+        return static_cast<std::size_t>(x);
+    }
+
+    namespace detail {
+        template<typename T>
+        struct is_tuple_like : std::false_type {};
+
+        template<typename... Ts>
+        struct is_tuple_like<std::tuple<Ts...>> : std::true_type {};
+
+        template<typename A, typename B>
+        struct is_tuple_like<std::pair<A, B>> : std::true_type {};
+
+        template<typename T>
+        concept StringLike = std::is_convertible_v<const T&, std::string_view>;
+
+        template<typename T>
+        concept StructuredKey = requires(const T& key){ key.key_fields(); }
+                                && is_tuple_like<std::remove_cvref_t<decltype(std::declval<const T&>().key_fields())>>::value;
+
+        template<typename T>
+        concept CompositeKey = is_tuple_like<T>::value || StructuredKey<T>;
+
+        // Whether an A can stand in for a key field of type Field.
+        template<typename Field, typename A>
+        concept is_field_view = std::is_same_v<std::remove_cvref_t<A>, Field>
+                                || (std::is_same_v<Field, std::string> && StringLike<std::remove_cvref_t<A>>);
+
+        // The tuple a key is compared and hashed as.
+        template<typename T>
+        decltype(auto) key_view(const T& key){
+            if constexpr (StructuredKey<T>) return key.key_fields();
+            else return (key);
+        }
+    }
+
+    template<typename T>
+    std::size_t hash_key(const T& key);
+
+    template<typename T>
+    struct KeyHash : std::hash<T> {};
+
+    template<typename T>
+    struct KeyEq : std::equal_to<T> {};
+
+    template<typename T>
+        requires (detail::CompositeKey<T> || std::is_same_v<T, std::string>)
+    struct KeyHash<T> {
+        using is_transparent = void;
+        template<typename Q>
+        std::size_t operator()(const Q& key) const { return hash_key(key); }
+    };
+
+    template<typename T>
+        requires (detail::CompositeKey<T> || std::is_same_v<T, std::string>)
+    struct KeyEq<T> {
+        using is_transparent = void;
+        template<typename A, typename B>
+        bool operator()(const A& a, const B& b) const { return detail::key_view(a) == detail::key_view(b); }
+    };
+
+    // Hash of a key or of a view of one; KeyHash of leaf types otherwise.
+    template<typename T>
+    std::size_t hash_key(const T& key){
+        if constexpr (detail::StringLike<T>) {
+            return std::hash<std::string_view>{}(std::string_view(key));
+        } else if constexpr (detail::StructuredKey<T>) {
+            return hash_key(key.key_fields());
+        } else if constexpr (detail::is_tuple_like<T>::value) {
+            return std::apply([](const auto&... field){
+                std::size_t seed = sizeof...(field);
+                ((seed = hash_combine(seed, hash_key(field))), ...);
+                return seed;
+            }, key);
+        } else {
+            return KeyHash<T>{}(key);
+        }
+    }
+}
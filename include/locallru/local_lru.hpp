@@ -5,9 +5,16 @@
 #include <chrono>
 #include <optional>
 #include <utility>
+#include <algorithm>
 #include <string>
 #include <atomic>
 #include <memory>
+#include <span>
+#include <type_traits>
+#include <functional>
+
+#include "async_load.hpp"
+#include "key_hash.hpp"
 
 // -----------------------------------------------------------------------------
 // local_lru.hpp
@@ -57,13 +64,30 @@ namespace locallru {
     // A single-thread store implementing LRU with TTL.
     // Not thread-safe across threads (by design) but safe for single-thread use.
     // Managed behind thread_local in LocalCache<T>.
+    // Hash and KeyEqual are as for std::unordered_map. The defaults (see
+    // key_hash.hpp) also cover tuple and structured keys, and let get,
+    // read, update and erase take a view of the key (e.g. std::string_view)
+    // instead of a key_type.
     
-    template<typename K, typename V>
+    template<typename K, typename V, typename Hash = KeyHash<K>, typename KeyEqual = KeyEq<K>>
     class LruStore{
       public:
         using key_type = K;
         using value_type = V;
+        using hasher = Hash;
+        using key_equal = KeyEqual;
         using time_point = Clock::time_point;
+        // Receives entries evicted for capacity (not expired or erased ones),
+        // with their value moved out and their absolute expiry.
+        using EvictionHandler = std::function<void(const key_type&, value_type&&, time_point)>;
+        
+        // Whether Q can be looked up without converting it to key_type:
+        // Hash and KeyEqual are transparent and accept it.
+        template<typename Q>
+        static constexpr bool is_key_view = !std::is_same_v<std::remove_cvref_t<Q>, key_type>
+            && requires { typename Hash::is_transparent; typename KeyEqual::is_transparent; }
+            && std::is_invocable_r_v<std::size_t, const Hash&, const Q&>
+            && std::is_invocable_r_v<bool, const KeyEqual&, const key_type&, const Q&>;
         
         explicit LruStore(std::size_t capacity, std::uint64_t ttl_seconds) 
             : capacity_(capacity), ttl_seconds_(ttl_seconds) {}
@@ -84,24 +108,36 @@ namespace locallru {
         }
         
         std::optional<value_type> get(const key_type &key){
-            const auto now = Clock::now();
-            auto it = map_.find(key);
-            if(it == map_.end()) return std::nullopt;
-            if (is_expired(it->second, now)) {
-                erase_it(it);
-                return std::nullopt;
-            }
-            touch(it);
-            return it->second.value;
+            return get(key, Clock::now());
+        }
+        
+        // As get(key), but evaluates expiry against a caller-supplied time.
+        // Lets benchmarks and replays drive TTLs from a virtual clock.
+        std::optional<value_type> get(const key_type &key, time_point now){
+            return lookup(key, now);
+        }
+        
+        // get() from a view of the key; nothing is converted or allocated.
+        template<typename Q> requires is_key_view<Q>
+        std::optional<value_type> get(const Q& key){
+            return lookup(key, Clock::now());
+        }
+        
+        template<typename Q> requires is_key_view<Q>
+        std::optional<value_type> get(const Q& key, time_point now){
+            return lookup(key, now);
         }
         
         void put(const key_type& key, value_type value){
-            const auto now = Clock::now();
+            put(key, std::move(value), Clock::now());
+        }
+        
+        void put(const key_type& key, value_type value, time_point now){
             if(capacity_ == 0) return; // No capacity to store
             
             auto it = map_.find(key);
             if(it != map_.end()){
-                it->second.value = value;
+                it->second.value = std::move(value);
                 it->second.expiry = expiry_from(now);
                 touch(it);
                 return;
@@ -118,10 +154,142 @@ namespace locallru {
         }
         
         bool erase(const key_type &key){
+            return erase_as(key);
+        }
+        
+        template<typename Q> requires is_key_view<Q>
+        bool erase(const Q& key){
+            return erase_as(key);
+        }
+        
+        // Installs (or, with an empty handler, removes) the callback run on
+        // each capacity eviction, e.g. to spill values to a second tier.
+        void set_eviction_handler(EvictionHandler handler){
+            on_evict_ = std::move(handler);
+        }
+        
+        // Presizes the index for n entries (e.g. before a bulk load).
+        void reserve(std::size_t n){
+            map_.reserve(std::min(n, capacity_));
+        }
+        
+        // As put(), but with an absolute expiry instead of now + TTL. Used
+        // to restore entries with the TTL they had left.
+        // One hash lookup per call, as bulk loads are dominated by them.
+        void put_until(const key_type& key, value_type value, time_point expiry){
+            if(capacity_ == 0) return;
+            auto [it, inserted] = map_.try_emplace(key, std::move(value), expiry, lru_.end());
+            if(!inserted){
+                it->second.value = std::move(value);
+                it->second.expiry = expiry;
+                touch(it);
+                return;
+            }
+            lru_.push_front(key);
+            it->second.lru_it = lru_.begin();
+            while(map_.size() > capacity_) {
+                evict_one();
+            }
+        }
+        
+        // Calls fn(key, value, expiry) for every unexpired entry, least
+        // recently used first, without touching them. expiry is
+        // time_point::max() when the store has no TTL.
+        template<typename F>
+        void for_each_lru(F&& fn) const {
+            for_each_lru(std::forward<F>(fn), Clock::now());
+        }
+        
+        template<typename F>
+        void for_each_lru(F&& fn, time_point now) const {
+            for(auto it = lru_.rbegin(); it != lru_.rend(); ++it){
+                const Node& n = map_.find(*it)->second;
+                if(is_expired(n, now)) continue;
+                fn(static_cast<const key_type&>(*it), static_cast<const value_type&>(n.value), n.expiry);
+            }
+        }
+        
+        // In-place access: fn receives a reference to the stored value, so
+        // large values (series, buffers) are never copied in or out.
+        // read() calls fn(const V&) and counts as a get; update() calls
+        // fn(V&) on a live entry and, like put(), refreshes its TTL. Both
+        // return false (without calling fn) on a miss.
+        template<typename F>
+        bool read(const key_type& key, F&& fn){
+            return read(key, std::forward<F>(fn), Clock::now());
+        }
+        
+        template<typename F>
+        bool read(const key_type& key, F&& fn, time_point now){
+            return read_as(key, std::forward<F>(fn), now);
+        }
+        
+        template<typename Q, typename F> requires is_key_view<Q>
+        bool read(const Q& key, F&& fn){
+            return read_as(key, std::forward<F>(fn), Clock::now());
+        }
+        
+        template<typename Q, typename F> requires is_key_view<Q>
+        bool read(const Q& key, F&& fn, time_point now){
+            return read_as(key, std::forward<F>(fn), now);
+        }
+        
+        template<typename F>
+        bool update(const key_type& key, F&& fn){
+            return update(key, std::forward<F>(fn), Clock::now());
+        }
+        
+        template<typename F>
+        bool update(const key_type& key, F&& fn, time_point now){
+            return update_as(key, std::forward<F>(fn), now);
+        }
+        
+        template<typename Q, typename F> requires is_key_view<Q>
+        bool update(const Q& key, F&& fn){
+            return update_as(key, std::forward<F>(fn), Clock::now());
+        }
+        
+        template<typename Q, typename F> requires is_key_view<Q>
+        bool update(const Q& key, F&& fn, time_point now){
+            return update_as(key, std::forward<F>(fn), now);
+        }
+        
+        // As update(), but a missing or expired key is first (re)created
+        // with a value-initialised V. Does nothing if capacity is 0.
+        template<typename F>
+        void upsert(const key_type& key, F&& fn){
+            upsert(key, std::forward<F>(fn), Clock::now());
+        }
+        
+        template<typename F>
+        void upsert(const key_type& key, F&& fn, time_point now){
+            if(capacity_ == 0) return;
             auto it = map_.find(key);
-            if(it == map_.end()) return false;
-            erase_it(it);
-            return true;
+            if(it != map_.end()){
+                if(is_expired(it->second, now)) it->second.value = value_type{};
+                fn(it->second.value);
+                it->second.expiry = expiry_from(now);
+                touch(it);
+                return;
+            }
+            while(map_.size() >= capacity_) {
+                evict_one();
+            }
+            lru_.push_front(key);
+            auto inserted = map_.emplace(key, Node{value_type{}, expiry_from(now), lru_.begin()}).first;
+            fn(inserted->second.value);
+        }
+        
+        // Looks up keys[i] into out[i] (out.size() must be >= keys.size()).
+        // Returns the number of hits. Same semantics as repeated get().
+        std::size_t get_many(std::span<const key_type> keys, std::span<std::optional<value_type>> out){
+            const auto now = Clock::now();
+            std::size_t hits = 0;
+            for(std::size_t i = 0; i < keys.size(); i++){
+                out[i] = get(keys[i], now);
+                if(out[i]) hits++;
+            }
+            return hits;
         }
         
         
@@ -132,13 +300,61 @@ namespace locallru {
             typename std::list<key_type>::iterator lru_it;
         };
         
-        using Map = std::unordered_map<key_type, Node>;
+        using Map = std::unordered_map<key_type, Node, Hash, KeyEqual>;
         
         bool is_expired(const Node& n, time_point now) const {
             if(ttl_seconds_ == 0) return false;
             return now > n.expiry;
         }
         
+        // Iterator to a present, unexpired entry; expired entries are
+        // removed on the way, as in get(). Q is key_type or a key view.
+        template<typename Q>
+        typename Map::iterator find_live(const Q& key, time_point now){
+            auto it = map_.find(key);
+            if(it == map_.end()) return it;
+            if(is_expired(it->second, now)) {
+                erase_it(it);
+                return map_.end();
+            }
+            return it;
+        }
+        
+        template<typename Q>
+        std::optional<value_type> lookup(const Q& key, time_point now){
+            auto it = find_live(key, now);
+            if(it == map_.end()) return std::nullopt;
+            touch(it);
+            return it->second.value;
+        }
+        
+        template<typename Q, typename F>
+        bool read_as(const Q& key, F&& fn, time_point now){
+            auto it = find_live(key, now);
+            if(it == map_.end()) return false;
+            touch(it);
+            fn(static_cast<const value_type&>(it->second.value));
+            return true;
+        }
+        
+        template<typename Q, typename F>
+        bool update_as(const Q& key, F&& fn, time_point now){
+            auto it = find_live(key, now);
+            if(it == map_.end()) return false;
+            fn(it->second.value);
+            it->second.expiry = expiry_from(now);
+            touch(it);
+            return true;
+        }
+        
+        template<typename Q>
+        bool erase_as(const Q& key){
+            auto it = map_.find(key);
+            if(it == map_.end()) return false;
+            erase_it(it);
+            return true;
+        }
+        
         time_point expiry_from(time_point now) const {
             if (ttl_seconds_ == 0) return time_point::max();
             return now + Seconds(static_cast<long long>(ttl_seconds_));
@@ -150,18 +366,14 @@ namespace locallru {
             it->second.lru_it = lru_.begin();
         }
         
+        // Unlinks the LRU entry before the handler sees it, so a handler
+        // that throws cannot leave a moved-from value behind as a hit.
         void evict_one() {
             if(lru_.empty()) return;
             auto last_it = std::prev(lru_.end()); // lru_.end() is a sentinel iterator (points past the last element)
-            auto key = *last_it;
-            auto it = map_.find(key);
-            if (it != map_.end()) {
-                lru_.erase(it->second.lru_it);
-                map_.erase(it);
-            } else {
-                // Should not happen; Keep structure consistent
-                lru_.erase(last_it);
-            }
+            auto node = map_.extract(*last_it);
+            lru_.erase(last_it);
+            if(node && on_evict_) on_evict_(node.key(), std::move(node.mapped().value), node.mapped().expiry);
         }
         
         void erase_it(typename Map::iterator it) {
@@ -173,18 +385,23 @@ namespace locallru {
         std::uint64_t ttl_seconds_ = 0; // 0 => No expiry
         std::list<key_type> lru_; // front = most-recent, back = least-recent
         Map map_;
+        EvictionHandler on_evict_;
     };
     
     // High-level API similar to the Rust crate: LocalCache<T>.
     // - Thread-local store per type T per thread.
     // - initialize(capacity, ttl) sets *global* defaults for yet-to-be-created
     //   thread-local stores and returns a lightweight handle.
+    // - K is the key type, std::string by default. Composite keys (tuples,
+    //   structured keys, see key_hash.hpp) avoid formatting a string per
+    //   lookup; LocalCache<T, K> has its own stores and defaults.
     
-    template<typename T>
+    template<typename T, typename K = std::string>
     class LocalCache {
         public:
-            using key_type = std::string;
+            using key_type = K;
             using value_type = T;
+            using Store = LruStore<key_type, value_type>;
             
             // Set global defaults for future thread-local stores of this T.
             // Returns a lightweight handle (stateless) for calling add/get.
@@ -204,11 +421,70 @@ namespace locallru {
                 return store().get(key);
             }
             
+            // As get_item, from a view of the key such as std::string_view
+            // or a tuple of views (see key_hash.hpp); builds no key_type.
+            template<typename Q> requires Store::template is_key_view<Q>
+            std::optional<value_type> get_item(const Q& key){
+                return store().get(key);
+            }
+            
+            // In-place access to the stored value (see LruStore::read /
+            // update / upsert); avoids copying large values per call
+            template<typename F>
+            bool read_item(const key_type& key, F&& fn){
+                return store().read(key, std::forward<F>(fn));
+            }
+            
+            template<typename Q, typename F> requires Store::template is_key_view<Q>
+            bool read_item(const Q& key, F&& fn){
+                return store().read(key, std::forward<F>(fn));
+            }
+            
+            template<typename F>
+            bool update_item(const key_type& key, F&& fn){
+                return store().update(key, std::forward<F>(fn));
+            }
+            
+            template<typename Q, typename F> requires Store::template is_key_view<Q>
+            bool update_item(const Q& key, F&& fn){
+                return store().update(key, std::forward<F>(fn));
+            }
+            
+            template<typename F>
+            void upsert_item(const key_type& key, F&& fn){
+                store().upsert(key, std::forward<F>(fn));
+            }
+            
+            // Batch lookup into out[i]; returns the number of hits
+            std::size_t get_items(std::span<const key_type> keys, std::span<std::optional<value_type>> out){
+                return store().get_many(keys, out);
+            }
+            
             // Remove an Item; returns true if removed
             bool remove_item(const key_type& key){
                 return store().erase(key);
             }
             
+            template<typename Q> requires Store::template is_key_view<Q>
+            bool remove_item(const Q& key){
+                return store().erase(key);
+            }
+            
+            // co_await get_or_load(key, loader): the value at once on a hit;
+            // on a miss suspends while loader(key, done) fetches it, joining
+            // a load of the same key already in flight on this thread (see
+            // async_load.hpp). done must be called on this thread.
+            template<typename Loader>
+            auto get_or_load(const key_type& key, Loader&& loader){
+                return loads().await(key, store().get(key), std::forward<Loader>(loader),
+                                     [](const key_type& k, const value_type& v){ store().put(k, v); });
+            }
+            
+            // This thread's in-flight loads
+            const LoadJoiner<key_type, value_type, NoLock>& pending_loads() const {
+                return loads();
+            }
+            
             
             // Introspection (current thread only)
             std::size_t size() const {
@@ -227,8 +503,17 @@ namespace locallru {
                 store().clear();
             }
             
+            // This thread's store, for snapshot() / restore() in
+            // snapshot.hpp.
+            Store& backing_store() const {
+                return store();
+            }
+            
         private:
-            using Store = LruStore<key_type, value_type>;
+            static LoadJoiner<key_type, value_type, NoLock>& loads(){
+                static thread_local LoadJoiner<key_type, value_type, NoLock> joiner;
+                return joiner;
+            }
             
             static Store& store(){
                 if(!ttl_store_){
@@ -243,12 +528,12 @@ namespace locallru {
     };      
     
     // Static Definitions
-    template <typename T>
-    std::atomic<std::size_t> LocalCache<T>::g_capacity{0};
+    template <typename T, typename K>
+    std::atomic<std::size_t> LocalCache<T, K>::g_capacity{0};
 
-    template <typename T>
-    std::atomic<std::uint64_t> LocalCache<T>::g_ttl_seconds{0};
+    template <typename T, typename K>
+    std::atomic<std::uint64_t> LocalCache<T, K>::g_ttl_seconds{0};
     
-    template <typename T>
-    thread_local std::unique_ptr<typename LocalCache<T>::Store> LocalCache<T>::ttl_store_{};
+    template <typename T, typename K>
+    thread_local std::unique_ptr<typename LocalCache<T, K>::Store> LocalCache<T, K>::ttl_store_{};
 }
\ No newline at end of file
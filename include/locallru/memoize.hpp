@@ -0,0 +1,124 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "key_hash.hpp"
+#include "local_lru.hpp"
+
+// -----------------------------------------------------------------------------
+// memoize.hpp
+// Memoization of a pure free function in an LruStore keyed by its
+// arguments.
+// -----------------------------------------------------------------------------
+// - memoize<&fn>(capacity, ttl_seconds) returns a Memoized<&fn>, callable
+//   like fn. The key is std::tuple of fn's parameter types with references
+//   and cv dropped, hashed by KeyHash (key_hash.hpp) and compared
+//   field-wise: no string is formatted or hashed per call, and a hit
+//   copies no argument.
+// - A hit returns a copy of the cached result; a miss calls fn with the key
+//   fields and caches what it returns. The same LRU and TTL rules as
+//   LruStore apply.
+// - Like LruStore, a Memoized is for one thread. Give each thread its own,
+//   e.g. as a static thread_local, or wrap one in a lock.
+// - fn must be a function (or a pointer to one) that returns a value and
+//   whose parameters are values or const references; results must not
+//   depend on anything but the arguments.
+//
+//   double implied_vol(const std::string& symbol, int strike, double price);
+//   static thread_local auto vol = memoize<&implied_vol>(10'000, 5);
+//   double v = vol("AAPL", 190, 2.35);
+// -----------------------------------------------------------------------------
+
+namespace locallru {
+
+    namespace detail {
+        template<typename F>
+        struct FunctionTraits;
+
+        template<typename R, typename... Args>
+        struct FunctionTraits<R(*)(Args...)> {
+            using result_type = R;
+            using key_type = std::tuple<std::remove_cvref_t<Args>...>;
+        };
+
+        template<typename R, typename... Args>
+        struct FunctionTraits<R(*)(Args...) noexcept> : FunctionTraits<R(*)(Args...)> {};
+    }
+
+    template<auto Fn>
+    class Memoized {
+        using Traits = detail::FunctionTraits<std::decay_t<decltype(Fn)>>;
+
+      public:
+        using key_type = typename Traits::key_type;
+        using value_type = std::remove_cvref_t<typename Traits::result_type>;
+        using Store = LruStore<key_type, value_type>;
+
+        static_assert(!std::is_void_v<value_type>, "memoize: fn must return a value");
+
+        Memoized(std::size_t capacity, std::uint64_t ttl_seconds) : store_(capacity, ttl_seconds) {}
+
+        template<typename... A>
+        value_type operator()(A&&... args){
+            // Hits are looked up through a tuple of references to the
+            // arguments when they can stand in for the key's fields, so a
+            // hit copies no argument
+            constexpr bool by_view = views_key<A...>(std::make_index_sequence<std::tuple_size_v<key_type>>{});
+            if constexpr (by_view) {
+                if(auto v = store_.get(std::forward_as_tuple(std::as_const(args)...))) {
+                    hits_++;
+                    return std::move(*v);
+                }
+            }
+            key_type key(std::forward<A>(args)...);
+            if constexpr (!by_view) {
+                if(auto v = store_.get(key)) {
+                    hits_++;
+                    return std::move(*v);
+                }
+            }
+            misses_++;
+            value_type v = std::apply(Fn, std::as_const(key));
+            store_.put(key, v);
+            return v;
+        }
+
+        // Drops the cached result for these arguments, e.g. after the data
+        // behind them changed.
+        template<typename... A>
+        bool forget(A&&... args){
+            return store_.erase(key_type(std::forward<A>(args)...));
+        }
+
+        std::uint64_t hits() const noexcept { return hits_; }
+        std::uint64_t misses() const noexcept { return misses_; }
+
+        Store& store() noexcept { return store_; }
+        const Store& store() const noexcept { return store_; }
+
+      private:
+        // Whether arguments of types A hash and compare like the key's
+        // fields (see key_hash.hpp).
+        template<typename... A, std::size_t... I>
+        static constexpr bool views_key(std::index_sequence<I...>){
+            if constexpr (sizeof...(A) != sizeof...(I)) {
+                return false;
+            } else {
+                return (detail::is_field_view<std::tuple_element_t<I, key_type>, A> && ...);
+            }
+        }
+
+        Store store_;
+        std::uint64_t hits_ = 0;
+        std::uint64_t misses_ = 0;
+    };
+
+    template<auto Fn>
+    Memoized<Fn> memoize(std::size_t capacity, std::uint64_t ttl_seconds = 0){
+        return Memoized<Fn>(capacity, ttl_seconds);
+    }
+}
@@ -0,0 +1,315 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "local_lru.hpp"
+
+// -----------------------------------------------------------------------------
+// near_cache.hpp
+// Read-through / write-through LocalCache in front of a remote key-value
+// store, kept fresh by the remote's change notifications.
+// -----------------------------------------------------------------------------
+// - Remote is any client with
+//     std::optional<V> get(const std::string&)
+//     void put(const std::string&, const V&)
+//     bool erase(const std::string&)
+//     void subscribe(std::function<void(const std::string&)>)
+//   where subscribe() registers the invalidation subscriber: the remote
+//   calls it, from whatever thread its change stream runs on, with each
+//   key changed by any client. InProcessRemote below is a stand-in with a
+//   configurable round trip.
+//   The subscription refers to the NearCache, so the remote must stop
+//   notifying before the NearCache is destroyed.
+// - Thread-local copies cannot be touched from the notifying thread, so
+//   notifications go to an InvalidationLog: a bounded ring of changed keys
+//   behind an atomic sequence number. Every NearCache call first compares
+//   its thread's cursor with the sequence (one atomic load when nothing
+//   changed) and erases whatever keys were published since. A thread that
+//   fell more than the ring's capacity behind clears its copy instead.
+// - So once the subscriber has seen a change, no thread reads the old value
+//   any more: staleness is bounded by the notification delay, not by TTL.
+//   The TTL of the LocalCache is a backstop for notifications that never
+//   arrive; invalidate_all() is the one for a reconnected stream that may
+//   have lost some.
+// - A remote read racing a change of the same key is returned but not
+//   cached, so the old value cannot be cached after its invalidation has
+//   already been applied.
+// - The copies are LocalCache<V>'s thread-local stores, so there should be
+//   one NearCache per V at a time; a thread that meets a new one clears
+//   its copy first.
+//
+//   InProcessRemote<std::string> remote(std::chrono::microseconds(50));
+//   LocalCache<std::string>::initialize(100'000, 300);
+//   NearCache<std::string, InProcessRemote<std::string>> near(remote);
+//   near.put("cfg:limits", text);             // remote, then local
+//   auto v = near.get("cfg:limits");          // local, else remote
+// -----------------------------------------------------------------------------
+
+namespace locallru {
+
+    // Changed keys, published by one or more subscriber threads and read
+    // by every thread holding a copy.
+    class InvalidationLog {
+      public:
+        explicit InvalidationLog(std::size_t capacity = 4096) : ring_(std::max<std::size_t>(capacity, 1)) {}
+
+        // Sequence number of the last published entry; 0 before any.
+        std::uint64_t head() const noexcept { return head_.load(std::memory_order_acquire); }
+        std::size_t capacity() const noexcept { return ring_.size(); }
+
+        void publish(const std::string& key){ append(key, false); }
+
+        // Every copy is to be dropped (e.g. the change stream reconnected).
+        void publish_all(){ append({}, true); }
+
+        // Calls fn(key) for entries (from, to] and fn(nullptr) for
+        // publish_all() entries. Returns false, calling nothing, if from
+        // is no longer in the ring.
+        template<typename F>
+        bool read(std::uint64_t from, std::uint64_t to, F&& fn) const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if(head_.load(std::memory_order_relaxed) - from > ring_.size()) return false;
+            for(std::uint64_t s = from + 1; s <= to; s++){
+                const Entry& e = ring_[(s - 1) % ring_.size()];
+                fn(e.all ? nullptr : &e.key);
+            }
+            return true;
+        }
+
+      private:
+        struct Entry {
+            std::string key;
+            bool all = false;
+        };
+
+        void append(const std::string& key, bool all){
+            std::lock_guard<std::mutex> lock(mutex_);
+            const std::uint64_t s = head_.load(std::memory_order_relaxed) + 1;
+            Entry& e = ring_[(s - 1) % ring_.size()];
+            e.key = key;
+            e.all = all;
+            head_.store(s, std::memory_order_release);
+        }
+
+        mutable std::mutex mutex_;
+        std::vector<Entry> ring_;
+        std::atomic<std::uint64_t> head_{0};
+    };
+
+    // Per-thread counters of a NearCache.
+    struct NearStats {
+        std::uint64_t hits = 0;            // Served from the local copy
+        std::uint64_t remote_reads = 0;
+        std::uint64_t not_cached = 0;      // Remote reads that raced a change
+        std::uint64_t invalidations = 0;   // Log entries applied
+        std::uint64_t resets = 0;          // Whole copy dropped
+    };
+
+    template<typename V, typename Remote>
+    class NearCache {
+      public:
+        using key_type = std::string;
+        using value_type = V;
+
+        explicit NearCache(Remote& remote, std::size_t log_capacity = 4096)
+            : remote_(remote), log_(log_capacity), id_(next_id().fetch_add(1, std::memory_order_relaxed) + 1) {
+            remote_.subscribe([this](const key_type& key){ log_.publish(key); });
+        }
+
+        NearCache(const NearCache&) = delete;
+        NearCache& operator=(const NearCache&) = delete;
+
+        // Local copy, else the remote (cached locally unless it raced a
+        // change of the key).
+        std::optional<value_type> get(const key_type& key){
+            sync();
+            if(auto v = cache_.get_item(key)) {
+                state().stats.hits++;
+                return v;
+            }
+            const std::uint64_t before = log_.head();
+            std::optional<value_type> v = remote_.get(key);
+            state().stats.remote_reads++;
+            if(!v) return v;
+            if(changed_since(before, key)) {
+                state().stats.not_cached++;
+                return v;
+            }
+            cache_.add_item(key, *v);
+            return v;
+        }
+
+        // Remote first, then this thread's copy; other threads drop theirs
+        // when the change notification arrives. If any change of the key
+        // was published since the write started (another client's, or the
+        // echo of this one), the copy is left to the next get() instead, as
+        // a later write may already have been applied.
+        void put(const key_type& key, const value_type& value){
+            const std::uint64_t before = log_.head();
+            remote_.put(key, value);
+            sync();
+            if(changed_since(before, key)) {
+                cache_.remove_item(key);
+                return;
+            }
+            cache_.add_item(key, value);
+        }
+
+        bool erase(const key_type& key){
+            const bool erased = remote_.erase(key);
+            sync();
+            cache_.remove_item(key);
+            return erased;
+        }
+
+        // For change streams not delivered through Remote::subscribe().
+        void invalidate(const key_type& key){ log_.publish(key); }
+        void invalidate_all(){ log_.publish_all(); }
+
+        // Applies pending invalidations to this thread's copy now, e.g.
+        // before a thread goes idle.
+        void sync(){
+            ThreadState& t = state();
+            if(t.owner != id_) {
+                cache_.clear();
+                t = ThreadState{};
+                t.owner = id_;
+                t.applied = log_.head();
+                return;
+            }
+            const std::uint64_t head = log_.head();
+            if(head == t.applied) return;
+            const bool in_ring = log_.read(t.applied, head, [&](const key_type* key){
+                if(key) cache_.remove_item(*key);
+                else cache_.clear();
+                t.stats.invalidations++;
+            });
+            if(!in_ring) {
+                cache_.clear();
+                t.stats.resets++;
+            }
+            t.applied = head;
+        }
+
+        // Calling thread's counters.
+        NearStats stats() const { return state().stats; }
+        const InvalidationLog& log() const noexcept { return log_; }
+
+      private:
+        struct ThreadState {
+            std::uint64_t owner = 0;       // NearCache id the cursor belongs to
+            std::uint64_t applied = 0;     // Log sequence applied to the copy
+            NearStats stats;
+        };
+
+        static ThreadState& state(){
+            static thread_local ThreadState s;
+            return s;
+        }
+
+        static std::atomic<std::uint64_t>& next_id(){
+            static std::atomic<std::uint64_t> id{0};
+            return id;
+        }
+
+        // Whether key (or everything) was invalidated after sequence before.
+        bool changed_since(std::uint64_t before, const key_type& key) const {
+            const std::uint64_t head = log_.head();
+            if(head == before) return false;
+            bool changed = false;
+            const bool in_ring = log_.read(before, head, [&](const key_type* k){ changed = changed || !k || *k == key; });
+            return changed || !in_ring;
+        }
+
+        Remote& remote_;
+        InvalidationLog log_;
+        std::uint64_t id_;
+        LocalCache<value_type> cache_;
+    };
+
+    // Remote stand-in: a locked map that notifies subscribers of every
+    // change after it is applied, optionally waiting out a round trip per
+    // call to model the network.
+    template<typename V>
+    class InProcessRemote {
+      public:
+        using key_type = std::string;
+        using value_type = V;
+
+        explicit InProcessRemote(std::chrono::nanoseconds round_trip = std::chrono::nanoseconds(0))
+            : round_trip_(round_trip) {}
+
+        std::optional<value_type> get(const key_type& key){
+            wait();
+            std::lock_guard<std::mutex> lock(mutex_);
+            reads_++;
+            auto it = data_.find(key);
+            if(it == data_.end()) return std::nullopt;
+            return it->second;
+        }
+
+        void put(const key_type& key, const value_type& value){
+            wait();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                data_[key] = value;
+            }
+            notify(key);
+        }
+
+        bool erase(const key_type& key){
+            wait();
+            bool erased;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                erased = data_.erase(key) > 0;
+            }
+            if(erased) notify(key);
+            return erased;
+        }
+
+        // Register subscribers before use; they are called on the writing
+        // thread.
+        void subscribe(std::function<void(const key_type&)> fn){
+            std::lock_guard<std::mutex> lock(mutex_);
+            subscribers_.push_back(std::move(fn));
+        }
+
+        std::uint64_t reads() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return reads_;
+        }
+
+      private:
+        // Spins rather than sleeps: round trips of interest are microseconds
+        void wait() const {
+            if(round_trip_.count() <= 0) return;
+            const auto until = std::chrono::steady_clock::now() + round_trip_;
+            while(std::chrono::steady_clock::now() < until){}
+        }
+
+        void notify(const key_type& key){
+            std::vector<std::function<void(const key_type&)>> subs;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                subs = subscribers_;
+            }
+            for(auto& fn : subs) fn(key);
+        }
+
+        std::chrono::nanoseconds round_trip_;
+        mutable std::mutex mutex_;
+        std::unordered_map<key_type, value_type> data_;
+        std::vector<std::function<void(const key_type&)>> subscribers_;
+        std::uint64_t reads_ = 0;
+    };
+}
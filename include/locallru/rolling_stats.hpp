@@ -0,0 +1,177 @@
+#pragma once
+#include "tick_series.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// -----------------------------------------------------------------------------
+// rolling_stats.hpp
+// Sliding window of the last N ticks whose aggregates are maintained on
+// every append, so reading them is O(1) instead of a pass over the window.
+// -----------------------------------------------------------------------------
+// - Sums: count, price, price^2, size and price*size are updated as a tick
+//   enters and the oldest one leaves. Price sums are kept relative to a
+//   shift close to the mean, so the variance does not suffer from
+//   cancellation at large price levels.
+// - Add/subtract updates drift in the last bits over time, so every N
+//   appends the sums are rebuilt exactly from the window (amortised O(1)).
+// - min/max use monotonic deques of tick sequence numbers: each tick is
+//   pushed and popped at most once, so append is amortised O(1) and the
+//   extremes are read from the deque fronts.
+// - The EWMA covers all ticks seen, not just the window. Its smoothing
+//   factor defaults to 2 / (N + 1).
+// - The ticks themselves are kept in a TickSeries<N> (ticks()), for
+//   aggregates over a shorter window or ones not maintained here.
+//
+//   auto cache = LocalCache<RollingStats<50>>::initialize(1000, 0);
+//   cache.upsert_item("AAPL", [&](auto& s){ s.append(ts, price, size); });
+//   cache.read_item("AAPL", [&](const auto& s){ signal = price > s.mean() + 2 * s.stddev(); });
+// -----------------------------------------------------------------------------
+
+namespace locallru {
+
+    template<std::size_t N>
+    class RollingStats {
+      public:
+        RollingStats() = default;
+        explicit RollingStats(double ewma_alpha) : alpha_(ewma_alpha) {}
+
+        static constexpr std::size_t capacity() noexcept { return N; }
+        std::size_t size() const noexcept { return ticks_.size(); }
+        bool empty() const noexcept { return ticks_.empty(); }
+        const TickSeries<N>& ticks() const noexcept { return ticks_; }
+
+        // Latest tick
+        std::int64_t timestamp() const { return ticks_.timestamp(); }
+        double price() const { return ticks_.price(); }
+
+        void append(std::int64_t ts_ns, double price, double size = 1.0){
+            if(ticks_.empty()) {
+                shift_ = price;
+                ewma_ = price;
+            } else {
+                ewma_ += alpha_ * (price - ewma_);
+            }
+
+            if(ticks_.size() == N) {
+                const double old_price = ticks_.price(N - 1), old_size = ticks_.volume(N - 1);
+                const double d = old_price - shift_;
+                sum_ -= d;
+                sum_sq_ -= d * d;
+                volume_ -= old_size;
+                notional_ -= old_price * old_size;
+                const std::uint64_t evicted = seq_ - N;
+                if(min_.front() == evicted) min_.pop_front();
+                if(max_.front() == evicted) max_.pop_front();
+            }
+
+            ticks_.append(ts_ns, price, size);
+            const double d = price - shift_;
+            sum_ += d;
+            sum_sq_ += d * d;
+            volume_ += size;
+            notional_ += price * size;
+            const std::uint64_t s = seq_++;
+            while(!min_.empty() && value(min_.back()) >= price) min_.pop_back();
+            while(!max_.empty() && value(max_.back()) <= price) max_.pop_back();
+            min_.push_back(s);
+            max_.push_back(s);
+
+            if(++since_resync_ == N) resync();
+        }
+
+        void clear() noexcept {
+            ticks_.clear();
+            min_.clear();
+            max_.clear();
+            sum_ = sum_sq_ = volume_ = notional_ = shift_ = ewma_ = 0.0;
+            seq_ = 0;
+            since_resync_ = 0;
+        }
+
+        // Window aggregates; NaN while empty.
+        double mean() const {
+            return empty() ? kNaN : shift_ + sum_ / n();
+        }
+
+        // NaN if the window's volume is 0
+        double vwap() const {
+            return empty() || volume_ == 0.0 ? kNaN : notional_ / volume_;
+        }
+
+        // Population variance / standard deviation
+        double variance() const {
+            if(empty()) return kNaN;
+            const double m = sum_ / n();
+            return std::max(0.0, sum_sq_ / n() - m * m);
+        }
+        double stddev() const { return std::sqrt(variance()); }
+
+        double min() const { return empty() ? kNaN : value(min_.front()); }
+        double max() const { return empty() ? kNaN : value(max_.front()); }
+        double volume() const noexcept { return volume_; }
+
+        // Exponentially weighted mean of every price appended
+        double ewma() const { return empty() ? kNaN : ewma_; }
+        double ewma_alpha() const noexcept { return alpha_; }
+
+      private:
+        static constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+        // Fixed-capacity deque of tick sequence numbers; a window never
+        // holds more than N of them.
+        class SeqDeque {
+          public:
+            bool empty() const noexcept { return head_ == tail_; }
+            std::uint64_t front() const { return buf_[head_ % N]; }
+            std::uint64_t back() const { return buf_[(tail_ - 1) % N]; }
+            void push_back(std::uint64_t s){ buf_[tail_++ % N] = s; }
+            void pop_back() noexcept { tail_--; }
+            void pop_front() noexcept { head_++; }
+            void clear() noexcept { head_ = tail_ = 0; }
+
+          private:
+            std::array<std::uint64_t, N> buf_{};
+            std::uint64_t head_ = 0;
+            std::uint64_t tail_ = 0;
+        };
+
+        double n() const noexcept { return static_cast<double>(ticks_.size()); }
+
+        // Price of the tick with sequence number s (must be in the window)
+        double value(std::uint64_t s) const { return ticks_.price(static_cast<std::size_t>(seq_ - 1 - s)); }
+
+        // Rebuilds the running sums exactly, re-centring the shift on the
+        // current mean.
+        void resync(){
+            since_resync_ = 0;
+            const std::size_t count = ticks_.size();
+            shift_ = ticks_.mean();
+            sum_ = sum_sq_ = volume_ = notional_ = 0.0;
+            for(std::size_t i = 0; i < count; i++){
+                const double p = ticks_.price(i), v = ticks_.volume(i), d = p - shift_;
+                sum_ += d;
+                sum_sq_ += d * d;
+                volume_ += v;
+                notional_ += p * v;
+            }
+        }
+
+        TickSeries<N> ticks_;
+        SeqDeque min_;                // Increasing prices, oldest first
+        SeqDeque max_;                // Decreasing prices, oldest first
+        double alpha_ = 2.0 / (static_cast<double>(N) + 1.0);
+        double shift_ = 0.0;
+        double sum_ = 0.0;            // Sum of (price - shift_)
+        double sum_sq_ = 0.0;         // Sum of (price - shift_)^2
+        double volume_ = 0.0;
+        double notional_ = 0.0;       // Sum of price * size
+        double ewma_ = 0.0;
+        std::uint64_t seq_ = 0;       // Sequence number of the next tick
+        std::size_t since_resync_ = 0;
+    };
+}
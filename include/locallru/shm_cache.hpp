@@ -0,0 +1,478 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// -----------------------------------------------------------------------------
+// shm_cache.hpp
+// An LRU cache whose index and entries live in a POSIX shared memory
+// segment, so processes on one host share a single copy.
+// -----------------------------------------------------------------------------
+// - Layout: header, bucket array, slot slab, all at fixed offsets in the
+//   segment. Links between slots are 32-bit slot indices, never pointers,
+//   so every process can map the segment at a different address.
+// - Values must be trivially copyable and keys at most KeyBytes bytes;
+//   both are stored inline in the slot. Capacity is fixed at creation.
+// - Writers (put / erase / clear) serialise on a process-shared robust
+//   mutex. If a process dies holding it, the next locker gets EOWNERDEAD;
+//   when the dead writer was mid-update the cache is reset (it is only a
+//   cache), otherwise it is kept as is.
+// - Readers take no lock. get() is a seqlock read: it retries if a writer
+//   ran meanwhile, and after repeated retries falls back to the mutex (so a
+//   writer that died mid-update cannot block readers forever).
+// - Recency: get() only sets a per-slot referenced bit. Eviction takes the
+//   least recently written entry, but gives referenced entries a second
+//   chance (move to front, clear the bit): LRU ordering approximated with
+//   CLOCK so that reads stay lock- and write-free.
+// - TTL uses steady_clock (CLOCK_MONOTONIC), which is the same clock in
+//   every process on the host.
+//
+//   // One process creates (or every process opens-or-creates):
+//   auto cache = ShmCache<RefData>::open_or_create("/refdata", 100000, 0);
+//   cache.put("AAPL", ref);
+//   auto r = cache.get("AAPL");   // std::optional<RefData>
+//   // Detach by destroying the handle; ShmCache<RefData>::remove() unlinks
+//   // the segment once no process needs it.
+// -----------------------------------------------------------------------------
+
+namespace locallru {
+
+    inline constexpr char kShmCacheMagic[8] = {'L', 'L', 'R', 'U', 'S', 'H', 'M', '1'};
+
+    template<typename V, std::size_t KeyBytes = 32>
+    class ShmCache {
+        static_assert(std::is_trivially_copyable_v<V>, "ShmCache values are copied in and out of shared memory");
+        static_assert(KeyBytes > 0 && KeyBytes <= 0xFFFF, "ShmCache keys are stored inline");
+        static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::uint8_t>::is_always_lock_free,
+                      "ShmCache needs address-free atomics");
+
+      public:
+        using value_type = V;
+
+        // Creates a new segment; throws std::system_error if it exists.
+        static ShmCache create(const std::string& name, std::size_t capacity, std::uint64_t ttl_seconds){
+            const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+            if(fd < 0) throw std::system_error(errno, std::generic_category(), "shm_open " + name);
+            return ShmCache(fd, name, &capacity, ttl_seconds);
+        }
+
+        // Attaches to an existing segment, waiting briefly for its creator to
+        // finish initialising it. Throws if missing or incompatible.
+        static ShmCache open(const std::string& name){
+            const int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+            if(fd < 0) throw std::system_error(errno, std::generic_category(), "shm_open " + name);
+            return ShmCache(fd, name, nullptr, 0);
+        }
+
+        // Attaches, creating the segment first if no process has yet. The
+        // parameters only apply to the creator.
+        static ShmCache open_or_create(const std::string& name, std::size_t capacity, std::uint64_t ttl_seconds){
+            const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+            if(fd >= 0) return ShmCache(fd, name, &capacity, ttl_seconds);
+            if(errno != EEXIST) throw std::system_error(errno, std::generic_category(), "shm_open " + name);
+            return open(name);
+        }
+
+        // Unlinks the segment name; mapped handles stay valid until
+        // destroyed. Returns false if there was no such segment.
+        static bool remove(const std::string& name){
+            return ::shm_unlink(name.c_str()) == 0;
+        }
+
+        ShmCache(ShmCache&& o) noexcept : base_(std::exchange(o.base_, nullptr)), bytes_(o.bytes_), name_(std::move(o.name_)) {}
+        ShmCache& operator=(ShmCache&& o) noexcept {
+            if(this != &o) {
+                detach();
+                base_ = std::exchange(o.base_, nullptr);
+                bytes_ = o.bytes_;
+                name_ = std::move(o.name_);
+            }
+            return *this;
+        }
+        ShmCache(const ShmCache&) = delete;
+        ShmCache& operator=(const ShmCache&) = delete;
+        ~ShmCache(){ detach(); }
+
+        const std::string& name() const noexcept { return name_; }
+        std::size_t capacity() const noexcept { return static_cast<std::size_t>(header().capacity); }
+        std::uint64_t ttl_seconds() const noexcept { return header().ttl_ns / 1'000'000'000; }
+        std::size_t segment_bytes() const noexcept { return bytes_; }
+        std::size_t size() const noexcept { return header().count.load(std::memory_order_relaxed); }
+
+        // Lock-free lookup; a hit marks the entry as recently used.
+        std::optional<value_type> get(std::string_view key) const {
+            const std::uint64_t h = hash(key);
+            const std::int64_t now = now_ns();
+            Header& hd = header();
+            for(int attempt = 0; attempt < kReadAttempts; attempt++){
+                const std::uint64_t s1 = hd.seq.load(std::memory_order_acquire);
+                if(s1 & 1) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                value_type out;
+                const std::uint32_t found = find_racy(key, h, now, &out);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if(hd.seq.load(std::memory_order_relaxed) != s1) continue;
+                if(found == kNil) return std::nullopt;
+                slot(found).referenced.store(1, std::memory_order_relaxed);
+                return out;
+            }
+            Lock lock(*this);
+            const std::uint32_t i = find(key, h);
+            if(i == kNil || expired(slot(i), now)) return std::nullopt;
+            slot(i).referenced.store(1, std::memory_order_relaxed);
+            return slot(i).value;
+        }
+
+        // Inserts or replaces; throws std::invalid_argument if the key is
+        // longer than KeyBytes.
+        void put(std::string_view key, const value_type& value){
+            if(key.size() > KeyBytes) throw std::invalid_argument("ShmCache: key longer than KeyBytes");
+            const std::uint64_t h = hash(key);
+            const std::int64_t now = now_ns();
+            Lock lock(*this);
+            Write write(header());
+            Header& hd = header();
+            std::uint32_t i = find(key, h);
+            if(i != kNil) {
+                lru_unlink(i);
+            } else {
+                i = hd.free_head != kNil ? hd.free_head : evict(now);
+                Slot& s = slot(i);
+                hd.free_head = s.chain_next;
+                s.hash = h;
+                s.key_len = static_cast<std::uint16_t>(key.size());
+                std::memcpy(s.key, key.data(), key.size());
+                std::uint32_t& bucket = buckets()[h & (hd.buckets - 1)];
+                s.chain_next = bucket;
+                bucket = i;
+                hd.count.store(hd.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+            Slot& s = slot(i);
+            s.value = value;
+            s.expiry_ns = hd.ttl_ns ? now + static_cast<std::int64_t>(hd.ttl_ns) : kNever;
+            s.referenced.store(0, std::memory_order_relaxed);
+            lru_push_front(i);
+        }
+
+        bool erase(std::string_view key){
+            const std::uint64_t h = hash(key);
+            Lock lock(*this);
+            const std::uint32_t i = find(key, h);
+            if(i == kNil) return false;
+            Write write(header());
+            remove_slot(i);
+            return true;
+        }
+
+        void clear(){
+            Lock lock(*this);
+            Write write(header());
+            reset();
+        }
+
+      private:
+        static constexpr std::uint32_t kVersion = 1;
+        static constexpr std::uint32_t kNil = 0xFFFFFFFFu;
+        static constexpr std::int64_t kNever = INT64_MAX;
+        static constexpr int kReadAttempts = 64;
+        static constexpr std::size_t kAlign = 64;
+
+        struct Header {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t key_bytes;
+            std::uint64_t value_size;
+            std::uint64_t value_align;
+            std::uint64_t capacity;
+            std::uint64_t buckets;          // Power of two
+            std::uint64_t ttl_ns;           // 0 = no expiry
+            std::uint64_t segment_bytes;
+            std::atomic<std::uint32_t> ready;
+            std::uint32_t lru_head;         // Most recently written
+            std::uint32_t lru_tail;
+            std::uint32_t free_head;        // Free slots, linked through chain_next
+            std::atomic<std::uint32_t> count;
+            pthread_mutex_t mutex;
+            alignas(kAlign) std::atomic<std::uint64_t> seq; // Odd while a writer is mid-update
+        };
+
+        struct Slot {
+            std::uint64_t hash;
+            std::int64_t expiry_ns;
+            std::uint32_t chain_next;       // Next in bucket chain / free list
+            std::uint32_t lru_prev;
+            std::uint32_t lru_next;
+            std::uint16_t key_len;
+            std::atomic<std::uint8_t> referenced;
+            char key[KeyBytes];
+            value_type value;
+        };
+
+        static constexpr std::size_t align_up(std::size_t v){ return (v + kAlign - 1) & ~(kAlign - 1); }
+        static constexpr std::size_t buckets_offset(){ return align_up(sizeof(Header)); }
+        static constexpr std::size_t slots_offset(std::size_t buckets){ return align_up(buckets_offset() + buckets * sizeof(std::uint32_t)); }
+
+        // Takes the robust mutex. A dead owner that was mid-update (odd
+        // sequence) may have left links half-changed, so the cache is reset.
+        class Lock {
+          public:
+            explicit Lock(const ShmCache& c) : m_(&c.header().mutex) {
+                const int rc = ::pthread_mutex_lock(m_);
+                if(rc == EOWNERDEAD) {
+                    Header& h = c.header();
+                    const std::uint64_t s = h.seq.load(std::memory_order_relaxed);
+                    if(s & 1) {
+                        const_cast<ShmCache&>(c).reset();
+                        h.seq.store(s + 1, std::memory_order_release);
+                    }
+                    ::pthread_mutex_consistent(m_);
+                } else if(rc != 0) {
+                    throw std::system_error(rc, std::generic_category(), "pthread_mutex_lock");
+                }
+            }
+            ~Lock(){ ::pthread_mutex_unlock(m_); }
+            Lock(const Lock&) = delete;
+            Lock& operator=(const Lock&) = delete;
+
+          private:
+            pthread_mutex_t* m_;
+        };
+
+        // Seqlock writer section; readers retry across it.
+        class Write {
+          public:
+            explicit Write(Header& h) : h_(h), s_(h.seq.load(std::memory_order_relaxed)) {
+                h_.seq.store(s_ + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+            }
+            ~Write(){ h_.seq.store(s_ + 2, std::memory_order_release); }
+            Write(const Write&) = delete;
+            Write& operator=(const Write&) = delete;
+
+          private:
+            Header& h_;
+            const std::uint64_t s_;
+        };
+
+        // capacity != nullptr: we created the (empty) segment and initialise
+        // it; otherwise we attach and validate.
+        ShmCache(int fd, std::string name, const std::size_t* capacity, std::uint64_t ttl_seconds) : name_(std::move(name)) {
+            try {
+                if(capacity) initialise(fd, *capacity, ttl_seconds);
+                else attach(fd);
+            } catch(...) {
+                ::close(fd);
+                if(capacity) ::shm_unlink(name_.c_str());
+                detach();
+                throw;
+            }
+            ::close(fd);
+        }
+
+        void initialise(int fd, std::size_t capacity, std::uint64_t ttl_seconds){
+            if(capacity == 0 || capacity >= kNil) throw std::invalid_argument("ShmCache: capacity must be in [1, 2^32 - 1)");
+            const std::size_t buckets = std::bit_ceil(capacity);
+            bytes_ = slots_offset(buckets) + capacity * sizeof(Slot);
+            if(::ftruncate(fd, static_cast<off_t>(bytes_)) != 0) throw std::system_error(errno, std::generic_category(), "ftruncate " + name_);
+            map(fd);
+
+            Header& h = header();
+            std::memcpy(h.magic, kShmCacheMagic, sizeof(h.magic));
+            h.version = kVersion;
+            h.key_bytes = KeyBytes;
+            h.value_size = sizeof(value_type);
+            h.value_align = alignof(value_type);
+            h.capacity = capacity;
+            h.buckets = buckets;
+            h.ttl_ns = ttl_seconds * 1'000'000'000ull;
+            h.segment_bytes = bytes_;
+            h.seq.store(0, std::memory_order_relaxed);
+
+            pthread_mutexattr_t attr;
+            ::pthread_mutexattr_init(&attr);
+            ::pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+            ::pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+            const int rc = ::pthread_mutex_init(&h.mutex, &attr);
+            ::pthread_mutexattr_destroy(&attr);
+            if(rc != 0) throw std::system_error(rc, std::generic_category(), "pthread_mutex_init");
+
+            reset();
+            h.ready.store(1, std::memory_order_release);
+        }
+
+        void attach(int fd){
+            // The creator may still be sizing or initialising the segment.
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            struct stat st{};
+            for(;;){
+                if(::fstat(fd, &st) != 0) throw std::system_error(errno, std::generic_category(), "fstat " + name_);
+                if(static_cast<std::size_t>(st.st_size) >= sizeof(Header)) {
+                    if(!base_) {
+                        bytes_ = static_cast<std::size_t>(st.st_size);
+                        map(fd);
+                    }
+                    if(header().ready.load(std::memory_order_acquire)) break;
+                }
+                if(std::chrono::steady_clock::now() > deadline) throw std::runtime_error(name_ + ": segment never became ready");
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            const Header& h = header();
+            auto fail = [&](const char* what){ throw std::runtime_error(name_ + ": " + what); };
+            if(std::memcmp(h.magic, kShmCacheMagic, sizeof(h.magic)) != 0 || h.version != kVersion) fail("not a ShmCache segment");
+            if(h.key_bytes != KeyBytes || h.value_size != sizeof(value_type) || h.value_align != alignof(value_type))
+                fail("segment was created for a different key/value layout");
+            if(h.segment_bytes != bytes_ || h.buckets == 0 || !std::has_single_bit(h.buckets) ||
+               slots_offset(h.buckets) + h.capacity * sizeof(Slot) != bytes_)
+                fail("corrupt segment header");
+        }
+
+        void map(int fd){
+            void* p = ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if(p == MAP_FAILED) throw std::system_error(errno, std::generic_category(), "mmap " + name_);
+            base_ = static_cast<char*>(p);
+        }
+
+        void detach() noexcept {
+            if(base_) ::munmap(base_, bytes_);
+            base_ = nullptr;
+        }
+
+        Header& header() const noexcept { return *reinterpret_cast<Header*>(base_); }
+        std::uint32_t* buckets() const noexcept { return reinterpret_cast<std::uint32_t*>(base_ + buckets_offset()); }
+        Slot& slot(std::uint32_t i) const noexcept {
+            return reinterpret_cast<Slot*>(base_ + slots_offset(header().buckets))[i];
+        }
+
+        static std::uint64_t hash(std::string_view key) noexcept {
+            // FNV-1a: stable across processes and builds, unlike std::hash
+            std::uint64_t h = 1469598103934665603ull;
+            for(unsigned char c : key) h = (h ^ c) * 1099511628211ull;
+            return h;
+        }
+
+        static std::int64_t now_ns() noexcept {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        static bool expired(const Slot& s, std::int64_t now) noexcept { return now > s.expiry_ns; }
+
+        // Under the lock.
+        std::uint32_t find(std::string_view key, std::uint64_t h) const noexcept {
+            for(std::uint32_t i = buckets()[h & (header().buckets - 1)]; i != kNil; i = slot(i).chain_next){
+                const Slot& s = slot(i);
+                if(s.hash == h && s.key_len == key.size() && std::memcmp(s.key, key.data(), key.size()) == 0) return i;
+            }
+            return kNil;
+        }
+
+        // Without the lock: every index is bounds-checked and the walk is
+        // bounded, since links may be torn while a writer runs. The caller
+        // discards the result unless the sequence was stable.
+        std::uint32_t find_racy(std::string_view key, std::uint64_t h, std::int64_t now, value_type* out) const noexcept {
+            const Header& hd = header();
+            const std::uint64_t cap = hd.capacity;
+            std::uint32_t i = std::atomic_ref<std::uint32_t>(buckets()[h & (hd.buckets - 1)]).load(std::memory_order_relaxed);
+            for(std::uint64_t steps = 0; i < cap && steps < cap; steps++){
+                Slot& s = slot(i);
+                const std::uint16_t len = std::atomic_ref<std::uint16_t>(s.key_len).load(std::memory_order_relaxed);
+                if(std::atomic_ref<std::uint64_t>(s.hash).load(std::memory_order_relaxed) == h && len == key.size() &&
+                   len <= KeyBytes && std::memcmp(s.key, key.data(), len) == 0) {
+                    if(now > std::atomic_ref<std::int64_t>(s.expiry_ns).load(std::memory_order_relaxed)) return kNil;
+                    std::memcpy(static_cast<void*>(out), &s.value, sizeof(value_type));
+                    return i;
+                }
+                i = std::atomic_ref<std::uint32_t>(s.chain_next).load(std::memory_order_relaxed);
+            }
+            return kNil;
+        }
+
+        void lru_unlink(std::uint32_t i) noexcept {
+            Header& h = header();
+            Slot& s = slot(i);
+            if(s.lru_prev != kNil) slot(s.lru_prev).lru_next = s.lru_next;
+            else h.lru_head = s.lru_next;
+            if(s.lru_next != kNil) slot(s.lru_next).lru_prev = s.lru_prev;
+            else h.lru_tail = s.lru_prev;
+        }
+
+        void lru_push_front(std::uint32_t i) noexcept {
+            Header& h = header();
+            Slot& s = slot(i);
+            s.lru_prev = kNil;
+            s.lru_next = h.lru_head;
+            if(h.lru_head != kNil) slot(h.lru_head).lru_prev = i;
+            h.lru_head = i;
+            if(h.lru_tail == kNil) h.lru_tail = i;
+        }
+
+        // Unlinks slot i from its bucket and the LRU list and frees it.
+        void remove_slot(std::uint32_t i) noexcept {
+            Header& h = header();
+            Slot& s = slot(i);
+            std::uint32_t* link = &buckets()[s.hash & (h.buckets - 1)];
+            while(*link != i) link = &slot(*link).chain_next;
+            *link = s.chain_next;
+            lru_unlink(i);
+            s.chain_next = h.free_head;
+            h.free_head = i;
+            h.count.store(h.count.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        }
+
+        // Frees one slot: expired tail entries go first, and referenced ones
+        // get a second chance at the front. Returns the freed slot.
+        std::uint32_t evict(std::int64_t now) noexcept {
+            Header& h = header();
+            for(std::uint64_t n = h.count.load(std::memory_order_relaxed); n > 0; n--){
+                const std::uint32_t tail = h.lru_tail;
+                Slot& s = slot(tail);
+                if(expired(s, now) || s.referenced.load(std::memory_order_relaxed) == 0) break;
+                s.referenced.store(0, std::memory_order_relaxed);
+                lru_unlink(tail);
+                lru_push_front(tail);
+            }
+            const std::uint32_t victim = h.lru_tail;
+            remove_slot(victim);
+            return victim;
+        }
+
+        void reset() noexcept {
+            Header& h = header();
+            for(std::uint64_t b = 0; b < h.buckets; b++) buckets()[b] = kNil;
+            for(std::uint64_t i = 0; i < h.capacity; i++){
+                Slot& s = slot(static_cast<std::uint32_t>(i));
+                s.chain_next = i + 1 < h.capacity ? static_cast<std::uint32_t>(i + 1) : kNil;
+                s.lru_prev = s.lru_next = kNil;
+                s.key_len = 0;
+                s.hash = 0;
+                s.referenced.store(0, std::memory_order_relaxed);
+            }
+            h.free_head = 0;
+            h.lru_head = h.lru_tail = kNil;
+            h.count.store(0, std::memory_order_relaxed);
+        }
+
+        char* base_ = nullptr;
+        std::size_t bytes_ = 0;
+        std::string name_;
+    };
+}
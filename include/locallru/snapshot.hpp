@@ -0,0 +1,367 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// -----------------------------------------------------------------------------
+// snapshot.hpp
+// Snapshot / warm restart of cache contents: entries are dumped in LRU order
+// with their remaining TTL, and reloaded from a memory-mapped file.
+// -----------------------------------------------------------------------------
+// - A snapshot file holds one section per store. LocalCache stores are
+//   thread-local, so each thread snapshots and restores its own section,
+//   and restores of different sections run in parallel without contention.
+// - Records are written least recently used first; restoring them in order
+//   rebuilds the same LRU order. The index is presized to the section's
+//   entry count, and records that would only be evicted again (more entries
+//   than the store's capacity) are skipped.
+// - Remaining TTLs are stored relative to the wall-clock time the snapshot
+//   was taken, so time spent down counts against them; entries that expired
+//   in the meantime are not restored.
+// - Keys and values go through Serializer<T>. Trivially copyable types,
+//   std::string and vectors of trivially copyable types are built in;
+//   specialise Serializer for anything else:
+//
+//     template<> struct locallru::Serializer<Quote> {
+//         static void write(SnapshotWriter& w, const Quote& q){ ... }
+//         static Quote read(SnapshotReader& r){ ... }
+//     };
+//
+// - snapshot(cache) and restore(cache, section) take a store, or a cache
+//   whose backing_store() returns one (LocalCache: the calling thread's),
+//   so the caches themselves don't depend on this header.
+//
+// Typical restart:
+//
+//   // shutdown, on each worker thread i
+//   sections[i] = snapshot(cache);
+//   // then once
+//   write_snapshot("cache.snap", sections);
+//
+//   // startup
+//   Snapshot snap("cache.snap");
+//   // on worker thread i
+//   restore(cache, snap.section(i));
+// -----------------------------------------------------------------------------
+
+namespace locallru {
+
+    inline constexpr char kSnapshotMagic[8] = {'L', 'L', 'R', 'U', 'S', 'N', 'A', 'P'};
+    inline constexpr std::uint32_t kSnapshotVersion = 1;
+
+    // Appends serialised bytes to a section buffer.
+    class SnapshotWriter {
+      public:
+        explicit SnapshotWriter(std::string& out) : out_(out) {}
+
+        void bytes(const void* p, std::size_t n){ out_.append(static_cast<const char*>(p), n); }
+
+        template<typename T>
+        void pod(const T& v){
+            static_assert(std::is_trivially_copyable_v<T>);
+            bytes(&v, sizeof(v));
+        }
+
+      private:
+        std::string& out_;
+    };
+
+    // Consumes bytes from a section; throws std::runtime_error past the end.
+    class SnapshotReader {
+      public:
+        explicit SnapshotReader(std::string_view in) : in_(in) {}
+
+        bool done() const noexcept { return in_.empty(); }
+
+        std::string_view bytes(std::size_t n){
+            if(n > in_.size()) throw std::runtime_error("snapshot: truncated record");
+            const std::string_view v = in_.substr(0, n);
+            in_.remove_prefix(n);
+            return v;
+        }
+
+        template<typename T>
+        T pod(){
+            static_assert(std::is_trivially_copyable_v<T>);
+            T v;
+            std::memcpy(&v, bytes(sizeof(T)).data(), sizeof(T));
+            return v;
+        }
+
+      private:
+        std::string_view in_;
+    };
+
+    // Pluggable encoding of keys and values. The primary template covers
+    // trivially copyable types; it is left undefined for everything else so
+    // a missing specialisation fails at compile time.
+    template<typename T, typename Enable = void>
+    struct Serializer;
+
+    template<typename T>
+    struct Serializer<T, std::enable_if_t<std::is_trivially_copyable_v<T>>> {
+        static void write(SnapshotWriter& w, const T& v){ w.pod(v); }
+        static T read(SnapshotReader& r){ return r.pod<T>(); }
+    };
+
+    template<>
+    struct Serializer<std::string> {
+        static void write(SnapshotWriter& w, const std::string& s){
+            w.pod(static_cast<std::uint32_t>(s.size()));
+            w.bytes(s.data(), s.size());
+        }
+        static std::string read(SnapshotReader& r){
+            const auto n = r.pod<std::uint32_t>();
+            return std::string(r.bytes(n));
+        }
+    };
+
+    template<typename T>
+    struct Serializer<std::vector<T>, std::enable_if_t<std::is_trivially_copyable_v<T>>> {
+        static void write(SnapshotWriter& w, const std::vector<T>& v){
+            w.pod(static_cast<std::uint64_t>(v.size()));
+            w.bytes(v.data(), v.size() * sizeof(T));
+        }
+        static std::vector<T> read(SnapshotReader& r){
+            const auto n = r.pod<std::uint64_t>();
+            if(n > std::numeric_limits<std::size_t>::max() / sizeof(T)) throw std::runtime_error("snapshot: corrupt vector length");
+            const std::string_view b = r.bytes(static_cast<std::size_t>(n) * sizeof(T));
+            std::vector<T> v(static_cast<std::size_t>(n));
+            std::memcpy(v.data(), b.data(), b.size());
+            return v;
+        }
+    };
+
+    // One store's entries, serialised. Owns its bytes when produced by
+    // snapshot(); views into the mapping when taken from a Snapshot.
+    struct SnapshotSection {
+        std::string storage;
+        std::string_view mapped;
+        std::uint64_t entries = 0;
+        std::int64_t taken_ns = 0;   // Wall clock (system_clock) at snapshot
+
+        std::string_view bytes() const noexcept { return mapped.data() ? mapped : std::string_view(storage); }
+    };
+
+    namespace detail {
+        // Remaining TTL marker for entries that never expire
+        inline constexpr std::int64_t kNoExpiry = -1;
+
+        struct SnapshotHeader {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t sections;
+            std::uint64_t file_size;
+        };
+        static_assert(sizeof(SnapshotHeader) == 24);
+
+        struct SnapshotSectionEntry {
+            std::uint64_t offset;
+            std::uint64_t bytes;
+            std::uint64_t entries;
+            std::int64_t taken_ns;
+        };
+        static_assert(sizeof(SnapshotSectionEntry) == 32);
+
+        inline std::int64_t wall_ns(){
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+    }
+
+    // Serialises a store through its for_each_lru(fn(key, value, expiry))
+    // hook, which visits live entries least recently used first.
+    template<typename Store>
+    SnapshotSection snapshot_store(const Store& store){
+        using K = typename Store::key_type;
+        using V = typename Store::value_type;
+        using TimePoint = std::chrono::steady_clock::time_point;
+
+        SnapshotSection s;
+        SnapshotWriter w(s.storage);
+        const TimePoint now = std::chrono::steady_clock::now();
+        s.taken_ns = detail::wall_ns();
+        store.for_each_lru([&](const K& key, const V& value, TimePoint expiry){
+            const std::int64_t remaining = expiry == TimePoint::max() ? detail::kNoExpiry
+                                         : std::chrono::duration_cast<std::chrono::nanoseconds>(expiry - now).count();
+            Serializer<K>::write(w, key);
+            w.pod(remaining);
+            Serializer<V>::write(w, value);
+            s.entries++;
+        });
+        return s;
+    }
+
+    // Loads a section into a store, in LRU order. Uses the store's reserve()
+    // and capacity(), and put_until(key, value, expiry) when the store has
+    // TTLs (put(key, value) otherwise). Returns the number of entries
+    // loaded. Throws std::runtime_error on a malformed section.
+    template<typename Store>
+    std::size_t restore_store(Store& store, const SnapshotSection& section){
+        using K = typename Store::key_type;
+        using V = typename Store::value_type;
+        using TimePoint = std::chrono::steady_clock::time_point;
+
+        const std::uint64_t capacity = store.capacity();
+        const std::uint64_t skip = section.entries > capacity ? section.entries - capacity : 0;
+        store.reserve(static_cast<std::size_t>(section.entries - skip));
+
+        const TimePoint now = std::chrono::steady_clock::now();
+        const std::int64_t downtime = std::max<std::int64_t>(0, detail::wall_ns() - section.taken_ns);
+        SnapshotReader r(section.bytes());
+        std::size_t loaded = 0;
+        for(std::uint64_t i = 0; i < section.entries; i++){
+            K key = Serializer<K>::read(r);
+            const auto remaining = r.pod<std::int64_t>();
+            V value = Serializer<V>::read(r);
+            if(i < skip) continue;
+            if(remaining != detail::kNoExpiry && remaining <= downtime) continue;
+            if constexpr (requires { store.put_until(key, std::move(value), now); }) {
+                const TimePoint expiry = remaining == detail::kNoExpiry ? TimePoint::max()
+                                       : now + std::chrono::nanoseconds(remaining - downtime);
+                store.put_until(key, std::move(value), expiry);
+            } else {
+                store.put(key, std::move(value));
+            }
+            loaded++;
+        }
+        if(!r.done()) throw std::runtime_error("snapshot: trailing bytes in section");
+        return loaded;
+    }
+
+    // Serialises a cache: its backing_store() if it has one, else the cache
+    // itself as a store. For LocalCache, call it on each thread whose
+    // entries should survive a restart.
+    template<typename Cache>
+    SnapshotSection snapshot(const Cache& cache){
+        if constexpr (requires { cache.backing_store(); }) return snapshot_store(cache.backing_store());
+        else return snapshot_store(cache);
+    }
+
+    // Loads a section into a cache (the calling thread's store for
+    // LocalCache), keeping LRU order and remaining TTLs; returns the number
+    // of entries loaded.
+    template<typename Cache>
+    std::size_t restore(Cache&& cache, const SnapshotSection& section){
+        if constexpr (requires { cache.backing_store(); }) return restore_store(cache.backing_store(), section);
+        else return restore_store(cache, section);
+    }
+
+    // Writes sections to `path` under a temporary name and renames it into
+    // place. Throws std::system_error on I/O failure.
+    inline void write_snapshot(const std::string& path, std::span<const SnapshotSection> sections){
+        std::vector<detail::SnapshotSectionEntry> dir(sections.size());
+        std::uint64_t offset = sizeof(detail::SnapshotHeader) + sections.size() * sizeof(detail::SnapshotSectionEntry);
+        for(std::size_t i = 0; i < sections.size(); i++){
+            dir[i] = {offset, sections[i].bytes().size(), sections[i].entries, sections[i].taken_ns};
+            offset += sections[i].bytes().size();
+        }
+        detail::SnapshotHeader h{};
+        std::memcpy(h.magic, kSnapshotMagic, sizeof(h.magic));
+        h.version = kSnapshotVersion;
+        h.sections = static_cast<std::uint32_t>(sections.size());
+        h.file_size = offset;
+
+        const std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if(!out) throw std::system_error(errno, std::generic_category(), "open " + tmp);
+            out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+            out.write(reinterpret_cast<const char*>(dir.data()), static_cast<std::streamsize>(dir.size() * sizeof(dir[0])));
+            for(const SnapshotSection& s : sections) out.write(s.bytes().data(), static_cast<std::streamsize>(s.bytes().size()));
+            out.flush();
+            if(!out) throw std::system_error(errno, std::generic_category(), "write " + tmp);
+        }
+        if(std::rename(tmp.c_str(), path.c_str()) != 0) throw std::system_error(errno, std::generic_category(), "rename " + tmp);
+    }
+
+    // Read-only mapping of a snapshot file. Sections view into the mapping,
+    // so the Snapshot must outlive restores from it.
+    class Snapshot {
+      public:
+        explicit Snapshot(const std::string& path){
+            const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if(fd < 0) throw std::system_error(errno, std::generic_category(), "open " + path);
+            struct stat st{};
+            if(::fstat(fd, &st) != 0) {
+                const int err = errno;
+                ::close(fd);
+                throw std::system_error(err, std::generic_category(), "stat " + path);
+            }
+            size_ = static_cast<std::size_t>(st.st_size);
+            if(size_ > 0) {
+                void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+                if(p == MAP_FAILED) {
+                    const int err = errno;
+                    ::close(fd);
+                    throw std::system_error(err, std::generic_category(), "mmap " + path);
+                }
+                data_ = static_cast<const char*>(p);
+                ::madvise(p, size_, MADV_SEQUENTIAL);
+            }
+            ::close(fd);
+            try {
+                parse(path);
+            } catch(...) {
+                unmap();
+                throw;
+            }
+        }
+
+        ~Snapshot(){ unmap(); }
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+
+        std::size_t size() const noexcept { return sections_.size(); }
+        const SnapshotSection& section(std::size_t i) const { return sections_.at(i); }
+        std::span<const SnapshotSection> sections() const noexcept { return sections_; }
+
+      private:
+        void parse(const std::string& path){
+            auto fail = [&](const char* what){ throw std::runtime_error(path + ": " + what); };
+            if(size_ < sizeof(detail::SnapshotHeader)) fail("too small for a snapshot");
+            detail::SnapshotHeader h;
+            std::memcpy(&h, data_, sizeof(h));
+            if(std::memcmp(h.magic, kSnapshotMagic, sizeof(h.magic)) != 0) fail("not a snapshot");
+            if(h.version != kSnapshotVersion) fail("unsupported snapshot version");
+            if(h.file_size != size_) fail("truncated snapshot");
+            if(h.sections > (size_ - sizeof(h)) / sizeof(detail::SnapshotSectionEntry)) fail("corrupt section directory");
+            sections_.resize(h.sections);
+            for(std::uint32_t i = 0; i < h.sections; i++){
+                detail::SnapshotSectionEntry e;
+                std::memcpy(&e, data_ + sizeof(h) + i * sizeof(e), sizeof(e));
+                if(e.offset > size_ || e.bytes > size_ - e.offset) fail("section out of bounds");
+                sections_[i].mapped = std::string_view(data_ + e.offset, static_cast<std::size_t>(e.bytes));
+                sections_[i].entries = e.entries;
+                sections_[i].taken_ns = e.taken_ns;
+            }
+        }
+
+        void unmap() noexcept {
+            if(data_) ::munmap(const_cast<char*>(data_), size_);
+            data_ = nullptr;
+        }
+
+        const char* data_ = nullptr;
+        std::size_t size_ = 0;
+        std::vector<SnapshotSection> sections_;
+    };
+}
@@ -0,0 +1,617 @@
+#pragma once
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "io_uring.hpp"
+#include "local_lru.hpp"
+#include "snapshot.hpp"
+
+// -----------------------------------------------------------------------------
+// spill_tier.hpp
+// File-backed second tier: values evicted from memory are appended to a
+// log-structured file and read back on a memory miss, instead of being
+// rebuilt or refetched.
+// -----------------------------------------------------------------------------
+// - SpillFile<K, V> is the tier itself. Records (key + value, encoded with
+//   Serializer<T> from snapshot.hpp) are appended to the active segment
+//   file through a write buffer, so many evictions cost one pwrite. A
+//   segment is sealed when it reaches segment_bytes.
+// - The in-memory index maps each key to (segment, offset, length, expiry),
+//   ~40 bytes plus the key; values are read back with one pread (or from
+//   the write buffer if not yet written).
+// - get_many()/take_many() look up a batch of keys at once. With the
+//   io_uring backend all of the batch's disk reads go out in one
+//   io_uring_enter and run in parallel on the device; with posix they are
+//   one pread each.
+// - Overwritten, erased, expired and promoted records become garbage. A
+//   sealed segment whose live share drops below compact_below is compacted:
+//   its live records are copied to the active segment and its file deleted.
+//   With max_bytes set, the oldest segments are dropped (their entries lost)
+//   to bound disk use.
+// - The tier is a cache, not persistence: each SpillFile keeps its segments
+//   in its own fresh subdirectory of the configured directory, deleted with
+//   the SpillFile. Like LruStore it is single-threaded; several instances
+//   (e.g. one per thread) can share a directory.
+// - SpillStore<K, V> combines an LruStore with a SpillFile via the store's
+//   eviction handler: get() promotes an entry from disk back into memory,
+//   keeping its remaining TTL.
+//
+//   SpillOptions opt;
+//   opt.directory = "/mnt/nvme/locallru";
+//   SpillStore<std::string, std::string> store(10'000, 0, opt);
+//   store.put("book:AAPL", render_book());   // spilled when evicted
+//   auto v = store.get("book:AAPL");         // memory, else disk, else miss
+// -----------------------------------------------------------------------------
+
+namespace locallru {
+
+    struct SpillOptions {
+        std::string directory;                 // Created if missing; each SpillFile
+                                               // uses its own spill-XXXXXX subdirectory
+        std::size_t segment_bytes = 16u << 20; // Segment size before sealing
+        std::size_t batch_bytes = 256u << 10;  // Buffered appends per write
+        std::size_t max_bytes = 0;             // Disk budget; 0 = unbounded
+        double compact_below = 0.5;            // Live share that triggers compaction
+        IoBackend io = IoBackend::automatic;   // For get_many()/take_many()
+        unsigned ring_entries = 256;           // Reads in flight per io_uring_enter
+    };
+
+    struct SpillStats {
+        std::uint64_t spilled = 0;       // Records appended by put()
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t writes = 0;        // pwrite calls
+        std::uint64_t bytes_written = 0;
+        std::uint64_t bytes_read = 0;
+        std::uint64_t reads = 0;         // pread or io_uring_enter calls
+        std::uint64_t compactions = 0;
+        std::uint64_t dropped = 0;       // Entries lost to max_bytes
+    };
+
+    template<typename K, typename V>
+    class SpillFile {
+      public:
+        using key_type = K;
+        using value_type = V;
+        using time_point = Clock::time_point;
+
+        explicit SpillFile(SpillOptions options) : opt_(std::move(options)) {
+            if(opt_.directory.empty()) throw std::invalid_argument("SpillFile: directory is required");
+            if(opt_.segment_bytes < kHeaderBytes) throw std::invalid_argument("SpillFile: segment_bytes too small");
+            std::filesystem::create_directories(opt_.directory);
+            opt_.ring_entries = std::max(1u, opt_.ring_entries);
+            if(resolve(opt_.io) == IoBackend::io_uring) ring_ = std::make_unique<IoUring>(opt_.ring_entries);
+            // Segment names repeat across instances, so each gets a private
+            // directory instead of truncating another's files
+            dir_ = (std::filesystem::path(opt_.directory) / "spill-XXXXXX").string();
+            if(!::mkdtemp(dir_.data())) throw std::system_error(errno, std::generic_category(), "mkdtemp " + dir_);
+            try {
+                open_segment();
+            } catch(...) {
+                ::rmdir(dir_.c_str());
+                throw;
+            }
+        }
+
+        ~SpillFile(){
+            for(auto& [id, seg] : segments_) close_segment(seg);
+            ::rmdir(dir_.c_str());
+        }
+
+        SpillFile(const SpillFile&) = delete;
+        SpillFile& operator=(const SpillFile&) = delete;
+
+        std::size_t size() const noexcept { return index_.size(); }
+        std::size_t segments() const noexcept { return segments_.size(); }
+        std::uint64_t file_bytes() const noexcept { return file_bytes_; }
+        std::uint64_t live_bytes() const noexcept { return live_bytes_; }
+        const SpillStats& stats() const noexcept { return stats_; }
+        const SpillOptions& options() const noexcept { return opt_; }
+        IoBackend io_backend() const noexcept { return ring_ ? IoBackend::io_uring : IoBackend::posix; }
+
+        bool contains(const key_type& key) const { return index_.find(key) != index_.end(); }
+
+        // Appends key/value, replacing any earlier record for key. Entries
+        // already past expiry are not written.
+        void put(const key_type& key, const value_type& value, time_point expiry){
+            put(key, value, expiry, Clock::now());
+        }
+
+        void put(const key_type& key, const value_type& value, time_point expiry, time_point now){
+            if(now > expiry) {
+                erase(key);
+                return;
+            }
+            record_.assign(kHeaderBytes, '\0');
+            SnapshotWriter w(record_);
+            Serializer<key_type>::write(w, key);
+            Serializer<value_type>::write(w, value);
+            const auto payload = static_cast<std::uint32_t>(record_.size() - kHeaderBytes);
+            std::memcpy(record_.data(), &payload, kHeaderBytes);
+
+            auto [it, inserted] = index_.try_emplace(key);
+            if(!inserted) release(it->second);
+            it->second = append(record_, expiry);
+            stats_.spilled++;
+            maintain(now);
+        }
+
+        // Reads the value without removing it.
+        std::optional<value_type> get(const key_type& key, time_point now){
+            auto it = find_live(key, now);
+            if(it == index_.end()) return std::nullopt;
+            return read_value(it->second);
+        }
+
+        // Reads and removes the value (promotion to the memory tier); its
+        // expiry goes to *expiry if given.
+        std::optional<value_type> take(const key_type& key, time_point now, time_point* expiry = nullptr){
+            auto it = find_live(key, now);
+            if(it == index_.end()) return std::nullopt;
+            std::optional<value_type> v = read_value(it->second);
+            if(expiry) *expiry = it->second.expiry;
+            release(it->second);
+            index_.erase(it);
+            return v;
+        }
+
+        // get() for a batch of keys; result i is keys[i]'s value.
+        std::vector<std::optional<value_type>> get_many(const std::vector<key_type>& keys, time_point now){
+            std::vector<std::optional<value_type>> out(keys.size());
+            lookup_batch(keys, now);
+            read_batch();
+            for(const BatchRead& b : batch_) out[b.index] = decode_value(b);
+            return out;
+        }
+
+        // take() for a batch of keys; expiries, if given, is resized to
+        // match and holds each hit's expiry. A key repeated in the batch is
+        // a hit only once.
+        std::vector<std::optional<value_type>> take_many(const std::vector<key_type>& keys, time_point now,
+                                                         std::vector<time_point>* expiries = nullptr){
+            std::vector<std::optional<value_type>> out(keys.size());
+            if(expiries) expiries->assign(keys.size(), time_point{});
+            lookup_batch(keys, now);
+            read_batch();
+            for(const BatchRead& b : batch_){
+                auto it = index_.find(keys[b.index]);
+                if(it == index_.end() || it->second.segment != b.loc.segment || it->second.offset != b.loc.offset) continue;
+                out[b.index] = decode_value(b);
+                if(expiries) (*expiries)[b.index] = b.loc.expiry;
+                release(it->second);
+                index_.erase(it);
+            }
+            return out;
+        }
+
+        bool erase(const key_type& key){
+            auto it = index_.find(key);
+            if(it == index_.end()) return false;
+            release(it->second);
+            index_.erase(it);
+            return true;
+        }
+
+        // Drops every entry and starts over with one empty segment.
+        void clear(){
+            for(auto& [id, seg] : segments_) close_segment(seg);
+            segments_.clear();
+            index_.clear();
+            pending_.clear();
+            file_bytes_ = live_bytes_ = 0;
+            open_segment();
+        }
+
+        // Writes buffered records out (they are readable either way).
+        void flush(){
+            Segment& seg = segments_.at(active_);
+            std::size_t done = 0;
+            while(done < pending_.size()){
+                const ssize_t n = ::pwrite(seg.fd, pending_.data() + done, pending_.size() - done,
+                                           static_cast<off_t>(flushed_ + done));
+                if(n < 0) {
+                    if(errno == EINTR) continue;
+                    throw std::system_error(errno, std::generic_category(), "pwrite " + seg.path);
+                }
+                done += static_cast<std::size_t>(n);
+                stats_.writes++;
+            }
+            stats_.bytes_written += pending_.size();
+            flushed_ += pending_.size();
+            pending_.clear();
+        }
+
+        // Compacts every sealed segment below the live threshold now,
+        // rather than as appends seal segments.
+        void compact(){ compact_sealed(Clock::now()); }
+
+      private:
+        static constexpr std::size_t kHeaderBytes = sizeof(std::uint32_t); // Payload length
+
+        struct Location {
+            std::uint32_t segment = 0;
+            std::uint32_t length = 0;     // Header + payload
+            std::uint64_t offset = 0;
+            time_point expiry{};
+        };
+
+        struct Segment {
+            int fd = -1;
+            std::string path;
+            std::uint64_t bytes = 0;
+            std::uint64_t live = 0;
+        };
+
+        using Index = std::unordered_map<key_type, Location>;
+
+        // One record of a get_many()/take_many() batch, read into
+        // batch_buf_ at buf_offset.
+        struct BatchRead {
+            std::size_t index = 0;
+            Location loc;
+            std::size_t buf_offset = 0;
+        };
+
+        typename Index::iterator find_live(const key_type& key, time_point now){
+            auto it = index_.find(key);
+            if(it == index_.end()) {
+                stats_.misses++;
+                return it;
+            }
+            if(now > it->second.expiry) {
+                release(it->second);
+                index_.erase(it);
+                stats_.misses++;
+                return index_.end();
+            }
+            stats_.hits++;
+            return it;
+        }
+
+        void open_segment(){
+            char name[32];
+            std::snprintf(name, sizeof(name), "spill-%06u.log", next_segment_);
+            Segment seg;
+            seg.path = (std::filesystem::path(dir_) / name).string();
+            seg.fd = ::open(seg.path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+            if(seg.fd < 0) throw std::system_error(errno, std::generic_category(), "open " + seg.path);
+            active_ = next_segment_++;
+            segments_.emplace(active_, std::move(seg));
+            flushed_ = 0;
+        }
+
+        static void close_segment(Segment& seg) noexcept {
+            if(seg.fd >= 0) ::close(seg.fd);
+            ::unlink(seg.path.c_str());
+            seg.fd = -1;
+        }
+
+        // Adds a framed record to the active segment, sealing it first if
+        // the record does not fit.
+        Location append(std::string_view record, time_point expiry){
+            if(segments_.at(active_).bytes + record.size() > opt_.segment_bytes && segments_.at(active_).bytes > 0) {
+                flush();
+                open_segment();
+            }
+            Segment& seg = segments_.at(active_);
+            const Location loc{active_, static_cast<std::uint32_t>(record.size()), seg.bytes, expiry};
+            pending_.append(record);
+            seg.bytes += record.size();
+            seg.live += record.size();
+            file_bytes_ += record.size();
+            live_bytes_ += record.size();
+            if(pending_.size() >= opt_.batch_bytes) flush();
+            return loc;
+        }
+
+        void release(const Location& loc) noexcept {
+            segments_.at(loc.segment).live -= loc.length;
+            live_bytes_ -= loc.length;
+        }
+
+        // Whole record (header + payload) into out.
+        void read_record(const Location& loc, std::string& out){
+            out.resize(loc.length);
+            if(loc.segment == active_ && loc.offset >= flushed_) {
+                std::memcpy(out.data(), pending_.data() + (loc.offset - flushed_), loc.length);
+                return;
+            }
+            read_at(segments_.at(loc.segment), loc.offset, out.data(), loc.length);
+        }
+
+        void read_at(const Segment& seg, std::uint64_t offset, char* out, std::size_t n){
+            std::size_t done = 0;
+            while(done < n){
+                const ssize_t r = ::pread(seg.fd, out + done, n - done, static_cast<off_t>(offset + done));
+                stats_.reads++;
+                if(r < 0 && errno == EINTR) continue;
+                if(r <= 0) throw std::system_error(r < 0 ? errno : EIO, std::generic_category(), "pread " + seg.path);
+                done += static_cast<std::size_t>(r);
+            }
+            stats_.bytes_read += n;
+        }
+
+        value_type read_value(const Location& loc){
+            read_record(loc, scratch_);
+            return decode(scratch_);
+        }
+
+        static value_type decode(std::string_view record){
+            SnapshotReader r(record.substr(kHeaderBytes));
+            Serializer<key_type>::read(r);
+            return Serializer<value_type>::read(r);
+        }
+
+        value_type decode_value(const BatchRead& b) const {
+            return decode(std::string_view(batch_buf_).substr(b.buf_offset, b.loc.length));
+        }
+
+        // Finds the live keys of a batch and lays their records out in
+        // batch_buf_.
+        void lookup_batch(const std::vector<key_type>& keys, time_point now){
+            batch_.clear();
+            std::size_t bytes = 0;
+            for(std::size_t i = 0; i < keys.size(); i++){
+                auto it = find_live(keys[i], now);
+                if(it == index_.end()) continue;
+                batch_.push_back(BatchRead{i, it->second, bytes});
+                bytes += it->second.length;
+            }
+            batch_buf_.resize(bytes);
+        }
+
+        // Reads every record of batch_: buffered ones by copy, the rest by
+        // pread, or through the ring ring_entries at a time.
+        void read_batch(){
+            std::vector<const BatchRead*> disk;
+            for(const BatchRead& b : batch_){
+                char* dst = batch_buf_.data() + b.buf_offset;
+                if(b.loc.segment == active_ && b.loc.offset >= flushed_) {
+                    std::memcpy(dst, pending_.data() + (b.loc.offset - flushed_), b.loc.length);
+                } else if(!ring_) {
+                    read_at(segments_.at(b.loc.segment), b.loc.offset, dst, b.loc.length);
+                } else {
+                    disk.push_back(&b);
+                }
+            }
+            for(std::size_t first = 0; first < disk.size(); first += opt_.ring_entries){
+                const std::size_t n = std::min<std::size_t>(opt_.ring_entries, disk.size() - first);
+                for(std::size_t i = first; i < first + n; i++){
+                    const BatchRead& b = *disk[i];
+                    io_uring_sqe* e = ring_->sqe();
+                    e->opcode = IORING_OP_READ;
+                    e->fd = segments_.at(b.loc.segment).fd;
+                    e->addr = reinterpret_cast<std::uint64_t>(batch_buf_.data() + b.buf_offset);
+                    e->len = b.loc.length;
+                    e->off = b.loc.offset;
+                    e->user_data = i;
+                }
+                const std::uint64_t enters = ring_->enters();
+                std::size_t done = 0;
+                int error = 0;                   // Thrown once every completion is reaped
+                const Segment* failed = nullptr;
+                short_reads_.clear();            // (index, bytes read), finished after reaping
+                while(done < n){
+                    ring_->submit(static_cast<unsigned>(n - done));
+                    done += ring_->for_each_cqe([&](const io_uring_cqe& c){
+                        const auto i = static_cast<std::size_t>(c.user_data);
+                        const BatchRead& b = *disk[i];
+                        if(c.res < 0 || error) {
+                            if(!error) {
+                                error = -c.res;
+                                failed = &segments_.find(b.loc.segment)->second;
+                            }
+                            return;
+                        }
+                        const auto got = static_cast<std::size_t>(c.res);
+                        stats_.bytes_read += got;
+                        if(got < b.loc.length) short_reads_.emplace_back(i, got);
+                    });
+                }
+                stats_.reads += ring_->enters() - enters;
+                if(error) throw std::system_error(error, std::generic_category(), "read " + failed->path);
+                for(const auto& [i, got] : short_reads_){
+                    const BatchRead& b = *disk[i];
+                    read_at(segments_.at(b.loc.segment), b.loc.offset + got, batch_buf_.data() + b.buf_offset + got, b.loc.length - got);
+                }
+            }
+        }
+
+        // Calls fn(index iterator) for every record of a sealed segment that
+        // is still the live copy of its key, scanning the file in order.
+        template<typename F>
+        void for_each_live(std::uint32_t id, F&& fn){
+            const Segment& seg = segments_.at(id);
+            std::string data(static_cast<std::size_t>(seg.bytes), '\0');
+            read_at(seg, 0, data.data(), data.size());
+            std::size_t offset = 0;
+            while(offset + kHeaderBytes <= data.size()){
+                std::uint32_t payload;
+                std::memcpy(&payload, data.data() + offset, kHeaderBytes);
+                SnapshotReader r(std::string_view(data).substr(offset + kHeaderBytes, payload));
+                const key_type key = Serializer<key_type>::read(r);
+                auto it = index_.find(key);
+                if(it != index_.end() && it->second.segment == id && it->second.offset == offset) {
+                    fn(it, std::string_view(data).substr(offset, kHeaderBytes + payload));
+                }
+                offset += kHeaderBytes + payload;
+            }
+        }
+
+        void retire(std::uint32_t id){
+            auto it = segments_.find(id);
+            file_bytes_ -= it->second.bytes;
+            live_bytes_ -= it->second.live;
+            close_segment(it->second);
+            segments_.erase(it);
+        }
+
+        // Moves a sealed segment's live, unexpired records to the active
+        // segment and deletes it.
+        void compact_segment(std::uint32_t id, time_point now){
+            for_each_live(id, [&](typename Index::iterator it, std::string_view record){
+                Location& loc = it->second;
+                segments_.at(id).live -= loc.length;
+                live_bytes_ -= loc.length;
+                if(now > loc.expiry) index_.erase(it);
+                else loc = append(record, loc.expiry);
+            });
+            retire(id);
+            stats_.compactions++;
+        }
+
+        // Deletes the oldest sealed segment along with its entries.
+        void drop_oldest(){
+            const std::uint32_t id = segments_.begin()->first;
+            for_each_live(id, [&](typename Index::iterator it, std::string_view){
+                release(it->second);
+                index_.erase(it);
+                stats_.dropped++;
+            });
+            retire(id);
+        }
+
+        void compact_sealed(time_point now){
+            std::vector<std::uint32_t> victims;
+            for(const auto& [id, seg] : segments_){
+                if(id != active_ && static_cast<double>(seg.live) < opt_.compact_below * static_cast<double>(seg.bytes)) {
+                    victims.push_back(id);
+                }
+            }
+            for(std::uint32_t id : victims) compact_segment(id, now);
+        }
+
+        // Runs after each append: only sealing a segment can make a new
+        // compaction candidate, and only appends grow the files.
+        void maintain(time_point now){
+            if(active_ != last_active_) {
+                last_active_ = active_;
+                compact_sealed(now);
+            }
+            while(opt_.max_bytes && file_bytes_ > opt_.max_bytes && segments_.size() > 1) drop_oldest();
+        }
+
+        SpillOptions opt_;
+        std::string dir_;                // This instance's subdirectory of opt_.directory
+        Index index_;
+        std::map<std::uint32_t, Segment> segments_;  // Oldest first
+        std::uint32_t next_segment_ = 0;
+        std::uint32_t active_ = 0;
+        std::uint32_t last_active_ = 0;
+        std::uint64_t flushed_ = 0;      // Bytes of the active segment on disk
+        std::string pending_;            // Active segment bytes past flushed_
+        std::string record_;
+        std::string scratch_;
+        std::uint64_t file_bytes_ = 0;
+        std::uint64_t live_bytes_ = 0;
+        SpillStats stats_;
+        std::unique_ptr<IoUring> ring_;  // io_uring backend only
+        std::vector<BatchRead> batch_;
+        std::string batch_buf_;
+        std::vector<std::pair<std::size_t, std::size_t>> short_reads_;
+    };
+
+    // LruStore in memory backed by a SpillFile for what it evicts.
+    template<typename K, typename V>
+    class SpillStore {
+      public:
+        using key_type = K;
+        using value_type = V;
+        using time_point = Clock::time_point;
+
+        SpillStore(std::size_t capacity, std::uint64_t ttl_seconds, SpillOptions options)
+            : memory_(capacity, ttl_seconds), spill_(std::move(options)) {
+            memory_.set_eviction_handler([this](const key_type& key, value_type&& value, time_point expiry){
+                spill_.put(key, value, expiry);
+            });
+        }
+
+        SpillStore(const SpillStore&) = delete;
+        SpillStore& operator=(const SpillStore&) = delete;
+
+        std::optional<value_type> get(const key_type& key){
+            return get(key, Clock::now());
+        }
+
+        // Memory first; on a miss the entry is promoted from disk with the
+        // TTL it had left, which may spill another one.
+        std::optional<value_type> get(const key_type& key, time_point now){
+            if(auto v = memory_.get(key, now)) return v;
+            time_point expiry;
+            std::optional<value_type> v = spill_.take(key, now, &expiry);
+            if(v) memory_.put_until(key, *v, expiry);
+            return v;
+        }
+
+        // get() for a batch of keys: memory hits are served first and the
+        // rest read from disk in one batch, then promoted.
+        std::vector<std::optional<value_type>> get_many(const std::vector<key_type>& keys, time_point now){
+            std::vector<std::optional<value_type>> out(keys.size());
+            std::vector<std::size_t> missed;
+            std::vector<key_type> missed_keys;
+            for(std::size_t i = 0; i < keys.size(); i++){
+                out[i] = memory_.get(keys[i], now);
+                if(out[i]) continue;
+                missed.push_back(i);
+                missed_keys.push_back(keys[i]);
+            }
+            if(missed.empty()) return out;
+            std::vector<time_point> expiries;
+            std::vector<std::optional<value_type>> found = spill_.take_many(missed_keys, now, &expiries);
+            for(std::size_t j = 0; j < missed.size(); j++){
+                if(!found[j]) continue;
+                memory_.put_until(missed_keys[j], *found[j], expiries[j]);
+                out[missed[j]] = std::move(found[j]);
+            }
+            return out;
+        }
+
+        void put(const key_type& key, value_type value){
+            put(key, std::move(value), Clock::now());
+        }
+
+        void put(const key_type& key, value_type value, time_point now){
+            spill_.erase(key);
+            memory_.put(key, std::move(value), now);
+        }
+
+        bool erase(const key_type& key){
+            const bool in_memory = memory_.erase(key);
+            return spill_.erase(key) || in_memory;
+        }
+
+        void clear(){
+            memory_.clear();
+            spill_.clear();
+        }
+
+        // Entries in memory plus on disk
+        std::size_t size() const noexcept { return memory_.size() + spill_.size(); }
+
+        LruStore<key_type, value_type>& memory() noexcept { return memory_; }
+        SpillFile<key_type, value_type>& spill() noexcept { return spill_; }
+
+      private:
+        LruStore<key_type, value_type> memory_;
+        SpillFile<key_type, value_type> spill_;
+    };
+}
@@ -0,0 +1,266 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// -----------------------------------------------------------------------------
+// tick_series.hpp
+// Fixed-capacity ring of the most recent (timestamp, price, size) ticks,
+// meant to be stored as a cache value and appended to in place, with
+// vectorised aggregates over the cached window.
+// -----------------------------------------------------------------------------
+// - Structure of arrays: timestamps, prices and sizes live in three separate
+//   arrays, so an aggregate streams through one or two contiguous runs of
+//   doubles instead of striding over records.
+// - append() is O(1) and never allocates. Once full, each append overwrites
+//   the oldest tick.
+// - Aggregates take `last`, the number of most recent ticks to cover
+//   (default: all cached). The window wraps at most once, so it is handled
+//   as at most two contiguous spans.
+// - The kernels use AVX (4 doubles) or SSE2 (2 doubles) with several
+//   accumulators, and fall back to scalar code elsewhere. Results can differ
+//   from a naive left-to-right sum in the last bits.
+//
+// With the in-place cache APIs, a tick costs one append and no copies:
+//
+//   auto cache = LocalCache<TickSeries<256>>::initialize(1000, 0);
+//   cache.upsert_item("AAPL", [&](auto& s){ s.append(ts, price, size); });
+//   double vwap = 0;
+//   cache.read_item("AAPL", [&](const auto& s){ vwap = s.vwap(50); });
+// -----------------------------------------------------------------------------
+
+namespace locallru {
+
+    namespace simd {
+#if defined(__AVX__)
+        inline double hsum(__m256d v){
+            const __m128d lo = _mm256_castpd256_pd128(v), hi = _mm256_extractf128_pd(v, 1);
+            const __m128d s = _mm_add_pd(lo, hi);
+            return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+        }
+#endif
+
+        inline double sum(const double* x, std::size_t n){
+            std::size_t i = 0;
+            double total = 0.0;
+#if defined(__AVX__)
+            __m256d a0 = _mm256_setzero_pd(), a1 = _mm256_setzero_pd();
+            for(; i + 8 <= n; i += 8){
+                a0 = _mm256_add_pd(a0, _mm256_loadu_pd(x + i));
+                a1 = _mm256_add_pd(a1, _mm256_loadu_pd(x + i + 4));
+            }
+            total = hsum(_mm256_add_pd(a0, a1));
+#elif defined(__SSE2__)
+            __m128d a0 = _mm_setzero_pd(), a1 = _mm_setzero_pd();
+            for(; i + 4 <= n; i += 4){
+                a0 = _mm_add_pd(a0, _mm_loadu_pd(x + i));
+                a1 = _mm_add_pd(a1, _mm_loadu_pd(x + i + 2));
+            }
+            const __m128d s = _mm_add_pd(a0, a1);
+            total = _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+#endif
+            for(; i < n; i++) total += x[i];
+            return total;
+        }
+
+        inline double dot(const double* x, const double* y, std::size_t n){
+            std::size_t i = 0;
+            double total = 0.0;
+#if defined(__AVX__)
+            __m256d a0 = _mm256_setzero_pd(), a1 = _mm256_setzero_pd();
+            for(; i + 8 <= n; i += 8){
+                a0 = _mm256_add_pd(a0, _mm256_mul_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+                a1 = _mm256_add_pd(a1, _mm256_mul_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4)));
+            }
+            total = hsum(_mm256_add_pd(a0, a1));
+#elif defined(__SSE2__)
+            __m128d a0 = _mm_setzero_pd(), a1 = _mm_setzero_pd();
+            for(; i + 4 <= n; i += 4){
+                a0 = _mm_add_pd(a0, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+                a1 = _mm_add_pd(a1, _mm_mul_pd(_mm_loadu_pd(x + i + 2), _mm_loadu_pd(y + i + 2)));
+            }
+            const __m128d s = _mm_add_pd(a0, a1);
+            total = _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+#endif
+            for(; i < n; i++) total += x[i] * y[i];
+            return total;
+        }
+
+        // Sum of (x[i] - mean)^2
+        inline double sum_sq_dev(const double* x, std::size_t n, double mean){
+            std::size_t i = 0;
+            double total = 0.0;
+#if defined(__AVX__)
+            const __m256d m = _mm256_set1_pd(mean);
+            __m256d a0 = _mm256_setzero_pd(), a1 = _mm256_setzero_pd();
+            for(; i + 8 <= n; i += 8){
+                const __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(x + i), m);
+                const __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(x + i + 4), m);
+                a0 = _mm256_add_pd(a0, _mm256_mul_pd(d0, d0));
+                a1 = _mm256_add_pd(a1, _mm256_mul_pd(d1, d1));
+            }
+            total = hsum(_mm256_add_pd(a0, a1));
+#elif defined(__SSE2__)
+            const __m128d m = _mm_set1_pd(mean);
+            __m128d a0 = _mm_setzero_pd(), a1 = _mm_setzero_pd();
+            for(; i + 4 <= n; i += 4){
+                const __m128d d0 = _mm_sub_pd(_mm_loadu_pd(x + i), m);
+                const __m128d d1 = _mm_sub_pd(_mm_loadu_pd(x + i + 2), m);
+                a0 = _mm_add_pd(a0, _mm_mul_pd(d0, d0));
+                a1 = _mm_add_pd(a1, _mm_mul_pd(d1, d1));
+            }
+            const __m128d s = _mm_add_pd(a0, a1);
+            total = _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+#endif
+            for(; i < n; i++) total += (x[i] - mean) * (x[i] - mean);
+            return total;
+        }
+
+        // {min, max}; n must be > 0
+        inline std::pair<double, double> min_max(const double* x, std::size_t n){
+            std::size_t i = 0;
+            double lo = x[0], hi = x[0];
+#if defined(__AVX__)
+            if(n >= 4){
+                __m256d vlo = _mm256_loadu_pd(x), vhi = vlo;
+                for(i = 4; i + 4 <= n; i += 4){
+                    const __m256d v = _mm256_loadu_pd(x + i);
+                    vlo = _mm256_min_pd(vlo, v);
+                    vhi = _mm256_max_pd(vhi, v);
+                }
+                alignas(32) double l[4], h[4];
+                _mm256_store_pd(l, vlo);
+                _mm256_store_pd(h, vhi);
+                lo = std::min({l[0], l[1], l[2], l[3]});
+                hi = std::max({h[0], h[1], h[2], h[3]});
+            }
+#elif defined(__SSE2__)
+            if(n >= 2){
+                __m128d vlo = _mm_loadu_pd(x), vhi = vlo;
+                for(i = 2; i + 2 <= n; i += 2){
+                    const __m128d v = _mm_loadu_pd(x + i);
+                    vlo = _mm_min_pd(vlo, v);
+                    vhi = _mm_max_pd(vhi, v);
+                }
+                lo = std::min(_mm_cvtsd_f64(vlo), _mm_cvtsd_f64(_mm_unpackhi_pd(vlo, vlo)));
+                hi = std::max(_mm_cvtsd_f64(vhi), _mm_cvtsd_f64(_mm_unpackhi_pd(vhi, vhi)));
+            }
+#endif
+            for(; i < n; i++){
+                lo = std::min(lo, x[i]);
+                hi = std::max(hi, x[i]);
+            }
+            return {lo, hi};
+        }
+    }
+
+    template<std::size_t N>
+    class TickSeries {
+        static_assert(N > 0, "TickSeries needs room for at least one tick");
+
+      public:
+        static constexpr std::size_t capacity() noexcept { return N; }
+        std::size_t size() const noexcept { return count_; }
+        bool empty() const noexcept { return count_ == 0; }
+
+        void append(std::int64_t ts_ns, double price, double size = 1.0){
+            ts_[head_] = ts_ns;
+            price_[head_] = price;
+            size_[head_] = size;
+            head_ = head_ + 1 == N ? 0 : head_ + 1;
+            if(count_ < N) count_++;
+        }
+
+        void clear() noexcept { head_ = count_ = 0; }
+
+        // i-th most recent tick, 0 = latest; i must be < size()
+        std::int64_t timestamp(std::size_t i = 0) const { return ts_[slot(i)]; }
+        double price(std::size_t i = 0) const { return price_[slot(i)]; }
+        double volume(std::size_t i = 0) const { return size_[slot(i)]; }
+
+        // Aggregates over the `last` most recent ticks (clamped to size()).
+        // Empty windows yield NaN.
+        double mean(std::size_t last = N) const {
+            const std::size_t n = window(last);
+            return n ? fold(n, simd::sum, price_) / static_cast<double>(n) : kNaN;
+        }
+
+        // Volume-weighted average price; NaN if the window's volume is 0
+        double vwap(std::size_t last = N) const {
+            const std::size_t n = window(last);
+            const double volume = fold(n, simd::sum, size_);
+            if(n == 0 || volume == 0.0) return kNaN;
+            double notional = 0.0;
+            for_each_run(n, [&](std::size_t from, std::size_t len){ notional += simd::dot(&price_[from], &size_[from], len); });
+            return notional / volume;
+        }
+
+        double min(std::size_t last = N) const { return extremes(last).first; }
+        double max(std::size_t last = N) const { return extremes(last).second; }
+
+        // Population variance / standard deviation (two-pass)
+        double variance(std::size_t last = N) const {
+            const std::size_t n = window(last);
+            if(n == 0) return kNaN;
+            const double m = fold(n, simd::sum, price_) / static_cast<double>(n);
+            double ss = 0.0;
+            for_each_run(n, [&](std::size_t from, std::size_t len){ ss += simd::sum_sq_dev(&price_[from], len, m); });
+            return ss / static_cast<double>(n);
+        }
+        double stddev(std::size_t last = N) const { return std::sqrt(variance(last)); }
+
+      private:
+        static constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+        std::size_t window(std::size_t last) const noexcept { return std::min(last, count_); }
+
+        std::size_t slot(std::size_t i) const noexcept { return (head_ + N - 1 - i) % N; }
+
+        // Calls fn(first_index, length) for the (at most two) contiguous runs
+        // holding the n most recent ticks.
+        template<typename F>
+        void for_each_run(std::size_t n, F&& fn) const {
+            if(n == 0) return;
+            const std::size_t start = (head_ + N - n) % N;
+            if(start + n <= N) {
+                fn(start, n);
+            } else {
+                fn(start, N - start);
+                fn(std::size_t{0}, n - (N - start));
+            }
+        }
+
+        template<typename Kernel>
+        double fold(std::size_t n, Kernel kernel, const std::array<double, N>& column) const {
+            double total = 0.0;
+            for_each_run(n, [&](std::size_t from, std::size_t len){ total += kernel(&column[from], len); });
+            return total;
+        }
+
+        std::pair<double, double> extremes(std::size_t last) const {
+            const std::size_t n = window(last);
+            if(n == 0) return {kNaN, kNaN};
+            std::pair<double, double> r{std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()};
+            for_each_run(n, [&](std::size_t from, std::size_t len){
+                const auto [lo, hi] = simd::min_max(&price_[from], len);
+                r.first = std::min(r.first, lo);
+                r.second = std::max(r.second, hi);
+            });
+            return r;
+        }
+
+        std::array<std::int64_t, N> ts_{};
+        std::array<double, N> price_{};
+        std::array<double, N> size_{};
+        std::size_t head_ = 0;        // Next slot to write
+        std::size_t count_ = 0;
+    };
+}
@@ -0,0 +1,139 @@
+import argparse
+import json
+import math
+import sys
+
+# Compares two locallru_bench JSON result files (--out=FILE) benchmark by
+# benchmark. Each repetition is one sample; a change is reported as a
+# regression when the contender is slower by more than --threshold AND a
+# two-sided Mann-Whitney U test rejects "same distribution" at --alpha.
+# Exits with status 1 if any regression is found, so it can gate merges.
+#
+# Run both sides with --repetitions of at least 5: with fewer samples no
+# difference can reach significance at alpha = 0.05.
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    samples = {}
+    for b in data.get("benchmarks", []):
+        if b.get("run_type") != "iteration" or b.get("error"):
+            continue
+        samples.setdefault(b["run_name"], []).append(float(b["ns_per_op"]))
+    return data.get("context", {}), samples
+
+
+def ranks(values):
+    # Average ranks (1-based), ties share the mean of their positions.
+    order = sorted(range(len(values)), key=lambda i: values[i])
+    r = [0.0] * len(values)
+    i = 0
+    while i < len(order):
+        j = i
+        while j + 1 < len(order) and values[order[j + 1]] == values[order[i]]:
+            j += 1
+        for k in range(i, j + 1):
+            r[order[k]] = (i + j) / 2.0 + 1.0
+        i = j + 1
+    return r
+
+
+def exact_u_pvalue(u, n1, n2):
+    # Two-sided exact p-value from the null distribution of U (no ties).
+    # f(u, m, n) = f(u - n, m - 1, n) + f(u, m, n - 1): the largest value
+    # belongs to sample 1 (adding n to U) or to sample 2.
+    memo = {}
+
+    def f(uu, m, n):
+        if uu < 0:
+            return 0
+        if m == 0 or n == 0:
+            return 1 if uu == 0 else 0
+        key = (uu, m, n)
+        if key not in memo:
+            memo[key] = f(uu - n, m - 1, n) + f(uu, m, n - 1)
+        return memo[key]
+
+    lo = int(math.floor(min(u, n1 * n2 - u)))
+    tail = sum(f(k, n1, n2) for k in range(lo + 1))
+    return min(1.0, 2.0 * tail / math.comb(n1 + n2, n1))
+
+
+def mann_whitney(a, b):
+    n1, n2 = len(a), len(b)
+    r = ranks(a + b)
+    r1 = sum(r[:n1])
+    u = r1 - n1 * (n1 + 1) / 2.0
+    tied = len(set(a + b)) != n1 + n2
+    if not tied and n1 + n2 <= 40:
+        return exact_u_pvalue(u, n1, n2)
+    # Normal approximation with tie correction and continuity correction.
+    n = n1 + n2
+    counts = {}
+    for v in a + b:
+        counts[v] = counts.get(v, 0) + 1
+    tie_term = sum(t ** 3 - t for t in counts.values())
+    sigma = math.sqrt(n1 * n2 / 12.0 * ((n + 1) - tie_term / (n * (n - 1))))
+    if sigma == 0:
+        return 1.0
+    z = (abs(u - n1 * n2 / 2.0) - 0.5) / sigma
+    return math.erfc(max(z, 0.0) / math.sqrt(2.0))
+
+
+def median(v):
+    s = sorted(v)
+    m = len(s) // 2
+    return s[m] if len(s) % 2 else (s[m - 1] + s[m]) / 2.0
+
+
+def compare(baseline, contender, alpha, threshold):
+    base_ctx, base = load(baseline)
+    new_ctx, new = load(contender)
+
+    for key in ("cpu", "compiler", "cxx_flags", "build_type"):
+        if base_ctx.get(key) != new_ctx.get(key):
+            print(f"warning: {key} differs: '{base_ctx.get(key)}' vs '{new_ctx.get(key)}'")
+
+    names = [n for n in base if n in new]
+    if not names:
+        print("No benchmarks in common.")
+        return 0
+
+    width = max(len(n) for n in names)
+    print(f"{'Benchmark':<{width}} {'base ns':>10} {'new ns':>10} {'change':>8} {'p-value':>8}  verdict")
+    print("-" * (width + 52))
+    regressions = 0
+    for name in names:
+        a, b = base[name], new[name]
+        ma, mb = median(a), median(b)
+        change = (mb - ma) / ma if ma > 0 else 0.0
+        if len(a) < 2 or len(b) < 2:
+            p, verdict = float("nan"), "n/a (need repetitions)"
+        else:
+            p = mann_whitney(a, b)
+            if p < alpha and change > threshold:
+                verdict = "REGRESSION"
+                regressions += 1
+            elif p < alpha and change < -threshold:
+                verdict = "improved"
+            else:
+                verdict = ""
+        print(f"{name:<{width}} {ma:>10.2f} {mb:>10.2f} {change * 100:>+7.1f}% {p:>8.4f}  {verdict}")
+
+    only = sorted(set(base) ^ set(new))
+    if only:
+        print(f"\n{len(only)} benchmark(s) present in only one file were skipped.")
+    print(f"\n{regressions} regression(s) at alpha={alpha}, threshold={threshold * 100:.1f}%")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Compare two locallru_bench JSON result files.")
+    parser.add_argument("baseline")
+    parser.add_argument("contender")
+    parser.add_argument("--alpha", type=float, default=0.05, help="significance level (default 0.05)")
+    parser.add_argument("--threshold", type=float, default=0.05,
+                        help="minimum relative slowdown to flag (default 0.05 = 5%%)")
+    args = parser.parse_args()
+    sys.exit(compare(args.baseline, args.contender, args.alpha, args.threshold))
@@ -0,0 +1,167 @@
+#pragma once
+#include "spsc_ring.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// async_log.hpp
+// Asynchronous binary logger: hot threads push fixed-size records into their
+// own lock-free ring; a background thread drains every ring and hands the
+// records to a consumer that formats and writes them.
+// -----------------------------------------------------------------------------
+// - log() is a copy into a thread-local SPSC ring: no formatting, no locks,
+//   no syscalls. A thread's ring is created (under a mutex) on its first
+//   log() call only.
+// - Records from one thread reach the consumer in order. Records from
+//   different threads are not globally ordered.
+// - When a ring is full the producer either spins until the writer catches
+//   up (Overflow::block, the default, so no record is lost) or drops the
+//   record and counts it (Overflow::drop).
+// - stop() (also run by the destructor) drains everything still queued
+//   before returning. A record that finds its ring full after that is
+//   dropped and counted, whatever the overflow policy.
+// -----------------------------------------------------------------------------
+
+namespace locallru::logging {
+
+    enum class Overflow { block, drop };
+
+    template<typename Record>
+    class AsyncLogger {
+        static_assert(std::is_trivially_copyable_v<Record>, "log records are copied as raw bytes");
+
+      public:
+        using Consumer = std::function<void(const Record&)>;
+
+        explicit AsyncLogger(Consumer consumer, std::size_t ring_capacity = 1 << 16,
+                             Overflow overflow = Overflow::block)
+            : consumer_(std::move(consumer)), ring_capacity_(ring_capacity), overflow_(overflow),
+              id_(next_id()), writer_([this] { run(); }) {
+            std::lock_guard<std::mutex> lock(live_mutex());
+            live_ids().insert(id_);
+        }
+
+        AsyncLogger(const AsyncLogger&) = delete;
+        AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+        ~AsyncLogger(){
+            stop();
+            std::lock_guard<std::mutex> lock(live_mutex());
+            live_ids().erase(id_);
+        }
+
+        void log(const Record& r){
+            Ring& ring = local_ring();
+            if(ring.try_push(r)) [[likely]] return;
+            if(overflow_ == Overflow::drop) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            stalls_.fetch_add(1, std::memory_order_relaxed);
+            while(!ring.try_push(r)){
+                if(stopped_.load(std::memory_order_acquire)) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                std::this_thread::yield();
+            }
+        }
+
+        // Drains all queued records and joins the writer thread. Records
+        // logged after stop() returns are discarded.
+        void stop(){
+            if(stopping_.exchange(true)) return;
+            writer_.join();
+            stopped_.store(true, std::memory_order_release);
+        }
+
+        std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+        std::uint64_t stalls() const { return stalls_.load(std::memory_order_relaxed); }
+
+      private:
+        using Ring = SpscRing<Record>;
+
+        static std::uint64_t next_id(){
+            static std::atomic<std::uint64_t> id{1};
+            return id.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Ids of loggers not yet destroyed.
+        static std::mutex& live_mutex(){
+            static std::mutex m;
+            return m;
+        }
+
+        static std::unordered_set<std::uint64_t>& live_ids(){
+            static std::unordered_set<std::uint64_t> ids;
+            return ids;
+        }
+
+        // Each thread remembers its ring per logger id; ids are never reused,
+        // so an entry left behind by a destroyed logger can't be matched.
+        // Such entries are pruned whenever the thread adds a ring.
+        Ring& local_ring(){
+            thread_local std::vector<std::pair<std::uint64_t, Ring*>> mine;
+            if(!mine.empty() && mine.back().first == id_) [[likely]] return *mine.back().second;
+            for(auto& [id, ring] : mine){
+                if(id == id_) return *ring;
+            }
+            {
+                std::lock_guard<std::mutex> lock(live_mutex());
+                std::erase_if(mine, [](const auto& entry){ return !live_ids().contains(entry.first); });
+            }
+            std::lock_guard<std::mutex> lock(rings_mutex_);
+            rings_.push_back(std::make_unique<Ring>(ring_capacity_));
+            ring_count_.store(rings_.size(), std::memory_order_release);
+            mine.emplace_back(id_, rings_.back().get());
+            return *rings_.back();
+        }
+
+        // Writer thread only. The ring list is copied under the lock only
+        // when a ring was added since the last pass.
+        std::size_t drain(){
+            if(ring_count_.load(std::memory_order_acquire) != draining_.size()) {
+                std::lock_guard<std::mutex> lock(rings_mutex_);
+                draining_.clear();
+                for(const auto& ring : rings_) draining_.push_back(ring.get());
+            }
+            std::size_t n = 0;
+            for(Ring* ring : draining_) n += ring->consume(consumer_);
+            return n;
+        }
+
+        void run(){
+            while(!stopping_.load(std::memory_order_acquire)){
+                if(drain() == 0) std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+            while(drain() != 0) {}
+        }
+
+        Consumer consumer_;
+        const std::size_t ring_capacity_;
+        const Overflow overflow_;
+        const std::uint64_t id_;
+
+        std::mutex rings_mutex_;
+        std::vector<std::unique_ptr<Ring>> rings_;
+        std::atomic<std::size_t> ring_count_{0};
+        std::vector<Ring*> draining_;   // Writer's copy of rings_
+
+
+        std::atomic<bool> stopping_{false};
+        std::atomic<bool> stopped_{false};   // Writer joined
+        std::atomic<std::uint64_t> dropped_{0};
+        std::atomic<std::uint64_t> stalls_{0};
+        std::thread writer_; // Last: started once everything above exists
+    };
+}
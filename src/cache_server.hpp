@@ -0,0 +1,824 @@
+#pragma once
+#include "memcache_protocol.hpp"
+#include "lock_cache.hpp"
+#include "../include/locallru/local_lru.hpp"
+#include "../include/locallru/io_uring.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// -----------------------------------------------------------------------------
+// cache_server.hpp
+// TCP server exposing a cache engine over the memcached text protocol, so
+// services in other languages can use the cache as a local sidecar.
+// -----------------------------------------------------------------------------
+// - One worker thread per core (optionally pinned), each with its own
+//   listening socket on the same port (SO_REUSEPORT, so the kernel spreads
+//   connections across workers) and its own epoll instance. A connection
+//   stays on the worker that accepted it; workers share nothing but the
+//   engine.
+// - Sockets are non-blocking and edge-triggered. Every pipelined request in
+//   a read is executed before anything is sent, and responses for all
+//   connections that became ready in one epoll_wait are sent after the
+//   batch: one recv and one send per connection per wakeup, however deep
+//   the pipeline.
+// - Backends: posix is the epoll loop above. io_uring (Linux 6.0+) keeps
+//   a multishot accept and one multishot recv per connection armed, with
+//   receive buffers picked by the kernel from a provided-buffer ring, so a
+//   worker's whole batch of sends plus the wait for the next completions is
+//   a single io_uring_enter. automatic uses io_uring when the kernel allows
+//   it and falls back to epoll otherwise.
+// - Engines adapt a store to read(key, fn) / put(key, item) / erase(key) /
+//   erase_if(key, pred): SharedEngine is one LockCache for all workers
+//   (every client sees every write); LocalEngine gives each worker its own
+//   LocalCache store, which only suits clients that keep to one
+//   connection, but shows the cost of the protocol and sockets alone.
+// - exptime is honoured per item (relative seconds, or a Unix time beyond
+//   30 days, as memcached does), on top of any store-wide TTL.
+//
+//   lockedlru::LockCache<std::string, CacheItem> store(1'000'000);
+//   CacheServer server(ServerOptions{}, SharedEngine(store));
+//   std::thread t([&]{ server.run(); });   // serves until stop()
+// -----------------------------------------------------------------------------
+
+namespace locallru::server {
+
+    struct CacheItem {
+        std::uint32_t flags = 0;
+        std::int64_t expires_ns = 0;   // steady_clock; 0 = never
+        std::uint64_t cas = 0;         // Unique per stored item, for gets
+        std::string data;
+    };
+
+    // One LockCache shared by every worker.
+    class SharedEngine {
+      public:
+        using Store = lockedlru::LockCache<std::string, CacheItem>;
+        explicit SharedEngine(Store& store) : store_(&store) {}
+
+        template<typename F>
+        bool read(const std::string& key, F&& fn){ return store_->read(key, std::forward<F>(fn)); }
+        void put(const std::string& key, CacheItem item){ store_->put(key, std::move(item)); }
+        bool erase(const std::string& key){ return store_->erase(key); }
+
+        template<typename P>
+        bool erase_if(const std::string& key, P&& pred){ return store_->erase_if(key, std::forward<P>(pred)); }
+
+      private:
+        Store* store_;
+    };
+
+    // The calling worker thread's LocalCache store; size it with
+    // LocalCache<CacheItem>::initialize() before starting the server.
+    class LocalEngine {
+      public:
+        template<typename F>
+        bool read(const std::string& key, F&& fn){ return cache_.read_item(key, std::forward<F>(fn)); }
+        void put(const std::string& key, CacheItem item){ cache_.add_item(key, std::move(item)); }
+        bool erase(const std::string& key){ return cache_.remove_item(key); }
+
+        // Only this thread uses the store, so nothing can change in between
+        template<typename P>
+        bool erase_if(const std::string& key, P&& pred){
+            bool match = false;
+            cache_.read_item(key, [&](const CacheItem& item){ match = pred(item); });
+            return match && cache_.remove_item(key);
+        }
+
+      private:
+        LocalCache<CacheItem> cache_;
+    };
+
+    struct ServerOptions {
+        std::string address = "127.0.0.1";
+        std::uint16_t port = 11211;          // 0 = any free port (see port())
+        int threads = 1;
+        bool pin_threads = false;            // Worker i on CPU i
+        int max_events = 256;                // Per epoll_wait
+        IoBackend backend = IoBackend::automatic;
+        unsigned ring_entries = 1024;        // io_uring submission queue size
+        unsigned recv_buffers = 1024;        // io_uring provided buffers (power of two)
+        std::size_t recv_buffer_bytes = 16u << 10;
+    };
+
+    struct ServerStats {
+        std::uint64_t connections = 0;
+        std::uint64_t requests = 0;
+        std::uint64_t get_keys = 0;
+        std::uint64_t get_hits = 0;
+        std::uint64_t sets = 0;
+        std::uint64_t deletes = 0;
+        std::uint64_t recv_calls = 0;
+        std::uint64_t send_calls = 0;
+        std::uint64_t syscalls = 0;          // Everything the event loops made
+    };
+
+    namespace detail {
+        [[noreturn]] inline void throw_errno(const std::string& what){
+            throw std::system_error(errno, std::generic_category(), what);
+        }
+
+        inline std::int64_t steady_ns(){
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // memcached exptime -> absolute steady_clock ns; 0 = never,
+        // -1 = already expired. Times too far out for int64 ns are never.
+        inline std::int64_t expiry_from(std::int64_t exptime, std::int64_t now_ns){
+            constexpr std::int64_t kRelativeLimit = 60 * 60 * 24 * 30;
+            if(exptime == 0) return 0;
+            if(exptime < 0) return -1;
+            std::int64_t seconds = exptime;
+            if(exptime > kRelativeLimit) {
+                const auto unix_now = std::chrono::duration_cast<std::chrono::seconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+                seconds = exptime - unix_now;
+                if(seconds <= 0) return -1;
+            }
+            if(seconds > (std::numeric_limits<std::int64_t>::max() - now_ns) / 1'000'000'000) return 0;
+            return now_ns + seconds * 1'000'000'000;
+        }
+
+        // Single-writer counter readable from other threads
+        inline void bump(std::atomic<std::uint64_t>& c, std::uint64_t n = 1){
+            c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        // Whether multishot accept (Linux 5.19) and multishot recv with
+        // provided buffers (6.0) work. Older kernels accept the ring and
+        // the buffers but fail these with -EINVAL, so both are tried once
+        // on a loopback connection.
+        inline bool uring_multishot_works(){
+            static const bool works = []{
+                int listener = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+                int client = -1;
+                int accepted = -1;
+                bool ok = false;
+                try {
+                    sockaddr_in sa{};
+                    sa.sin_family = AF_INET;
+                    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                    socklen_t len = sizeof(sa);
+                    if(listener < 0 || ::bind(listener, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) != 0 ||
+                       ::listen(listener, 1) != 0 || ::getsockname(listener, reinterpret_cast<sockaddr*>(&sa), &len) != 0) {
+                        throw std::system_error(errno, std::generic_category(), "probe listener");
+                    }
+                    IoUring ring(4);
+                    BufferRing bufs(ring, 0, 1, 64);
+                    io_uring_sqe* e = ring.sqe();
+                    e->opcode = IORING_OP_ACCEPT;
+                    e->fd = listener;
+                    e->ioprio = IORING_ACCEPT_MULTISHOT;
+                    e->accept_flags = SOCK_CLOEXEC;
+                    e->user_data = 1;
+                    ring.submit(0);
+                    client = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+                    if(client < 0 || ::connect(client, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) != 0) {
+                        throw std::system_error(errno, std::generic_category(), "probe connect");
+                    }
+                    bool accept_more = false;
+                    ring.submit(1);
+                    ring.for_each_cqe([&](const io_uring_cqe& c){
+                        if(c.user_data != 1) return;
+                        if(c.res >= 0) accepted = c.res;
+                        accept_more = c.flags & IORING_CQE_F_MORE;
+                    });
+                    if(accepted < 0 || !accept_more || ::send(client, "x", 1, MSG_NOSIGNAL) != 1) {
+                        throw std::system_error(EINVAL, std::generic_category(), "probe multishot accept");
+                    }
+                    e = ring.sqe();
+                    e->opcode = IORING_OP_RECV;
+                    e->fd = accepted;
+                    e->ioprio = IORING_RECV_MULTISHOT;
+                    e->flags = IOSQE_BUFFER_SELECT;
+                    e->buf_group = bufs.group();
+                    e->user_data = 2;
+                    ring.submit(1);
+                    ring.for_each_cqe([&](const io_uring_cqe& c){
+                        if(c.user_data == 2) ok = c.res == 1 && (c.flags & IORING_CQE_F_MORE);
+                    });
+                } catch(const std::system_error&) {
+                    ok = false;
+                }
+                // The ring is gone by now, cancelling whatever was in flight
+                for(int fd : {accepted, client, listener}) if(fd >= 0) ::close(fd);
+                return ok;
+            }();
+            return works;
+        }
+    }
+
+    template<typename Engine>
+    class CacheServer {
+      public:
+        // Binds every worker's listening socket, so address and port errors
+        // surface here rather than in run().
+        CacheServer(ServerOptions options, Engine engine) : opt_(std::move(options)) {
+            opt_.threads = std::max(1, opt_.threads);
+            opt_.max_events = std::max(1, opt_.max_events);
+            backend_ = resolve_backend(opt_.backend);
+            stop_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if(stop_fd_ < 0) detail::throw_errno("eventfd");
+            try {
+                for(int i = 0; i < opt_.threads; i++){
+                    workers_.push_back(std::make_unique<Worker>(*this, engine, i));
+                    workers_.back()->listen_fd = listen_socket();
+                }
+            } catch(...) {
+                close_all();
+                throw;
+            }
+        }
+
+        CacheServer(const CacheServer&) = delete;
+        CacheServer& operator=(const CacheServer&) = delete;
+        ~CacheServer(){ close_all(); }
+
+        std::uint16_t port() const noexcept { return opt_.port; }
+        IoBackend backend() const noexcept { return backend_; }
+
+        // Serves on opt.threads worker threads until stop(); rethrows the
+        // first worker error, if any.
+        void run(){
+            std::vector<std::thread> threads;
+            for(auto& w : workers_){
+                threads.emplace_back([this, &w]{
+                    try {
+                        w->run();
+                    } catch(...) {
+                        {
+                            std::lock_guard<std::mutex> lock(error_mutex_);
+                            if(!error_) error_ = std::current_exception();
+                        }
+                        stop();
+                    }
+                });
+            }
+            for(auto& t : threads) t.join();
+            if(error_) std::rethrow_exception(error_);
+        }
+
+        // Safe from any thread and from signal handlers.
+        void stop() noexcept {
+            const std::uint64_t one = 1;
+            [[maybe_unused]] const auto n = ::write(stop_fd_, &one, sizeof(one));
+        }
+
+        ServerStats stats() const {
+            ServerStats s;
+            for(const auto& w : workers_){
+                s.connections += w->connections.load(std::memory_order_relaxed);
+                s.requests += w->requests.load(std::memory_order_relaxed);
+                s.get_keys += w->get_keys.load(std::memory_order_relaxed);
+                s.get_hits += w->get_hits.load(std::memory_order_relaxed);
+                s.sets += w->sets.load(std::memory_order_relaxed);
+                s.deletes += w->deletes.load(std::memory_order_relaxed);
+                s.recv_calls += w->recv_calls.load(std::memory_order_relaxed);
+                s.send_calls += w->send_calls.load(std::memory_order_relaxed);
+                s.syscalls += w->syscalls.load(std::memory_order_relaxed);
+            }
+            return s;
+        }
+
+      private:
+        static constexpr std::size_t kReadChunk = 16u << 10;
+        static constexpr std::string_view kVersion = "VERSION locallru-1.0\r\n";
+
+        struct Connection {
+            int fd = -1;
+            std::string in;               // Received bytes are in[0, in_len)
+            std::size_t in_len = 0;
+            std::string out;              // Unsent bytes are out[out_off, size)
+            std::size_t out_off = 0;
+            bool closing = false;         // Close once out is flushed
+            bool pending = false;         // Queued for the end-of-batch flush
+            bool want_write = false;      // Registered for EPOLLOUT
+            // io_uring: one send in flight at a time from `sending`, while
+            // new responses collect in `out`
+            std::string sending;
+            std::size_t send_off = 0;
+            bool send_inflight = false;
+            bool recv_armed = false;
+            bool cancel_sent = false;
+        };
+
+        struct Worker {
+            Worker(CacheServer& s, const Engine& e, int i) : server(s), engine(e), index(i) {}
+            ~Worker(){
+                for(auto& c : conns) if(c) ::close(c->fd);
+                if(epoll_fd >= 0) ::close(epoll_fd);
+                if(listen_fd >= 0) ::close(listen_fd);
+            }
+
+            void run(){
+                if(server.opt_.pin_threads) {
+                    cpu_set_t set;
+                    CPU_ZERO(&set);
+                    CPU_SET(static_cast<unsigned>(index) % CPU_SETSIZE, &set);
+                    ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+                }
+                if(server.backend_ == IoBackend::io_uring) run_uring();
+                else run_epoll();
+            }
+
+            void run_epoll(){
+                epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+                if(epoll_fd < 0) detail::throw_errno("epoll_create1");
+                watch(listen_fd, EPOLLIN);
+                watch(server.stop_fd_, EPOLLIN);
+
+                std::vector<epoll_event> events(static_cast<std::size_t>(server.opt_.max_events));
+                for(;;){
+                    const int n = ::epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), -1);
+                    detail::bump(syscalls);
+                    if(n < 0) {
+                        if(errno == EINTR) continue;
+                        detail::throw_errno("epoll_wait");
+                    }
+                    now_ns = detail::steady_ns();
+                    for(int i = 0; i < n; i++){
+                        const int fd = events[static_cast<std::size_t>(i)].data.fd;
+                        const std::uint32_t ev = events[static_cast<std::size_t>(i)].events;
+                        if(fd == server.stop_fd_) return;
+                        if(fd == listen_fd) {
+                            accept_all();
+                            continue;
+                        }
+                        Connection* c = conn(fd);
+                        if(!c) continue;
+                        // Peer shut down its side: answer what it sent, then close
+                        if(ev & (EPOLLRDHUP | EPOLLERR | EPOLLHUP)) c->closing = true;
+                        if(ev & EPOLLIN) on_readable(*c);
+                        queue(*c);
+                    }
+                    for(Connection* c : ready) flush(*c);
+                    ready.clear();
+                }
+            }
+
+            void watch(int fd, std::uint32_t events, int op = EPOLL_CTL_ADD){
+                epoll_event ev{};
+                ev.events = events;
+                ev.data.fd = fd;
+                detail::bump(syscalls);
+                if(::epoll_ctl(epoll_fd, op, fd, &ev) != 0) detail::throw_errno("epoll_ctl");
+            }
+
+            Connection* conn(int fd){
+                return static_cast<std::size_t>(fd) < conns.size() ? conns[static_cast<std::size_t>(fd)].get() : nullptr;
+            }
+
+            void accept_all(){
+                for(;;){
+                    const int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    detail::bump(syscalls);
+                    if(fd < 0) {
+                        if(errno == EINTR) continue;
+                        if(errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNABORTED) return;
+                        if(errno == EMFILE || errno == ENFILE) return; // Retried on the next connection
+                        detail::throw_errno("accept4");
+                    }
+                    watch(add_connection(fd).fd, EPOLLIN | EPOLLRDHUP | EPOLLET);
+                }
+            }
+
+            Connection& add_connection(int fd){
+                const int one = 1;
+                ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                detail::bump(syscalls);
+                if(static_cast<std::size_t>(fd) >= conns.size()) conns.resize(static_cast<std::size_t>(fd) + 1);
+                auto c = std::make_unique<Connection>();
+                c->fd = fd;
+                conns[static_cast<std::size_t>(fd)] = std::move(c);
+                detail::bump(connections);
+                return *conns[static_cast<std::size_t>(fd)];
+            }
+
+            // Drains the socket, then executes every complete request.
+            void on_readable(Connection& c){
+                for(;;){
+                    if(c.in.size() - c.in_len < kReadChunk / 4) c.in.resize(std::max(c.in.size() * 2, kReadChunk));
+                    const std::size_t room = c.in.size() - c.in_len;
+                    const ssize_t n = ::recv(c.fd, c.in.data() + c.in_len, room, 0);
+                    detail::bump(recv_calls);
+                    detail::bump(syscalls);
+                    if(n > 0) {
+                        c.in_len += static_cast<std::size_t>(n);
+                        // A short read drained the socket; new data raises a new edge
+                        if(static_cast<std::size_t>(n) < room) break;
+                        continue;
+                    }
+                    if(n < 0 && errno == EINTR) continue;
+                    if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                    c.closing = true; // EOF or error: answer what arrived, then close
+                    break;
+                }
+                execute_all(c);
+            }
+
+            void execute_all(Connection& c){
+                std::size_t off = 0;
+                while(off < c.in_len){
+                    const ParseStatus st = parse_request(std::string_view(c.in.data() + off, c.in_len - off), req);
+                    if(st == ParseStatus::incomplete) break;
+                    if(st == ParseStatus::fatal) {
+                        c.out.append(req.error);
+                        c.closing = true;
+                        off = c.in_len;
+                        break;
+                    }
+                    off += req.length;
+                    detail::bump(requests);
+                    if(st == ParseStatus::error) {
+                        c.out.append(req.error);
+                        continue;
+                    }
+                    if(req.command == Command::quit) {
+                        c.closing = true;
+                        off = c.in_len;
+                        break;
+                    }
+                    execute(c.out);
+                }
+                if(off > 0) {
+                    std::memmove(c.in.data(), c.in.data() + off, c.in_len - off);
+                    c.in_len -= off;
+                }
+            }
+
+            void execute(std::string& out){
+                switch(req.command){
+                case Command::get:
+                case Command::gets: {
+                    const bool with_cas = req.command == Command::gets;
+                    std::uint64_t hits = 0;
+                    for(std::string_view k : req.keys){
+                        key.assign(k);
+                        bool expired = false;
+                        std::uint64_t expired_cas = 0;
+                        engine.read(key, [&](const CacheItem& item){
+                            if(item.expires_ns != 0 && now_ns > item.expires_ns) {
+                                expired = true;
+                                expired_cas = item.cas;
+                                return;
+                            }
+                            append_value(out, k, item.flags, item.data, with_cas ? &item.cas : nullptr);
+                            hits++;
+                        });
+                        // Only the item seen expired: another worker may
+                        // have set a fresh one since
+                        if(expired) engine.erase_if(key, [&](const CacheItem& item){ return item.cas == expired_cas; });
+                    }
+                    out.append(kEnd);
+                    detail::bump(get_keys, req.keys.size());
+                    detail::bump(get_hits, hits);
+                    break;
+                }
+                case Command::set: {
+                    key.assign(req.keys.front());
+                    const std::int64_t expires = detail::expiry_from(req.exptime, now_ns);
+                    if(expires < 0) {
+                        engine.erase(key);
+                    } else {
+                        const std::uint64_t cas = server.next_cas_.fetch_add(1, std::memory_order_relaxed) + 1;
+                        engine.put(key, CacheItem{req.flags, expires, cas, std::string(req.data)});
+                    }
+                    if(!req.noreply) out.append(kStored);
+                    detail::bump(sets);
+                    break;
+                }
+                case Command::del: {
+                    key.assign(req.keys.front());
+                    const bool erased = engine.erase(key);
+                    if(!req.noreply) out.append(erased ? kDeleted : kNotFound);
+                    detail::bump(deletes);
+                    break;
+                }
+                case Command::version:
+                    out.append(kVersion);
+                    break;
+                case Command::quit:
+                    break;
+                }
+            }
+
+            void queue(Connection& c){
+                if(c.pending) return;
+                c.pending = true;
+                ready.push_back(&c);
+            }
+
+            // Sends what is buffered; waits for EPOLLOUT if the socket is full
+            // and closes the connection once a closing one is drained.
+            void flush(Connection& c){
+                c.pending = false;
+                while(c.out_off < c.out.size()){
+                    const ssize_t n = ::send(c.fd, c.out.data() + c.out_off, c.out.size() - c.out_off, MSG_NOSIGNAL);
+                    detail::bump(send_calls);
+                    detail::bump(syscalls);
+                    if(n >= 0) {
+                        c.out_off += static_cast<std::size_t>(n);
+                        continue;
+                    }
+                    if(errno == EINTR) continue;
+                    if(errno == EAGAIN || errno == EWOULDBLOCK) break;
+                    close(c); // Peer gone
+                    return;
+                }
+                const bool drained = c.out_off == c.out.size();
+                if(drained) {
+                    c.out.clear();
+                    c.out_off = 0;
+                    if(c.closing) {
+                        close(c);
+                        return;
+                    }
+                }
+                if(drained == c.want_write) {
+                    c.want_write = !drained;
+                    watch(c.fd, EPOLLIN | EPOLLRDHUP | EPOLLET | (c.want_write ? EPOLLOUT : 0u), EPOLL_CTL_MOD);
+                }
+            }
+
+            void close(Connection& c){
+                const int fd = c.fd;
+                ::close(fd); // Also removes it from the epoll set
+                detail::bump(syscalls);
+                conns[static_cast<std::size_t>(fd)].reset();
+            }
+
+            // io_uring loop. user_data = kind << 32 | fd; a connection's fd is
+            // only closed once none of its operations is in flight.
+            enum Op : std::uint64_t { kAccept = 1, kRecv, kSend, kStop, kCancel, kAcceptRetry };
+
+            static std::uint64_t user_data(Op op, int fd){
+                return (static_cast<std::uint64_t>(op) << 32) | static_cast<std::uint32_t>(fd);
+            }
+
+            void run_uring(){
+                IoUring r(server.opt_.ring_entries);
+                BufferRing b(r, 0, server.opt_.recv_buffers, server.opt_.recv_buffer_bytes);
+                ring = &r;
+                bufs = &b;
+                arm_accept();
+                io_uring_sqe* e = ring->sqe();
+                e->opcode = IORING_OP_POLL_ADD;
+                e->fd = server.stop_fd_;
+                e->poll32_events = POLLIN;
+                e->user_data = user_data(kStop, server.stop_fd_);
+
+                bool stopping = false;
+                while(!stopping){
+                    const std::uint64_t before = ring->enters();
+                    ring->submit(1);
+                    detail::bump(syscalls, ring->enters() - before);
+                    now_ns = detail::steady_ns();
+                    ring->for_each_cqe([&](const io_uring_cqe& cqe){
+                        const auto op = static_cast<Op>(cqe.user_data >> 32);
+                        const int fd = static_cast<int>(cqe.user_data & 0xFFFFFFFFu);
+                        const bool more = cqe.flags & IORING_CQE_F_MORE;
+                        switch(op){
+                        case kAccept:
+                            if(cqe.res >= 0) arm_recv(add_connection(cqe.res));
+                            if(!more) on_accept_end(cqe.res);
+                            break;
+                        case kAcceptRetry:
+                            arm_accept();
+                            break;
+                        case kRecv:
+                            on_recv(fd, cqe);
+                            break;
+                        case kSend:
+                            if(Connection* c = conn(fd)) {
+                                c->send_inflight = false;
+                                if(cqe.res < 0) {
+                                    c->closing = true;
+                                    c->sending.clear();
+                                    c->out.clear();
+                                    c->send_off = 0;
+                                } else {
+                                    c->send_off += static_cast<std::size_t>(cqe.res);
+                                }
+                                queue(*c);
+                            }
+                            break;
+                        case kStop:
+                            stopping = true;
+                            break;
+                        case kCancel:
+                            break;
+                        }
+                    });
+                    for(Connection* c : ready) flush_uring(*c);
+                    ready.clear();
+                }
+                // In-flight operations die with the ring; the Worker closes fds
+                ring = nullptr;
+                bufs = nullptr;
+            }
+
+            void arm_accept(){
+                io_uring_sqe* e = ring->sqe();
+                e->opcode = IORING_OP_ACCEPT;
+                e->fd = listen_fd;
+                e->ioprio = IORING_ACCEPT_MULTISHOT;
+                e->accept_flags = SOCK_CLOEXEC;
+                e->user_data = user_data(kAccept, listen_fd);
+            }
+
+            // The multishot accept ended. As in the epoll loop, transient
+            // errors retry and others are fatal; out of descriptors retries
+            // after a pause rather than failing again at once.
+            void on_accept_end(int res){
+                if(res >= 0 || res == -EINTR || res == -EAGAIN || res == -ECONNABORTED) {
+                    arm_accept();
+                    return;
+                }
+                if(res == -EMFILE || res == -ENFILE) {
+                    accept_retry = __kernel_timespec{0, 10'000'000};
+                    io_uring_sqe* e = ring->sqe();
+                    e->opcode = IORING_OP_TIMEOUT;
+                    e->addr = reinterpret_cast<std::uint64_t>(&accept_retry);
+                    e->len = 1;
+                    e->user_data = user_data(kAcceptRetry, listen_fd);
+                    return;
+                }
+                throw std::system_error(-res, std::generic_category(), "io_uring accept");
+            }
+
+            void arm_recv(Connection& c){
+                io_uring_sqe* e = ring->sqe();
+                e->opcode = IORING_OP_RECV;
+                e->fd = c.fd;
+                e->ioprio = IORING_RECV_MULTISHOT;
+                e->flags = IOSQE_BUFFER_SELECT;
+                e->buf_group = bufs->group();
+                e->user_data = user_data(kRecv, c.fd);
+                c.recv_armed = true;
+            }
+
+            void on_recv(int fd, const io_uring_cqe& cqe){
+                Connection* c = conn(fd);
+                if(!c) return;
+                if(cqe.flags & IORING_CQE_F_BUFFER) {
+                    const auto id = static_cast<std::uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                    if(cqe.res > 0) {
+                        const auto n = static_cast<std::size_t>(cqe.res);
+                        if(c->in.size() - c->in_len < n) c->in.resize(std::max(c->in.size() * 2, c->in_len + n));
+                        std::memcpy(c->in.data() + c->in_len, bufs->data(id), n);
+                        c->in_len += n;
+                    }
+                    bufs->recycle(id);
+                }
+                detail::bump(recv_calls);
+                if(cqe.res > 0) {
+                    if(!c->closing) execute_all(*c);
+                }
+                else if(cqe.res != -ENOBUFS) c->closing = true; // EOF, error or cancelled
+                if(!(cqe.flags & IORING_CQE_F_MORE)) {
+                    c->recv_armed = false;
+                    if(!c->closing) arm_recv(*c); // Ran out of buffers; re-arm
+                }
+                queue(*c);
+            }
+
+            // Starts the next send if none is in flight; closes a closing
+            // connection once nothing is in flight or left to send.
+            void flush_uring(Connection& c){
+                c.pending = false;
+                if(!c.send_inflight) {
+                    if(c.send_off == c.sending.size()) {
+                        c.sending.clear();
+                        c.send_off = 0;
+                        std::swap(c.sending, c.out);
+                    }
+                    if(c.send_off < c.sending.size()) {
+                        io_uring_sqe* e = ring->sqe();
+                        e->opcode = IORING_OP_SEND;
+                        e->fd = c.fd;
+                        e->addr = reinterpret_cast<std::uint64_t>(c.sending.data() + c.send_off);
+                        e->len = static_cast<std::uint32_t>(c.sending.size() - c.send_off);
+                        e->msg_flags = MSG_NOSIGNAL;
+                        e->user_data = user_data(kSend, c.fd);
+                        c.send_inflight = true;
+                        detail::bump(send_calls);
+                    }
+                }
+                if(!c.closing || c.send_inflight || c.send_off < c.sending.size() || !c.out.empty()) return;
+                if(c.recv_armed) {
+                    if(!c.cancel_sent) {
+                        io_uring_sqe* e = ring->sqe();
+                        e->opcode = IORING_OP_ASYNC_CANCEL;
+                        e->addr = user_data(kRecv, c.fd);
+                        e->user_data = user_data(kCancel, c.fd);
+                        c.cancel_sent = true;
+                    }
+                    return; // Closed when the recv completes
+                }
+                close(c);
+            }
+
+            CacheServer& server;
+            Engine engine;
+            const int index;
+            int listen_fd = -1;
+            int epoll_fd = -1;
+            std::int64_t now_ns = 0;
+            IoUring* ring = nullptr;                         // io_uring backend only
+            BufferRing* bufs = nullptr;
+            __kernel_timespec accept_retry{};
+            std::vector<std::unique_ptr<Connection>> conns;  // Indexed by fd
+            std::vector<Connection*> ready;                  // To flush after this batch
+            Request req;
+            std::string key;
+            std::atomic<std::uint64_t> connections{0};
+            std::atomic<std::uint64_t> requests{0};
+            std::atomic<std::uint64_t> get_keys{0};
+            std::atomic<std::uint64_t> get_hits{0};
+            std::atomic<std::uint64_t> sets{0};
+            std::atomic<std::uint64_t> deletes{0};
+            std::atomic<std::uint64_t> recv_calls{0};
+            std::atomic<std::uint64_t> send_calls{0};
+            std::atomic<std::uint64_t> syscalls{0};
+        };
+
+        // The io_uring loop needs multishot accept and multishot recv with
+        // provided buffers on top of basic ring support; automatic probes
+        // them and falls back to epoll.
+        IoBackend resolve_backend(IoBackend requested) const {
+            if(requested != IoBackend::automatic) return requested;
+            if(!io_uring_supported() || !detail::uring_multishot_works()) return IoBackend::posix;
+            return IoBackend::io_uring;
+        }
+
+        // Non-blocking listener on opt_.port; the first one resolves port 0.
+        int listen_socket(){
+            const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if(fd < 0) detail::throw_errno("socket");
+            auto fail = [fd](const char* what){
+                const int err = errno;
+                ::close(fd);
+                errno = err;
+                detail::throw_errno(what);
+            };
+            const int one = 1;
+            if(::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0) fail("SO_REUSEADDR");
+            if(::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0) fail("SO_REUSEPORT");
+            sockaddr_in sa{};
+            sa.sin_family = AF_INET;
+            sa.sin_port = htons(opt_.port);
+            if(::inet_pton(AF_INET, opt_.address.c_str(), &sa.sin_addr) != 1) {
+                ::close(fd);
+                throw std::invalid_argument("not an IPv4 address: " + opt_.address);
+            }
+            if(::bind(fd, reinterpret_cast<const sockaddr*>(&sa), sizeof(sa)) != 0) fail("bind");
+            if(::listen(fd, SOMAXCONN) != 0) fail("listen");
+            if(opt_.port == 0) {
+                socklen_t len = sizeof(sa);
+                if(::getsockname(fd, reinterpret_cast<sockaddr*>(&sa), &len) != 0) fail("getsockname");
+                opt_.port = ntohs(sa.sin_port);
+            }
+            return fd;
+        }
+
+        void close_all() noexcept {
+            workers_.clear();
+            if(stop_fd_ >= 0) ::close(stop_fd_);
+            stop_fd_ = -1;
+        }
+
+        ServerOptions opt_;
+        IoBackend backend_ = IoBackend::posix;
+        int stop_fd_ = -1;
+        std::vector<std::unique_ptr<Worker>> workers_;
+        std::atomic<std::uint64_t> next_cas_{0};
+        std::mutex error_mutex_;
+        std::exception_ptr error_;
+    };
+}
@@ -0,0 +1,331 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// -----------------------------------------------------------------------------
+// csv_ingest.hpp
+// Fast loading of price CSVs: the file is memory-mapped, field and row
+// boundaries are found with a vectorised byte scan, numbers are parsed with
+// std::from_chars, and several files are loaded concurrently.
+// -----------------------------------------------------------------------------
+// - No per-row allocation: fields are string_views into the mapping.
+// - The scanner compares 32 (AVX2) or 16 (SSE2) bytes at a time against ','
+//   and '\n' and walks the resulting bitmask; other targets fall back to a
+//   byte loop.
+// - Plain CSV only: quoted fields containing separators are not supported.
+//   A trailing '\r' (CRLF files) is stripped from the last field of a row.
+// - Empty, "null" and "N/A" cells count as missing; anything else that does
+//   not parse completely as a double counts as invalid. Neither stops the
+//   load.
+// - parse_ticks() additionally reads an ISO-8601-style timestamp column
+//   (e.g. "2024-05-01 09:30:03-04:00") into UTC nanoseconds.
+// -----------------------------------------------------------------------------
+
+namespace locallru::feed {
+
+    // Read-only private mapping of a whole file. Empty files map to an empty
+    // view.
+    class MappedFile {
+      public:
+        explicit MappedFile(const std::string& path){
+            const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if(fd < 0) throw std::system_error(errno, std::generic_category(), "open " + path);
+            struct stat st{};
+            if(::fstat(fd, &st) != 0){
+                const int err = errno;
+                ::close(fd);
+                throw std::system_error(err, std::generic_category(), "fstat " + path);
+            }
+            size_ = static_cast<std::size_t>(st.st_size);
+            if(size_ > 0){
+                void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                if(p == MAP_FAILED){
+                    const int err = errno;
+                    ::close(fd);
+                    throw std::system_error(err, std::generic_category(), "mmap " + path);
+                }
+                data_ = static_cast<const char*>(p);
+                // Advice values are not flags: one call each
+                ::madvise(p, size_, MADV_SEQUENTIAL);
+                ::madvise(p, size_, MADV_WILLNEED);
+            }
+            ::close(fd); // The mapping keeps the file referenced
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        ~MappedFile(){
+            if(data_) ::munmap(const_cast<char*>(data_), size_);
+        }
+
+        std::string_view view() const noexcept { return {data_, size_}; }
+        std::size_t size() const noexcept { return size_; }
+
+      private:
+        const char* data_ = nullptr;
+        std::size_t size_ = 0;
+    };
+
+    namespace detail {
+#if defined(__AVX2__)
+        inline constexpr std::size_t kScanBlock = 32;
+        inline std::uint32_t match_block(const char* p, char a, char b){
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            const __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(a)),
+                                              _mm256_cmpeq_epi8(v, _mm256_set1_epi8(b)));
+            return static_cast<std::uint32_t>(_mm256_movemask_epi8(m));
+        }
+#elif defined(__SSE2__)
+        inline constexpr std::size_t kScanBlock = 16;
+        inline std::uint32_t match_block(const char* p, char a, char b){
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(a)),
+                                           _mm_cmpeq_epi8(v, _mm_set1_epi8(b)));
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(m));
+        }
+#else
+        inline constexpr std::size_t kScanBlock = 16;
+        inline std::uint32_t match_block(const char* p, char a, char b){
+            std::uint32_t mask = 0;
+            for(std::size_t i = 0; i < kScanBlock; i++){
+                if(p[i] == a || p[i] == b) mask |= 1u << i;
+            }
+            return mask;
+        }
+#endif
+    }
+
+    inline constexpr std::size_t kMaxCsvFields = 16;
+
+    // Calls on_row(std::span<const std::string_view> fields) for every
+    // non-empty line of `text`, header included. Fields past kMaxCsvFields
+    // are dropped. Returns the number of rows delivered.
+    template<typename OnRow>
+    std::size_t for_each_row(std::string_view text, OnRow&& on_row){
+        std::array<std::string_view, kMaxCsvFields> fields;
+        std::size_t nfields = 0;
+        std::size_t rows = 0;
+        const char* const end = text.data() + text.size();
+        const char* field_start = text.data();
+
+        auto structural = [&](const char* at){
+            if(nfields < kMaxCsvFields) fields[nfields++] = std::string_view(field_start, static_cast<std::size_t>(at - field_start));
+            field_start = at + 1;
+            if(at != end && *at == ',') return;
+            auto& last = fields[nfields - 1];
+            if(!last.empty() && last.back() == '\r') last.remove_suffix(1);
+            if(nfields > 1 || !fields[0].empty()){
+                on_row(std::span<const std::string_view>(fields.data(), nfields));
+                rows++;
+            }
+            nfields = 0;
+        };
+
+        const char* p = text.data();
+        for(; p + detail::kScanBlock <= end; p += detail::kScanBlock){
+            for(std::uint32_t mask = detail::match_block(p, ',', '\n'); mask; mask &= mask - 1){
+                structural(p + std::countr_zero(mask));
+            }
+        }
+        for(; p < end; ++p){
+            if(*p == ',' || *p == '\n') structural(p);
+        }
+        if(field_start < end || nfields > 0) structural(end); // Last line without '\n'
+        return rows;
+    }
+
+    struct ColumnData {
+        std::vector<double> values;
+        std::size_t rows = 0;         // Data rows seen (header excluded)
+        std::size_t missing = 0;      // Empty, "null" or "N/A"
+        std::size_t invalid = 0;      // Present but not a number
+        std::string error;            // Set by load_columns() if the file failed to load
+    };
+
+    enum class CellStatus { ok, missing, invalid };
+
+    // Parses a whole cell as a double; empty, "null" and "N/A" are missing.
+    inline CellStatus parse_number(std::string_view cell, double& out){
+        if(cell.empty() || cell == "null" || cell == "N/A") return CellStatus::missing;
+        const auto [ptr, ec] = std::from_chars(cell.data(), cell.data() + cell.size(), out);
+        return ec == std::errc{} && ptr == cell.data() + cell.size() ? CellStatus::ok : CellStatus::invalid;
+    }
+
+    namespace detail {
+        template<typename T>
+        bool parse_digits(std::string_view s, std::size_t pos, std::size_t n, T& out){
+            if(pos + n > s.size()) return false;
+            const auto [ptr, ec] = std::from_chars(s.data() + pos, s.data() + pos + n, out);
+            return ec == std::errc{} && ptr == s.data() + pos + n;
+        }
+    }
+
+    // Parses "YYYY-MM-DD", "YYYY-MM-DD HH:MM:SS" (or 'T' separator) with an
+    // optional fraction and an optional "Z" / "+HH:MM" / "-HH:MM" offset into
+    // nanoseconds since the Unix epoch, UTC. Times without an offset are
+    // taken as UTC.
+    inline std::optional<std::int64_t> parse_datetime(std::string_view s){
+        int y = 0;
+        unsigned mo = 0, d = 0, h = 0, mi = 0, sec = 0;
+        if(!detail::parse_digits(s, 0, 4, y) || s.size() < 10 || s[4] != '-' || s[7] != '-' ||
+           !detail::parse_digits(s, 5, 2, mo) || !detail::parse_digits(s, 8, 2, d)) return std::nullopt;
+        const std::chrono::year_month_day date{std::chrono::year{y}, std::chrono::month{mo}, std::chrono::day{d}};
+        if(!date.ok()) return std::nullopt;
+
+        std::int64_t ns = 0;
+        std::size_t pos = 10;
+        if(pos < s.size()){
+            if((s[pos] != ' ' && s[pos] != 'T') || s.size() < pos + 9 || s[pos + 3] != ':' || s[pos + 6] != ':' ||
+               !detail::parse_digits(s, pos + 1, 2, h) || !detail::parse_digits(s, pos + 4, 2, mi) ||
+               !detail::parse_digits(s, pos + 7, 2, sec) || h > 23 || mi > 59 || sec > 60) return std::nullopt;
+            ns = ((static_cast<std::int64_t>(h) * 60 + mi) * 60 + sec) * 1'000'000'000;
+            pos += 9;
+            if(pos < s.size() && s[pos] == '.'){
+                std::int64_t scale = 100'000'000;
+                for(pos++; pos < s.size() && s[pos] >= '0' && s[pos] <= '9'; pos++, scale /= 10){
+                    ns += (s[pos] - '0') * scale; // Digits past nanoseconds add 0
+                }
+            }
+            if(pos < s.size()){
+                if(s[pos] == 'Z') {
+                    pos++;
+                } else if(s[pos] == '+' || s[pos] == '-'){
+                    unsigned oh = 0, om = 0;
+                    if(s.size() < pos + 6 || s[pos + 3] != ':' || !detail::parse_digits(s, pos + 1, 2, oh) ||
+                       !detail::parse_digits(s, pos + 4, 2, om)) return std::nullopt;
+                    const std::int64_t offset = (static_cast<std::int64_t>(oh) * 60 + om) * 60'000'000'000;
+                    ns -= s[pos] == '+' ? offset : -offset;
+                    pos += 6;
+                }
+            }
+        }
+        if(pos != s.size()) return std::nullopt;
+        const auto days = std::chrono::sys_days(date).time_since_epoch().count();
+        return static_cast<std::int64_t>(days) * 86'400'000'000'000 + ns;
+    }
+
+    // Extracts one numeric column from CSV text.
+    inline ColumnData parse_column(std::string_view text, std::size_t column, bool has_header = true){
+        ColumnData out;
+        out.values.reserve(text.size() / 64); // Rough bytes per row for OHLCV files
+        bool skip = has_header;
+        for_each_row(text, [&](std::span<const std::string_view> fields){
+            if(skip) {
+                skip = false;
+                return;
+            }
+            out.rows++;
+            double v;
+            switch(column < fields.size() ? parse_number(fields[column], v) : CellStatus::missing){
+                case CellStatus::ok: out.values.push_back(v); break;
+                case CellStatus::missing: out.missing++; break;
+                case CellStatus::invalid: out.invalid++; break;
+            }
+        });
+        return out;
+    }
+
+    struct TickColumns {
+        std::vector<std::int64_t> timestamps; // ns since epoch, UTC
+        std::vector<double> prices;
+        std::size_t rows = 0;
+        std::size_t missing = 0;      // Price missing
+        std::size_t invalid = 0;      // Unparseable price or timestamp
+    };
+
+    // Extracts (timestamp, price) pairs; rows where either is unusable are
+    // skipped and counted.
+    inline TickColumns parse_ticks(std::string_view text, std::size_t time_column, std::size_t price_column,
+                                   bool has_header = true){
+        TickColumns out;
+        out.timestamps.reserve(text.size() / 64);
+        out.prices.reserve(text.size() / 64);
+        bool skip = has_header;
+        for_each_row(text, [&](std::span<const std::string_view> fields){
+            if(skip) {
+                skip = false;
+                return;
+            }
+            out.rows++;
+            double v;
+            switch(price_column < fields.size() ? parse_number(fields[price_column], v) : CellStatus::missing){
+                case CellStatus::ok: break;
+                case CellStatus::missing: out.missing++; return;
+                case CellStatus::invalid: out.invalid++; return;
+            }
+            const auto ts = time_column < fields.size() ? parse_datetime(fields[time_column]) : std::nullopt;
+            if(!ts) {
+                out.invalid++;
+                return;
+            }
+            out.timestamps.push_back(*ts);
+            out.prices.push_back(v);
+        });
+        return out;
+    }
+
+    // Maps `path` and extracts one numeric column. Throws std::system_error if
+    // the file cannot be opened or mapped.
+    inline ColumnData load_column(const std::string& path, std::size_t column, bool has_header = true){
+        const MappedFile file(path);
+        return parse_column(file.view(), column, has_header);
+    }
+
+    inline TickColumns load_ticks(const std::string& path, std::size_t time_column, std::size_t price_column,
+                                  bool has_header = true){
+        const MappedFile file(path);
+        return parse_ticks(file.view(), time_column, price_column, has_header);
+    }
+
+    // Loads the same column from several files on up to `threads` threads
+    // (0 = hardware concurrency). Results are in `paths` order; a file that
+    // fails to load yields an empty result with `error` set.
+    inline std::vector<ColumnData> load_columns(std::span<const std::string> paths, std::size_t column,
+                                                bool has_header = true, unsigned threads = 0){
+        std::vector<ColumnData> results(paths.size());
+        std::atomic<std::size_t> next{0};
+        auto worker = [&]{
+            for(std::size_t i = next.fetch_add(1); i < paths.size(); i = next.fetch_add(1)){
+                try {
+                    results[i] = load_column(paths[i], column, has_header);
+                } catch(const std::exception& e) {
+                    results[i].error = e.what();
+                }
+            }
+        };
+
+        if(threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        const auto n = std::min<std::size_t>(threads, paths.size());
+        std::vector<std::thread> pool;
+        for(std::size_t t = 1; t < n; t++) pool.emplace_back(worker);
+        worker();
+        for(auto& th : pool) th.join();
+        return results;
+    }
+}
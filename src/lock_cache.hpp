@@ -1,9 +1,13 @@
 #pragma once
+#include <algorithm>
 #include <chrono>
 #include <mutex>
 #include <list>
 #include <unordered_map>
 #include <optional>
+#include <span>
+
+#include "../include/locallru/async_load.hpp"
 
 namespace lockedlru {
     
@@ -46,6 +50,138 @@ namespace lockedlru {
                 return it->second.value;
             }
             
+            // In-place access under the lock: fn gets a reference to the
+            // stored value instead of a copy. read/update return false on a
+            // miss; upsert inserts a value-initialised V first. Keep fn short,
+            // it runs with the cache locked.
+            template<typename F>
+            bool read(const key_type& key, F&& fn){
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = map_.find(key);
+                if(it == map_.end()) return false;
+                lru_.splice(lru_.begin(), lru_, it->second.lru_it);
+                it->second.lru_it = lru_.begin();
+                fn(static_cast<const value_type&>(it->second.value));
+                return true;
+            }
+            
+            template<typename F>
+            bool update(const key_type& key, F&& fn){
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = map_.find(key);
+                if(it == map_.end()) return false;
+                lru_.splice(lru_.begin(), lru_, it->second.lru_it);
+                it->second.lru_it = lru_.begin();
+                fn(it->second.value);
+                return true;
+            }
+            
+            template<typename F>
+            void upsert(const key_type& key, F&& fn){
+                std::lock_guard<std::mutex> lock(mutex_);
+                if(capacity_ == 0) return;
+                auto it = map_.find(key);
+                if(it != map_.end()) {
+                    lru_.splice(lru_.begin(), lru_, it->second.lru_it);
+                    it->second.lru_it = lru_.begin();
+                    fn(it->second.value);
+                    return;
+                }
+                if(map_.size() >= capacity_) {
+                    auto last = std::prev(lru_.end());
+                    map_.erase(*last);
+                    lru_.pop_back();
+                }
+                lru_.push_front(key);
+                auto inserted = map_.emplace(key, Node{value_type{}, lru_.begin()}).first;
+                fn(inserted->second.value);
+            }
+            
+            // Looks up every key under a single lock acquisition.
+            std::size_t get_many(std::span<const key_type> keys, std::span<std::optional<value_type>> out){
+                std::lock_guard<std::mutex> lock(mutex_);
+                std::size_t hits = 0;
+                for(std::size_t i = 0; i < keys.size(); i++){
+                    auto it = map_.find(keys[i]);
+                    if(it == map_.end()) {
+                        out[i].reset();
+                        continue;
+                    }
+                    lru_.splice(lru_.begin(), lru_, it->second.lru_it);
+                    it->second.lru_it = lru_.begin();
+                    out[i] = it->second.value;
+                    hits++;
+                }
+                return hits;
+            }
+            
+            // co_await get_or_load(key, loader): see
+            // include/locallru/async_load.hpp. Concurrent misses for a key,
+            // from any thread, share one load; done may be called from any
+            // thread and resumes the waiters there.
+            template<typename Loader>
+            auto get_or_load(const key_type& key, Loader&& loader){
+                return loads_.await(key, get(key), std::forward<Loader>(loader),
+                                    [this](const key_type& k, const value_type& v){ put(k, v); });
+            }
+            
+            const locallru::LoadJoiner<key_type, value_type>& pending_loads() const noexcept { return loads_; }
+            
+            bool erase(const key_type& key){
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = map_.find(key);
+                if(it == map_.end()) return false;
+                lru_.erase(it->second.lru_it);
+                map_.erase(it);
+                return true;
+            }
+            
+            // Erases key only if pred(value) holds, checked under the same
+            // lock, so a value another thread just stored is not removed in
+            // its place.
+            template<typename P>
+            bool erase_if(const key_type& key, P&& pred){
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = map_.find(key);
+                if(it == map_.end() || !pred(static_cast<const value_type&>(it->second.value))) return false;
+                lru_.erase(it->second.lru_it);
+                map_.erase(it);
+                return true;
+            }
+            
+            std::size_t size() const {
+                std::lock_guard<std::mutex> lock(mutex_);
+                return map_.size();
+            }
+            
+            std::size_t capacity() const noexcept { return capacity_; }
+            
+            void reserve(std::size_t n){
+                std::lock_guard<std::mutex> lock(mutex_);
+                map_.reserve(std::min(n, capacity_));
+            }
+            
+            // Calls fn(key, value, expiry) for every entry, least recently
+            // used first, under the lock. No TTLs here: expiry is always
+            // time_point::max(). With put() and reserve(), this is what
+            // locallru::snapshot() / restore() use; a restore inserts one
+            // entry per lock acquisition, so concurrent readers are not
+            // blocked for the whole load.
+            template<typename F>
+            void for_each_lru(F&& fn) const {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for(auto it = lru_.rbegin(); it != lru_.rend(); ++it){
+                    fn(static_cast<const key_type&>(*it), static_cast<const value_type&>(map_.find(*it)->second.value),
+                       Clock::time_point::max());
+                }
+            }
+            
+            void clear(){
+                std::lock_guard<std::mutex> lock(mutex_);
+                map_.clear();
+                lru_.clear();
+            }
+            
         private:
             struct Node {
                 value_type value;
@@ -57,6 +193,7 @@ namespace lockedlru {
             std::size_t capacity_;
             Map map_;
             std::list<key_type> lru_;
-            std::mutex mutex_;
+            mutable std::mutex mutex_;
+            locallru::LoadJoiner<key_type, value_type> loads_;
     };
 }
\ No newline at end of file
@@ -0,0 +1,190 @@
+#pragma once
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// memcache_protocol.hpp
+// Request parser and response encoding for the subset of the memcached text
+// protocol the cache server speaks: get/gets (multi-key), set, delete,
+// version and quit.
+// -----------------------------------------------------------------------------
+// - parse_request() works on a connection's receive buffer in place: it
+//   either parses one complete request (including a set's data block) and
+//   reports its length, or says more bytes are needed. Keys and data are
+//   string_views into the buffer, so nothing is copied until the store.
+// - Pipelining falls out of this: the server parses requests back to back
+//   from one buffer and appends all responses to one output buffer.
+// - Limits follow memcached: keys up to 250 bytes without control
+//   characters or spaces. Values are capped at kMaxValueBytes.
+// -----------------------------------------------------------------------------
+
+namespace locallru::server {
+
+    inline constexpr std::size_t kMaxKeyBytes = 250;
+    inline constexpr std::size_t kMaxValueBytes = 1u << 20;
+    inline constexpr std::size_t kMaxLineBytes = 64u << 10; // get lines carry many keys
+
+    enum class Command { get, gets, set, del, version, quit };
+
+    enum class ParseStatus {
+        complete,       // request holds one request of request.length bytes
+        incomplete,     // need more bytes
+        error,          // request.length bytes are consumed; reply request.error
+        fatal           // reply request.error and close the connection
+    };
+
+    struct Request {
+        Command command = Command::get;
+        std::vector<std::string_view> keys;  // get/gets: all keys; set/delete: one
+        std::uint32_t flags = 0;
+        std::int64_t exptime = 0;            // Seconds; 0 = never
+        std::string_view data;               // set
+        bool noreply = false;
+        std::size_t length = 0;              // Bytes consumed from the buffer
+        std::string_view error;              // Full error response line
+    };
+
+    namespace detail {
+        inline constexpr std::string_view kError = "ERROR\r\n";
+        inline constexpr std::string_view kBadFormat = "CLIENT_ERROR bad command line format\r\n";
+        inline constexpr std::string_view kBadChunk = "CLIENT_ERROR bad data chunk\r\n";
+        inline constexpr std::string_view kTooLarge = "SERVER_ERROR object too large for cache\r\n";
+        inline constexpr std::string_view kLineTooLong = "CLIENT_ERROR line too long\r\n";
+
+        // Next space-separated token of line, advancing it.
+        inline std::string_view next_token(std::string_view& line){
+            std::size_t b = 0;
+            while(b < line.size() && line[b] == ' ') b++;
+            std::size_t e = b;
+            while(e < line.size() && line[e] != ' ') e++;
+            const std::string_view t = line.substr(b, e - b);
+            line.remove_prefix(e);
+            return t;
+        }
+
+        template<typename T>
+        bool parse_number(std::string_view s, T& out){
+            if(s.empty()) return false;
+            const auto [p, ec] = std::from_chars(s.data(), s.data() + s.size(), out);
+            return ec == std::errc() && p == s.data() + s.size();
+        }
+
+        inline bool valid_key(std::string_view k){
+            if(k.empty() || k.size() > kMaxKeyBytes) return false;
+            for(unsigned char c : k) if(c <= ' ' || c == 0x7f) return false;
+            return true;
+        }
+    }
+
+    // Parses the request at the start of buf.
+    inline ParseStatus parse_request(std::string_view buf, Request& r){
+        using namespace detail;
+        const std::size_t eol = buf.find('\n');
+        if(eol == std::string_view::npos) {
+            if(buf.size() > kMaxLineBytes) {
+                r.error = kLineTooLong;
+                return ParseStatus::fatal;
+            }
+            return ParseStatus::incomplete;
+        }
+        std::string_view line = buf.substr(0, eol);
+        if(!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        r.length = eol + 1;
+        r.keys.clear();
+        r.noreply = false;
+        r.data = {};
+
+        const std::string_view cmd = next_token(line);
+        if(cmd == "get" || cmd == "gets") {
+            r.command = cmd == "get" ? Command::get : Command::gets;
+            for(std::string_view k = next_token(line); !k.empty(); k = next_token(line)){
+                if(!valid_key(k)) {
+                    r.error = kBadFormat;
+                    return ParseStatus::error;
+                }
+                r.keys.push_back(k);
+            }
+            if(r.keys.empty()) {
+                r.error = kError;
+                return ParseStatus::error;
+            }
+            return ParseStatus::complete;
+        }
+        if(cmd == "set") {
+            r.command = Command::set;
+            const std::string_view key = next_token(line);
+            std::size_t bytes = 0;
+            if(!valid_key(key) || !parse_number(next_token(line), r.flags) || !parse_number(next_token(line), r.exptime) ||
+               !parse_number(next_token(line), bytes)) {
+                r.error = kBadFormat;
+                return ParseStatus::error;
+            }
+            const std::string_view opt = next_token(line);
+            r.noreply = opt == "noreply";
+            if(bytes > kMaxValueBytes) {
+                // The data block cannot be skipped reliably; drop the connection
+                r.error = kTooLarge;
+                return ParseStatus::fatal;
+            }
+            if(buf.size() < r.length + bytes + 2) return ParseStatus::incomplete;
+            if(buf.compare(r.length + bytes, 2, "\r\n") != 0) {
+                r.error = kBadChunk;
+                return ParseStatus::fatal;
+            }
+            r.keys.push_back(key);
+            r.data = buf.substr(r.length, bytes);
+            r.length += bytes + 2;
+            return ParseStatus::complete;
+        }
+        if(cmd == "delete") {
+            r.command = Command::del;
+            const std::string_view key = next_token(line);
+            if(!valid_key(key)) {
+                r.error = kBadFormat;
+                return ParseStatus::error;
+            }
+            r.keys.push_back(key);
+            for(std::string_view t = next_token(line); !t.empty(); t = next_token(line)) r.noreply = r.noreply || t == "noreply";
+            return ParseStatus::complete;
+        }
+        if(cmd == "version") {
+            r.command = Command::version;
+            return ParseStatus::complete;
+        }
+        if(cmd == "quit") {
+            r.command = Command::quit;
+            return ParseStatus::complete;
+        }
+        r.error = kError;
+        return ParseStatus::error;
+    }
+
+    // Response encoding, appended to a connection's output buffer.
+    inline void append_value(std::string& out, std::string_view key, std::uint32_t flags, std::string_view data,
+                             const std::uint64_t* cas = nullptr){
+        char num[24];
+        out.append("VALUE ");
+        out.append(key);
+        out.push_back(' ');
+        out.append(num, static_cast<std::size_t>(std::to_chars(num, num + sizeof(num), flags).ptr - num));
+        out.push_back(' ');
+        out.append(num, static_cast<std::size_t>(std::to_chars(num, num + sizeof(num), data.size()).ptr - num));
+        if(cas) {
+            out.push_back(' ');
+            out.append(num, static_cast<std::size_t>(std::to_chars(num, num + sizeof(num), *cas).ptr - num));
+        }
+        out.append("\r\n");
+        out.append(data);
+        out.append("\r\n");
+    }
+
+    inline constexpr std::string_view kEnd = "END\r\n";
+    inline constexpr std::string_view kStored = "STORED\r\n";
+    inline constexpr std::string_view kDeleted = "DELETED\r\n";
+    inline constexpr std::string_view kNotFound = "NOT_FOUND\r\n";
+}
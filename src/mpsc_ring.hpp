@@ -0,0 +1,109 @@
+#pragma once
+#include "spsc_ring.hpp"
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+// -----------------------------------------------------------------------------
+// mpsc_ring.hpp
+// Bounded lock-free multi-producer / single-consumer ring buffer.
+// -----------------------------------------------------------------------------
+// - Each slot carries a sequence number (Vyukov's bounded queue). Producers
+//   claim a slot by CAS on the tail and publish it by bumping the slot's
+//   sequence; the consumer needs no atomic RMW at all.
+// - A producer that has claimed a slot but not yet published it holds up
+//   the consumer at that slot only; later slots wait behind it, so
+//   per-producer order is preserved.
+// - Same consumer interface as SpscRing (try_pop / consume), so code can be
+//   written once for both.
+// -----------------------------------------------------------------------------
+
+namespace locallru {
+
+    template<typename T>
+    class MpscRing {
+        static_assert(std::is_default_constructible_v<T>, "MpscRing slots are default-constructed");
+
+      public:
+        explicit MpscRing(std::size_t capacity)
+            : mask_(std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity) - 1),
+              slots_(std::make_unique<Slot[]>(mask_ + 1)) {
+            for(std::size_t i = 0; i <= mask_; i++) slots_[i].seq.store(i, std::memory_order_relaxed);
+        }
+
+        MpscRing(const MpscRing&) = delete;
+        MpscRing& operator=(const MpscRing&) = delete;
+
+        std::size_t capacity() const noexcept { return mask_ + 1; }
+
+        // Producer side, any thread. Returns false if the ring is full.
+        bool try_push(const T& value){
+            std::size_t pos = tail_.load(std::memory_order_relaxed);
+            for(;;){
+                Slot& s = slots_[pos & mask_];
+                const std::size_t seq = s.seq.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+                if(diff == 0) {
+                    if(tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        s.value = value;
+                        s.seq.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if(diff < 0) {
+                    return false; // Slot still holds an element from the previous lap
+                } else {
+                    pos = tail_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Consumer side. Returns false if the ring is empty.
+        bool try_pop(T& out){
+            Slot& s = slots_[head_ & mask_];
+            if(s.seq.load(std::memory_order_acquire) != head_ + 1) return false;
+            out = std::move(s.value);
+            s.seq.store(head_ + mask_ + 1, std::memory_order_release);
+            head_++;
+            return true;
+        }
+
+        // Consumer side. Calls fn(const T&) for up to max_items published
+        // elements in order, releasing each slot after its call. Returns the
+        // count.
+        template<typename F>
+        std::size_t consume(F&& fn, std::size_t max_items = static_cast<std::size_t>(-1)){
+            std::size_t n = 0;
+            while(n < max_items){
+                Slot& s = slots_[head_ & mask_];
+                if(s.seq.load(std::memory_order_acquire) != head_ + 1) break;
+                fn(static_cast<const T&>(s.value));
+                s.seq.store(head_ + mask_ + 1, std::memory_order_release);
+                head_++;
+                n++;
+            }
+            return n;
+        }
+
+        // Consumer side; approximate while producers are pushing.
+        std::size_t size() const noexcept {
+            return tail_.load(std::memory_order_acquire) - head_;
+        }
+        bool empty() const noexcept { return size() == 0; }
+
+      private:
+        struct Slot {
+            std::atomic<std::size_t> seq{0};
+            T value{};
+        };
+
+        const std::size_t mask_;
+        std::unique_ptr<Slot[]> slots_;
+
+        alignas(kCacheLine) std::atomic<std::size_t> tail_{0}; // Claimed by producers
+        alignas(kCacheLine) std::size_t head_ = 0;              // Consumer only
+    };
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+// -----------------------------------------------------------------------------
+// spsc_ring.hpp
+// Bounded lock-free single-producer / single-consumer ring buffer.
+// -----------------------------------------------------------------------------
+// - Capacity is rounded up to a power of two; indices are free-running and
+//   masked on access.
+// - Producer and consumer indices live on separate cache lines, and each side
+//   keeps a private copy of the other's index so that the shared line is only
+//   re-read when the ring looks full (producer) or empty (consumer).
+// - consume() hands out a batch of elements and publishes the new head once,
+//   which is what makes draining cheap for background consumers.
+// -----------------------------------------------------------------------------
+
+namespace locallru {
+
+    inline constexpr std::size_t kCacheLine = 64;
+
+    template<typename T>
+    class SpscRing {
+        static_assert(std::is_default_constructible_v<T>, "SpscRing slots are default-constructed");
+
+      public:
+        explicit SpscRing(std::size_t capacity)
+            : mask_(std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity) - 1),
+              slots_(std::make_unique<T[]>(mask_ + 1)) {}
+
+        SpscRing(const SpscRing&) = delete;
+        SpscRing& operator=(const SpscRing&) = delete;
+
+        std::size_t capacity() const noexcept { return mask_ + 1; }
+
+        // Producer side. Returns false if the ring is full.
+        bool try_push(const T& value){
+            const std::size_t tail = tail_.load(std::memory_order_relaxed);
+            if(tail - head_cache_ > mask_) {
+                head_cache_ = head_.load(std::memory_order_acquire);
+                if(tail - head_cache_ > mask_) return false;
+            }
+            slots_[tail & mask_] = value;
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side. Returns false if the ring is empty.
+        bool try_pop(T& out){
+            const std::size_t head = head_.load(std::memory_order_relaxed);
+            if(head == tail_cache_) {
+                tail_cache_ = tail_.load(std::memory_order_acquire);
+                if(head == tail_cache_) return false;
+            }
+            out = std::move(slots_[head & mask_]);
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side. Calls fn(const T&) for up to max_items available
+        // elements, then releases them all at once. Returns the count.
+        template<typename F>
+        std::size_t consume(F&& fn, std::size_t max_items = static_cast<std::size_t>(-1)){
+            const std::size_t head = head_.load(std::memory_order_relaxed);
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            std::size_t n = tail_cache_ - head;
+            if(n > max_items) n = max_items;
+            for(std::size_t i = 0; i < n; i++) fn(static_cast<const T&>(slots_[(head + i) & mask_]));
+            if(n) head_.store(head + n, std::memory_order_release);
+            return n;
+        }
+
+        // Approximate when called concurrently with push/pop.
+        std::size_t size() const noexcept {
+            return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+        }
+        bool empty() const noexcept { return size() == 0; }
+
+      private:
+        const std::size_t mask_;
+        std::unique_ptr<T[]> slots_;
+
+        alignas(kCacheLine) std::atomic<std::size_t> head_{0}; // Written by consumer
+        std::size_t tail_cache_ = 0;                          // Consumer's view of tail_
+        alignas(kCacheLine) std::atomic<std::size_t> tail_{0}; // Written by producer
+        std::size_t head_cache_ = 0;                          // Producer's view of head_
+    };
+}
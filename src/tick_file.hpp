@@ -0,0 +1,325 @@
+#pragma once
+#include "csv_ingest.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// tick_file.hpp
+// Columnar binary tick file: per-symbol blocks of timestamps and prices that
+// a reader memory-maps and hands out as spans, so a replay starts without
+// parsing or copying anything.
+// -----------------------------------------------------------------------------
+// Layout (host byte order; little-endian hosts only):
+//
+//   TickFileHeader                       magic, version, symbol count, size
+//   TickFileSymbol[symbol_count]         one directory entry per symbol
+//   per symbol, each 64-byte aligned:
+//     prices      double[count]
+//     timestamps  int64_t[count]         raw: ns since epoch, UTC
+//              or uint32_t[count]        delta: (ts[i] - ts[i-1]) / unit_ns,
+//                                        with ts[-1] = base
+//
+// Delta encoding halves the timestamp column. The writer uses it only when
+// asked to and when it is exact: timestamps non-decreasing, every delta a
+// multiple of the chosen unit (1 s, 1 ms, 1 us or 1 ns, coarsest first) and
+// below 2^32 units. Otherwise that symbol is stored raw.
+// -----------------------------------------------------------------------------
+
+namespace locallru::feed {
+
+    static_assert(std::endian::native == std::endian::little, "tick files are stored little-endian");
+
+    inline constexpr char kTickFileMagic[8] = {'L', 'L', 'R', 'U', 'T', 'I', 'C', 'K'};
+    inline constexpr std::uint32_t kTickFileVersion = 1;
+    inline constexpr std::size_t kTickColumnAlign = 64;
+
+    enum class TimestampEncoding : std::uint32_t { raw = 0, delta32 = 1 };
+
+    struct TickFileHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t symbol_count;
+        std::uint64_t file_size;
+    };
+
+    struct TickFileSymbol {
+        char name[24];                // NUL-padded
+        std::uint64_t count;
+        std::uint64_t price_offset;
+        std::uint64_t ts_offset;
+        std::int64_t ts_base;         // delta32 only
+        TimestampEncoding ts_encoding;
+        std::uint32_t ts_unit_ns;     // delta32 only
+    };
+    static_assert(sizeof(TickFileHeader) == 24 && sizeof(TickFileSymbol) == 64);
+
+    // Timestamps of one symbol, decoded on the fly when delta-encoded.
+    // Iteration is forward-only; use at() only on raw columns or for
+    // occasional lookups (it is O(i) on delta columns).
+    class TimestampColumn {
+      public:
+        TimestampColumn() = default;
+        explicit TimestampColumn(std::span<const std::int64_t> raw) : raw_(raw), size_(raw.size()) {}
+        TimestampColumn(std::int64_t base, std::uint32_t unit_ns, std::span<const std::uint32_t> deltas)
+            : deltas_(deltas), base_(base), unit_ns_(unit_ns), size_(deltas.size()) {}
+
+        class iterator {
+          public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::int64_t;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const std::int64_t*;
+            using reference = std::int64_t;
+
+            iterator() = default;
+
+            std::int64_t operator*() const { return col_->encoded() ? value_ : col_->raw_[i_]; }
+            iterator& operator++(){
+                if(++i_ < col_->size_ && col_->encoded()) value_ += std::int64_t{col_->deltas_[i_]} * col_->unit_ns_;
+                return *this;
+            }
+            iterator operator++(int){
+                iterator old = *this;
+                ++*this;
+                return old;
+            }
+            bool operator==(const iterator& o) const { return i_ == o.i_; }
+
+          private:
+            friend class TimestampColumn;
+
+            // Only begin() and end(): a delta column's value at i is
+            // decoded from the first delta, so i is 0 or size().
+            iterator(const TimestampColumn* col, std::size_t i) : col_(col), i_(i) {
+                if(col_ && col_->encoded() && i_ < col_->size_) value_ = col_->base_ + std::int64_t{col_->deltas_[0]} * col_->unit_ns_;
+            }
+
+            const TimestampColumn* col_ = nullptr;
+            std::size_t i_ = 0;
+            std::int64_t value_ = 0;
+        };
+
+        iterator begin() const { return iterator(this, 0); }
+        iterator end() const { return iterator(this, size_); }
+        std::size_t size() const noexcept { return size_; }
+        bool encoded() const noexcept { return unit_ns_ != 0; }
+
+        // Zero-copy view; empty for delta-encoded columns.
+        std::span<const std::int64_t> raw() const noexcept { return raw_; }
+
+        std::int64_t at(std::size_t i) const {
+            if(!encoded()) return raw_[i];
+            std::int64_t v = base_;
+            for(std::size_t j = 0; j <= i; j++) v += std::int64_t{deltas_[j]} * unit_ns_;
+            return v;
+        }
+
+      private:
+        std::span<const std::int64_t> raw_;
+        std::span<const std::uint32_t> deltas_;
+        std::int64_t base_ = 0;
+        std::uint32_t unit_ns_ = 0;   // 0 = raw
+        std::size_t size_ = 0;
+    };
+
+    struct SymbolTicks {
+        std::string_view symbol;
+        std::span<const double> prices;
+        TimestampColumn timestamps;
+    };
+
+    // Maps a tick file and validates its directory. Spans returned by
+    // symbols() / find() point into the mapping and live as long as the
+    // TickFile. Throws std::system_error if the file cannot be mapped and
+    // std::runtime_error if it is not a well-formed tick file.
+    class TickFile {
+      public:
+        explicit TickFile(const std::string& path) : file_(path) {
+            const std::string_view bytes = file_.view();
+            auto fail = [&](const char* what){ throw std::runtime_error(path + ": " + what); };
+
+            if(bytes.size() < sizeof(TickFileHeader)) fail("too small for a tick file");
+            TickFileHeader h;
+            std::memcpy(&h, bytes.data(), sizeof(h));
+            if(std::memcmp(h.magic, kTickFileMagic, sizeof(h.magic)) != 0) fail("not a tick file");
+            if(h.version != kTickFileVersion) fail("unsupported tick file version");
+            if(h.file_size != bytes.size()) fail("truncated tick file");
+            if(h.symbol_count > (bytes.size() - sizeof(h)) / sizeof(TickFileSymbol)) fail("corrupt symbol directory");
+
+            const char* base = bytes.data();
+            auto in_bounds = [&](std::uint64_t offset, std::uint64_t count, std::size_t elem){
+                return offset % alignof(std::int64_t) == 0 && offset <= bytes.size() &&
+                       count <= (bytes.size() - offset) / elem;
+            };
+            symbols_.reserve(h.symbol_count);
+            for(std::uint32_t i = 0; i < h.symbol_count; i++){
+                const char* entry = base + sizeof(h) + i * sizeof(TickFileSymbol);
+                TickFileSymbol e;
+                std::memcpy(&e, entry, sizeof(e));
+                SymbolTicks t;
+                t.symbol = std::string_view(entry + offsetof(TickFileSymbol, name), ::strnlen(e.name, sizeof(e.name)));
+                if(!in_bounds(e.price_offset, e.count, sizeof(double))) fail("price column out of bounds");
+                t.prices = {reinterpret_cast<const double*>(base + e.price_offset), static_cast<std::size_t>(e.count)};
+                if(e.ts_encoding == TimestampEncoding::raw){
+                    if(!in_bounds(e.ts_offset, e.count, sizeof(std::int64_t))) fail("timestamp column out of bounds");
+                    t.timestamps = TimestampColumn({reinterpret_cast<const std::int64_t*>(base + e.ts_offset), static_cast<std::size_t>(e.count)});
+                } else if(e.ts_encoding == TimestampEncoding::delta32 && e.ts_unit_ns != 0){
+                    if(!in_bounds(e.ts_offset, e.count, sizeof(std::uint32_t))) fail("timestamp column out of bounds");
+                    t.timestamps = TimestampColumn(e.ts_base, e.ts_unit_ns,
+                                                   {reinterpret_cast<const std::uint32_t*>(base + e.ts_offset), static_cast<std::size_t>(e.count)});
+                } else {
+                    fail("unknown timestamp encoding");
+                }
+                symbols_.push_back(t);
+            }
+        }
+
+        std::span<const SymbolTicks> symbols() const noexcept { return symbols_; }
+
+        const SymbolTicks* find(std::string_view symbol) const {
+            for(const auto& s : symbols_){
+                if(s.symbol == symbol) return &s;
+            }
+            return nullptr;
+        }
+
+      private:
+        MappedFile file_;
+        std::vector<SymbolTicks> symbols_;
+    };
+
+    // Input to write_tick_file(); timestamps and prices must be the same
+    // length.
+    struct TickSeries {
+        std::string symbol;
+        std::vector<std::int64_t> timestamps;
+        std::vector<double> prices;
+    };
+
+    struct TickFileOptions {
+        bool delta_timestamps = false;
+    };
+
+    namespace detail {
+        // Coarsest unit in which every delta is exact and fits in 32 bits;
+        // 0 if delta encoding does not apply.
+        inline std::uint32_t delta_unit(std::span<const std::int64_t> ts){
+            for(std::uint32_t unit : {1'000'000'000u, 1'000'000u, 1'000u, 1u}){
+                bool ok = true;
+                std::int64_t prev = ts.empty() ? 0 : ts[0];
+                for(std::int64_t t : ts){
+                    const std::int64_t d = t - prev;
+                    prev = t;
+                    if(d < 0 || d % unit != 0 || d / unit > std::numeric_limits<std::uint32_t>::max()) {
+                        ok = false;
+                        break;
+                    }
+                }
+                if(ok) return unit;
+            }
+            return 0;
+        }
+
+        inline std::uint64_t align_up(std::uint64_t v){
+            return (v + kTickColumnAlign - 1) & ~std::uint64_t{kTickColumnAlign - 1};
+        }
+    }
+
+    // Writes `series` as a tick file. The file is written under a temporary
+    // name and renamed into place, so readers never see a partial file.
+    // Throws std::system_error on I/O failure and std::invalid_argument on
+    // malformed input.
+    inline void write_tick_file(const std::string& path, std::span<const TickSeries> series,
+                                const TickFileOptions& opt = {}){
+        std::vector<TickFileSymbol> dir(series.size());
+        std::uint64_t offset = detail::align_up(sizeof(TickFileHeader) + series.size() * sizeof(TickFileSymbol));
+        for(std::size_t i = 0; i < series.size(); i++){
+            const TickSeries& s = series[i];
+            if(s.timestamps.size() != s.prices.size()) throw std::invalid_argument(s.symbol + ": timestamp/price length mismatch");
+            if(s.symbol.size() >= sizeof(dir[i].name)) throw std::invalid_argument(s.symbol + ": symbol name too long");
+            TickFileSymbol& e = dir[i];
+            std::memset(&e, 0, sizeof(e));
+            std::memcpy(e.name, s.symbol.data(), s.symbol.size());
+            e.count = s.prices.size();
+            e.price_offset = offset;
+            offset = detail::align_up(offset + e.count * sizeof(double));
+            e.ts_offset = offset;
+            const std::uint32_t unit = opt.delta_timestamps ? detail::delta_unit(s.timestamps) : 0;
+            if(unit != 0){
+                e.ts_encoding = TimestampEncoding::delta32;
+                e.ts_unit_ns = unit;
+                e.ts_base = s.timestamps.empty() ? 0 : s.timestamps[0];
+                offset = detail::align_up(offset + e.count * sizeof(std::uint32_t));
+            } else {
+                e.ts_encoding = TimestampEncoding::raw;
+                offset = detail::align_up(offset + e.count * sizeof(std::int64_t));
+            }
+        }
+
+        TickFileHeader h{};
+        std::memcpy(h.magic, kTickFileMagic, sizeof(h.magic));
+        h.version = kTickFileVersion;
+        h.symbol_count = static_cast<std::uint32_t>(series.size());
+        h.file_size = offset;
+
+        const std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if(!out) throw std::system_error(errno, std::generic_category(), "open " + tmp);
+            std::uint64_t written = 0;
+            auto put = [&](const void* p, std::size_t n){
+                out.write(static_cast<const char*>(p), static_cast<std::streamsize>(n));
+                written += n;
+            };
+            auto pad_to = [&](std::uint64_t target){
+                static constexpr char zeros[kTickColumnAlign] = {};
+                while(written < target) put(zeros, static_cast<std::size_t>(std::min<std::uint64_t>(target - written, sizeof(zeros))));
+            };
+
+            put(&h, sizeof(h));
+            put(dir.data(), dir.size() * sizeof(TickFileSymbol));
+            std::vector<std::uint32_t> deltas;
+            for(std::size_t i = 0; i < series.size(); i++){
+                const TickSeries& s = series[i];
+                const TickFileSymbol& e = dir[i];
+                pad_to(e.price_offset);
+                put(s.prices.data(), s.prices.size() * sizeof(double));
+                pad_to(e.ts_offset);
+                if(e.ts_encoding == TimestampEncoding::delta32){
+                    deltas.resize(s.timestamps.size());
+                    std::int64_t prev = e.ts_base;
+                    for(std::size_t j = 0; j < s.timestamps.size(); j++){
+                        deltas[j] = static_cast<std::uint32_t>((s.timestamps[j] - prev) / e.ts_unit_ns);
+                        prev = s.timestamps[j];
+                    }
+                    put(deltas.data(), deltas.size() * sizeof(std::uint32_t));
+                } else {
+                    put(s.timestamps.data(), s.timestamps.size() * sizeof(std::int64_t));
+                }
+            }
+            pad_to(h.file_size);
+            out.flush();
+            if(!out) throw std::system_error(errno, std::generic_category(), "write " + tmp);
+        }
+        if(std::rename(tmp.c_str(), path.c_str()) != 0) {
+            const int err = errno;
+            std::remove(tmp.c_str());
+            throw std::system_error(err, std::generic_category(), "rename " + tmp);
+        }
+    }
+}
@@ -0,0 +1,203 @@
+#pragma once
+#include "spsc_ring.hpp"
+#include "tick_file.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// tick_replay.hpp
+// Multi-symbol replay: merges every symbol's ticks into one stream ordered
+// by timestamp, optionally paces it to (scaled) recorded time, and fans it
+// out to strategy threads.
+// -----------------------------------------------------------------------------
+// - TickMerger is a k-way merge over per-symbol columns (a binary heap of
+//   one cursor per symbol); ties go to the lower symbol index, so a replay
+//   is deterministic.
+// - Pacer sleeps until a tick's scheduled wall time, spinning for the last
+//   stretch so short gaps are not rounded up to the scheduler tick. When
+//   the replay falls behind it does not wait, and the lag is recorded.
+//   Idle periods (nights, weekends) can be capped so paced replays of
+//   multi-day data stay practical.
+// - replay() runs the merge and pacing on the calling thread (the feed) and
+//   broadcasts every tick to each strategy thread through its own SpscRing.
+//   A full ring back-pressures the feed.
+// -----------------------------------------------------------------------------
+
+namespace locallru::feed {
+
+    struct Tick {
+        std::int64_t ts_ns;           // UTC ns since epoch
+        double price;
+        std::uint32_t symbol;         // Index into the replay's sources
+    };
+
+    // One symbol's columns; usually a TickFile symbol or parse_ticks() output.
+    struct TickSource {
+        std::span<const double> prices;
+        TimestampColumn timestamps;
+    };
+
+    class TickMerger {
+      public:
+        explicit TickMerger(std::span<const TickSource> sources){
+            heap_.reserve(sources.size());
+            for(std::size_t s = 0; s < sources.size(); s++){
+                const std::size_t n = std::min(sources[s].prices.size(), sources[s].timestamps.size());
+                if(n == 0) continue;
+                Cursor c{sources[s].timestamps.begin(), sources[s].prices, 0, n, static_cast<std::uint32_t>(s), 0};
+                c.ts = *c.it;
+                heap_.push_back(c);
+            }
+            std::make_heap(heap_.begin(), heap_.end(), later);
+        }
+
+        bool done() const noexcept { return heap_.empty(); }
+
+        std::optional<Tick> next(){
+            if(heap_.empty()) return std::nullopt;
+            std::pop_heap(heap_.begin(), heap_.end(), later);
+            Cursor& c = heap_.back();
+            const Tick t{c.ts, c.prices[c.i], c.symbol};
+            if(++c.i < c.n) {
+                c.ts = *++c.it;
+                std::push_heap(heap_.begin(), heap_.end(), later);
+            } else {
+                heap_.pop_back();
+            }
+            return t;
+        }
+
+      private:
+        struct Cursor {
+            TimestampColumn::iterator it;
+            std::span<const double> prices;
+            std::size_t i;
+            std::size_t n;
+            std::uint32_t symbol;
+            std::int64_t ts;
+        };
+
+        // Heap order: std::*_heap keep the "largest" on top, so invert.
+        static bool later(const Cursor& a, const Cursor& b){
+            return a.ts != b.ts ? a.ts > b.ts : a.symbol > b.symbol;
+        }
+
+        std::vector<Cursor> heap_;
+    };
+
+    // Maps recorded time to wall time at `speed` x real time. speed <= 0
+    // disables pacing. Gaps in recorded time longer than max_gap_ns (e.g.
+    // overnight) are shortened to max_gap_ns; 0 keeps them.
+    class Pacer {
+      public:
+        using SteadyClock = std::chrono::steady_clock;
+
+        explicit Pacer(double speed, std::int64_t max_gap_ns = 0) : speed_(speed), max_gap_ns_(max_gap_ns) {}
+
+        void wait(std::int64_t ts_ns){
+            if(speed_ <= 0.0) return;
+            const auto now = SteadyClock::now();
+            if(!started_) {
+                started_ = true;
+                first_ts_ = last_ts_ = ts_ns;
+                start_ = now;
+                return;
+            }
+            if(max_gap_ns_ > 0 && ts_ns - last_ts_ > max_gap_ns_) first_ts_ += ts_ns - last_ts_ - max_gap_ns_;
+            last_ts_ = ts_ns;
+            const auto due = start_ + std::chrono::nanoseconds(static_cast<std::int64_t>(static_cast<double>(ts_ns - first_ts_) / speed_));
+            if(now >= due) {
+                max_lag_ns_ = std::max<std::int64_t>(max_lag_ns_, (now - due).count());
+                return;
+            }
+            if(due - now > kSpin) std::this_thread::sleep_until(due - kSpin);
+            while(SteadyClock::now() < due) {}
+        }
+
+        std::int64_t max_lag_ns() const noexcept { return max_lag_ns_; }
+
+      private:
+        static constexpr std::chrono::microseconds kSpin{100};
+
+        const double speed_;
+        const std::int64_t max_gap_ns_;
+        bool started_ = false;
+        std::int64_t first_ts_ = 0;         // Recorded time at start_, shifted by skipped gaps
+        std::int64_t last_ts_ = 0;
+        SteadyClock::time_point start_;
+        std::int64_t max_lag_ns_ = 0;
+    };
+
+    struct ReplayOptions {
+        double speed = 0.0;           // x real time; <= 0 replays as fast as possible
+        std::int64_t max_gap_ns = 0;  // Cap on paced gaps between ticks; 0 = none
+        int strategies = 1;
+        std::size_t ring_capacity = 1 << 14;
+    };
+
+    struct ReplayStats {
+        std::uint64_t ticks = 0;
+        double seconds = 0.0;         // Feed start to last strategy finished
+        std::int64_t max_lag_ns = 0;  // Worst lateness behind the pacing schedule
+        std::uint64_t stalls = 0;     // Pushes that found a strategy ring full
+    };
+
+    // Replays `sources` to opt.strategies threads. On strategy thread i,
+    // make_strategy(i) is called once and the callable it returns is invoked
+    // with every tick, in merge order, then destroyed on the same thread.
+    template<typename MakeStrategy>
+    ReplayStats replay(std::span<const TickSource> sources, const ReplayOptions& opt, MakeStrategy&& make_strategy){
+        const int n = std::max(1, opt.strategies);
+        std::vector<std::unique_ptr<SpscRing<Tick>>> rings;
+        for(int i = 0; i < n; i++) rings.push_back(std::make_unique<SpscRing<Tick>>(opt.ring_capacity));
+        std::atomic<bool> done{false};
+        std::atomic<int> ready{0};
+
+        std::vector<std::thread> threads;
+        for(int i = 0; i < n; i++){
+            threads.emplace_back([&, i]{
+                auto strategy = make_strategy(i);
+                SpscRing<Tick>& ring = *rings[i];
+                ready.fetch_add(1, std::memory_order_release);
+                for(;;){
+                    if(ring.consume(strategy) != 0) continue;
+                    if(done.load(std::memory_order_acquire)) {
+                        ring.consume(strategy); // Anything pushed before done was set
+                        break;
+                    }
+                    std::this_thread::yield();
+                }
+            });
+        }
+        while(ready.load(std::memory_order_acquire) != n) std::this_thread::yield();
+
+        ReplayStats stats;
+        const auto start = std::chrono::steady_clock::now();
+        TickMerger merger(sources);
+        Pacer pacer(opt.speed, opt.max_gap_ns);
+        while(auto t = merger.next()){
+            pacer.wait(t->ts_ns);
+            for(auto& ring : rings){
+                if(ring->try_push(*t)) continue;
+                stats.stalls++;
+                while(!ring->try_push(*t)) std::this_thread::yield();
+            }
+            stats.ticks++;
+        }
+        done.store(true, std::memory_order_release);
+        for(auto& th : threads) th.join();
+
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stats.max_lag_ns = pacer.max_lag_ns();
+        return stats;
+    }
+}
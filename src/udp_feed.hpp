@@ -0,0 +1,287 @@
+#pragma once
+#include "wire_tick.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// -----------------------------------------------------------------------------
+// udp_feed.hpp
+// UDP market-data transport for local testing: a sender that packs wire
+// ticks into datagrams and paces them with sendmmsg, and a receiver that
+// drains many datagrams per syscall with recvmmsg.
+// -----------------------------------------------------------------------------
+// - Datagram = PacketHeader + count WireTicks, at most kMaxPacketBytes so it
+//   fits an Ethernet MTU without fragmentation.
+// - Unicast or multicast, chosen by the address. Multicast is sent with
+//   loopback enabled on the 127.0.0.1 interface, so sender and receiver can
+//   share one machine.
+// - Packet sequence numbers let the receiver count lost datagrams (e.g. when
+//   its socket buffer overflows during a burst). A packet with count == 0
+//   marks the end of the stream; UDP may lose it, so receivers should also
+//   give up after an idle timeout.
+// - Linux only (sendmmsg / recvmmsg).
+// -----------------------------------------------------------------------------
+
+namespace locallru::feed {
+
+    struct PacketHeader {
+        std::uint64_t seq;
+        std::int64_t send_ns;         // steady_clock at send, for same-host latency
+        std::uint32_t count;          // WireTicks that follow; 0 = end of stream
+        std::uint32_t reserved;
+    };
+    static_assert(sizeof(PacketHeader) == 24 && sizeof(PacketHeader) % alignof(WireTick) == 0);
+
+    inline constexpr std::size_t kMaxPacketBytes = 1472; // 1500 MTU - IPv4 - UDP headers
+    inline constexpr std::size_t kMaxTicksPerPacket = (kMaxPacketBytes - sizeof(PacketHeader)) / sizeof(WireTick);
+
+    struct UdpEndpoint {
+        std::string address = "127.0.0.1"; // 224.0.0.0/4 selects multicast
+        std::uint16_t port = 30001;
+    };
+
+    inline std::int64_t steady_now_ns(){
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+    namespace detail {
+        [[noreturn]] inline void throw_errno(const std::string& what){
+            throw std::system_error(errno, std::generic_category(), what);
+        }
+
+        inline sockaddr_in to_sockaddr(const UdpEndpoint& ep){
+            sockaddr_in sa{};
+            sa.sin_family = AF_INET;
+            sa.sin_port = htons(ep.port);
+            if(::inet_pton(AF_INET, ep.address.c_str(), &sa.sin_addr) != 1) {
+                throw std::invalid_argument("not an IPv4 address: " + ep.address);
+            }
+            return sa;
+        }
+
+        inline bool is_multicast(const sockaddr_in& sa){
+            return IN_MULTICAST(ntohl(sa.sin_addr.s_addr));
+        }
+    }
+
+    // Owns a socket descriptor.
+    class UdpSocket {
+      public:
+        UdpSocket() : fd_(::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0)) {
+            if(fd_ < 0) detail::throw_errno("socket");
+        }
+        UdpSocket(const UdpSocket&) = delete;
+        UdpSocket& operator=(const UdpSocket&) = delete;
+        ~UdpSocket(){ ::close(fd_); }
+
+        int fd() const noexcept { return fd_; }
+
+        template<typename T>
+        void set_option(int level, int name, const T& value, const char* what){
+            if(::setsockopt(fd_, level, name, &value, sizeof(value)) != 0) detail::throw_errno(what);
+        }
+
+      private:
+        int fd_;
+    };
+
+    struct SendOptions {
+        std::size_t ticks_per_packet = 16;
+        double packets_per_sec = 100'000; // 0 = as fast as the socket accepts
+        std::size_t burst = 8;            // Packets per sendmmsg call; the pacing unit
+        int repeat = 1;                   // Passes over the ticks
+    };
+
+    struct SendStats {
+        std::uint64_t packets = 0;
+        std::uint64_t ticks = 0;
+        std::uint64_t send_calls = 0;
+        double seconds = 0.0;
+    };
+
+    // Sends `ticks` as datagrams to `to`, `burst` packets per sendmmsg,
+    // bursts spaced so the average is packets_per_sec. Blocks until done,
+    // then sends a few end-of-stream packets.
+    inline SendStats send_ticks(const UdpEndpoint& to, std::span<const WireTick> ticks, const SendOptions& opt){
+        UdpSocket sock;
+        const sockaddr_in dest = detail::to_sockaddr(to);
+        if(detail::is_multicast(dest)){
+            const in_addr lo{htonl(INADDR_LOOPBACK)};
+            sock.set_option(IPPROTO_IP, IP_MULTICAST_IF, lo, "IP_MULTICAST_IF");
+            sock.set_option(IPPROTO_IP, IP_MULTICAST_LOOP, static_cast<unsigned char>(1), "IP_MULTICAST_LOOP");
+            sock.set_option(IPPROTO_IP, IP_MULTICAST_TTL, static_cast<unsigned char>(0), "IP_MULTICAST_TTL");
+        }
+        if(::connect(sock.fd(), reinterpret_cast<const sockaddr*>(&dest), sizeof(dest)) != 0) detail::throw_errno("connect");
+
+        const std::size_t per_packet = std::clamp<std::size_t>(opt.ticks_per_packet, 1, kMaxTicksPerPacket);
+        const std::size_t burst = std::max<std::size_t>(1, opt.burst);
+        const std::size_t packet_bytes = sizeof(PacketHeader) + per_packet * sizeof(WireTick);
+        std::vector<std::uint64_t> storage((burst * packet_bytes + 7) / 8); // 8-byte aligned packets
+        auto* buf = reinterpret_cast<char*>(storage.data());
+        std::vector<iovec> iov(burst);
+        std::vector<mmsghdr> msgs(burst);
+
+        SendStats stats;
+        std::uint64_t seq = 0;
+        const std::int64_t start = steady_now_ns();
+        const double burst_gap_ns = opt.packets_per_sec > 0 ? 1e9 * static_cast<double>(burst) / opt.packets_per_sec : 0.0;
+
+        auto flush = [&](std::size_t n, std::int64_t send_ns){
+            for(std::size_t i = 0; i < n; i++) std::memcpy(buf + i * packet_bytes + offsetof(PacketHeader, send_ns), &send_ns, sizeof(send_ns));
+            std::size_t done = 0;
+            while(done < n){
+                const int sent = ::sendmmsg(sock.fd(), msgs.data() + done, static_cast<unsigned>(n - done), 0);
+                if(sent < 0) {
+                    if(errno == EINTR || errno == ENOBUFS || errno == EAGAIN) continue;
+                    detail::throw_errno("sendmmsg");
+                }
+                done += static_cast<std::size_t>(sent);
+                stats.send_calls++;
+            }
+            stats.packets += n;
+        };
+
+        std::size_t filled = 0;
+        std::uint64_t bursts = 0;
+        for(int pass = 0; pass < opt.repeat; pass++){
+            for(std::size_t i = 0; i < ticks.size(); i += per_packet){
+                const std::size_t count = std::min(per_packet, ticks.size() - i);
+                char* p = buf + filled * packet_bytes;
+                const PacketHeader h{++seq, 0, static_cast<std::uint32_t>(count), 0};
+                std::memcpy(p, &h, sizeof(h));
+                std::memcpy(p + sizeof(h), ticks.data() + i, count * sizeof(WireTick));
+                iov[filled] = iovec{p, sizeof(h) + count * sizeof(WireTick)};
+                msgs[filled] = mmsghdr{};
+                msgs[filled].msg_hdr.msg_iov = &iov[filled];
+                msgs[filled].msg_hdr.msg_iovlen = 1;
+                stats.ticks += count;
+                if(++filled < burst) continue;
+
+                if(burst_gap_ns > 0){
+                    const auto due = start + static_cast<std::int64_t>(static_cast<double>(bursts) * burst_gap_ns);
+                    while(steady_now_ns() < due) {}
+                }
+                bursts++;
+                flush(filled, steady_now_ns());
+                filled = 0;
+            }
+        }
+        if(filled) flush(filled, steady_now_ns());
+        stats.seconds = static_cast<double>(steady_now_ns() - start) / 1e9;
+
+        // End of stream, repeated in case one is dropped
+        for(int i = 0; i < 3; i++){
+            const PacketHeader eos{++seq, steady_now_ns(), 0, 0};
+            ::send(sock.fd(), &eos, sizeof(eos), 0);
+        }
+        return stats;
+    }
+
+    struct ReceiveStats {
+        std::uint64_t packets = 0;
+        std::uint64_t ticks = 0;
+        std::uint64_t lost = 0;       // Gaps in packet sequence numbers
+        std::uint64_t malformed = 0;
+        std::uint64_t recv_calls = 0; // recvmmsg calls that returned packets
+    };
+
+    // Bound (and, for multicast, joined) receiving socket that drains up to
+    // `batch` datagrams per recvmmsg call.
+    class UdpReceiver {
+      public:
+        explicit UdpReceiver(const UdpEndpoint& on, std::size_t batch = 32, int rcvbuf_bytes = 8 << 20)
+            : batch_(std::max<std::size_t>(1, batch)),
+              storage_(batch_ * kSlotWords), iov_(batch_), msgs_(batch_) {
+            sockaddr_in sa = detail::to_sockaddr(on);
+            sock_.set_option(SOL_SOCKET, SO_REUSEADDR, 1, "SO_REUSEADDR");
+            sock_.set_option(SOL_SOCKET, SO_RCVBUF, rcvbuf_bytes, "SO_RCVBUF");
+            if(detail::is_multicast(sa)){
+                ip_mreq mreq{};
+                mreq.imr_multiaddr = sa.sin_addr;
+                mreq.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+                sock_.set_option(IPPROTO_IP, IP_ADD_MEMBERSHIP, mreq, "IP_ADD_MEMBERSHIP");
+            }
+            if(::bind(sock_.fd(), reinterpret_cast<const sockaddr*>(&sa), sizeof(sa)) != 0) detail::throw_errno("bind");
+            for(std::size_t i = 0; i < batch_; i++){
+                iov_[i] = iovec{storage_.data() + i * kSlotWords, kSlotWords * sizeof(std::uint64_t)};
+                msgs_[i].msg_hdr.msg_iov = &iov_[i];
+                msgs_[i].msg_hdr.msg_iovlen = 1;
+            }
+        }
+
+        // Waits up to `timeout` for datagrams and calls
+        // on_packet(const PacketHeader&, std::span<const WireTick>) for each
+        // data packet received. Returns false once the end-of-stream packet
+        // has been seen or the timeout expired with nothing received.
+        template<typename OnPacket>
+        bool poll(OnPacket&& on_packet, std::chrono::milliseconds timeout){
+            if(timeout != timeout_) {
+                timeval tv{static_cast<time_t>(timeout.count() / 1000), static_cast<suseconds_t>((timeout.count() % 1000) * 1000)};
+                sock_.set_option(SOL_SOCKET, SO_RCVTIMEO, tv, "SO_RCVTIMEO");
+                timeout_ = timeout;
+            }
+            for(auto& m : msgs_) m.msg_len = 0;
+            const int n = ::recvmmsg(sock_.fd(), msgs_.data(), static_cast<unsigned>(batch_), MSG_WAITFORONE, nullptr);
+            if(n < 0) {
+                if(errno == EAGAIN || errno == EWOULDBLOCK) return false;
+                if(errno == EINTR) return true;
+                detail::throw_errno("recvmmsg");
+            }
+            stats_.recv_calls++;
+            bool more = true;
+            for(int i = 0; i < n; i++){
+                const char* p = reinterpret_cast<const char*>(storage_.data() + static_cast<std::size_t>(i) * kSlotWords);
+                const std::size_t len = msgs_[i].msg_len;
+                PacketHeader h;
+                if(len < sizeof(h)) {
+                    stats_.malformed++;
+                    continue;
+                }
+                std::memcpy(&h, p, sizeof(h));
+                if(h.count > kMaxTicksPerPacket || len != sizeof(h) + h.count * sizeof(WireTick)) {
+                    stats_.malformed++;
+                    continue;
+                }
+                if(h.seq > next_seq_) stats_.lost += h.seq - next_seq_;
+                if(h.seq >= next_seq_) next_seq_ = h.seq + 1;
+                if(h.count == 0) {
+                    more = false;
+                    continue;
+                }
+                stats_.packets++;
+                stats_.ticks += h.count;
+                on_packet(static_cast<const PacketHeader&>(h),
+                          std::span<const WireTick>(reinterpret_cast<const WireTick*>(p + sizeof(h)), h.count));
+            }
+            return more;
+        }
+
+        const ReceiveStats& stats() const noexcept { return stats_; }
+
+      private:
+        static constexpr std::size_t kSlotWords = (kMaxPacketBytes + 7) / 8;
+
+        UdpSocket sock_;
+        const std::size_t batch_;
+        std::vector<std::uint64_t> storage_; // batch_ 8-byte aligned packet slots
+        std::vector<iovec> iov_;
+        std::vector<mmsghdr> msgs_;
+        std::chrono::milliseconds timeout_{-1};
+        std::uint64_t next_seq_ = 1;
+        ReceiveStats stats_;
+    };
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "tick_replay.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// wire_tick.hpp
+// Fixed-size binary tick message used by the pipeline and network demos to
+// stand in for an exchange feed, and the decoder a feed handler runs on it.
+// -----------------------------------------------------------------------------
+// - 32 bytes, little-endian, no padding: symbol (8 bytes, NUL-padded),
+//   sequence number, exchange timestamp (UTC ns) and price as a signed
+//   fixed-point integer in millionths.
+// - Decoding resolves the symbol through a SymbolTable (a linear scan of
+//   8-byte codes, which beats hashing for the handful of symbols a feed
+//   carries) and converts the price back to double.
+// -----------------------------------------------------------------------------
+
+namespace locallru::feed {
+
+    static_assert(std::endian::native == std::endian::little, "wire ticks are little-endian");
+
+    inline constexpr double kWirePriceScale = 1e6;
+
+    struct WireTick {
+        char symbol[8];
+        std::uint64_t seq;
+        std::int64_t ts_ns;
+        std::int64_t price_e6;
+    };
+    static_assert(sizeof(WireTick) == 32 && std::is_trivially_copyable_v<WireTick>);
+
+    class SymbolTable {
+      public:
+        explicit SymbolTable(std::span<const std::string> symbols){
+            codes_.reserve(symbols.size());
+            for(const auto& s : symbols) codes_.push_back(code_of(s));
+        }
+
+        std::optional<std::uint32_t> find(const char (&symbol)[8]) const {
+            std::uint64_t code;
+            std::memcpy(&code, symbol, sizeof(code));
+            const auto it = std::find(codes_.begin(), codes_.end(), code);
+            if(it == codes_.end()) return std::nullopt;
+            return static_cast<std::uint32_t>(it - codes_.begin());
+        }
+
+        static std::uint64_t code_of(std::string_view s){
+            char buf[8] = {};
+            std::memcpy(buf, s.data(), std::min(s.size(), sizeof(buf)));
+            std::uint64_t code;
+            std::memcpy(&code, buf, sizeof(code));
+            return code;
+        }
+
+      private:
+        std::vector<std::uint64_t> codes_;
+    };
+
+    inline WireTick encode_tick(std::string_view symbol, const Tick& t, std::uint64_t seq){
+        WireTick w{};
+        std::memcpy(w.symbol, symbol.data(), std::min(symbol.size(), sizeof(w.symbol)));
+        w.seq = seq;
+        w.ts_ns = t.ts_ns;
+        w.price_e6 = std::llround(t.price * kWirePriceScale);
+        return w;
+    }
+
+    // Returns false for symbols not in the table.
+    inline bool decode_tick(const WireTick& w, const SymbolTable& symbols, Tick& out){
+        const auto id = symbols.find(w.symbol);
+        if(!id) return false;
+        out.symbol = *id;
+        out.ts_ns = w.ts_ns;
+        out.price = static_cast<double>(w.price_e6) / kWirePriceScale;
+        return true;
+    }
+}
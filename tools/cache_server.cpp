@@ -0,0 +1,103 @@
+#include "../src/cache_server.hpp"
+
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+
+using namespace locallru;
+using namespace locallru::server;
+
+// Runs a cache as a local memcached-protocol sidecar (see
+// src/cache_server.hpp) until SIGINT/SIGTERM, e.g.
+//
+//   cache_server --port=11211 --threads=4 --capacity=1000000
+//   printf 'set k 0 0 1\r\nv\r\nget k\r\n' | nc -q1 127.0.0.1 11211
+
+namespace {
+    struct Args {
+        ServerOptions server;
+        std::string engine = "shared";
+        std::size_t capacity = 1'000'000;
+        std::uint64_t ttl = 0;
+    };
+
+    Args parse_args(int argc, char** argv){
+        Args a;
+        for(int i = 1; i < argc; i++){
+            const char* arg = argv[i];
+            auto value = [&](const char* flag) -> const char* {
+                const std::size_t n = std::strlen(flag);
+                return std::strncmp(arg, flag, n) == 0 ? arg + n : nullptr;
+            };
+            if(auto v = value("--address=")) a.server.address = v;
+            else if(auto v = value("--port=")) a.server.port = static_cast<std::uint16_t>(std::atoi(v));
+            else if(auto v = value("--threads=")) a.server.threads = std::atoi(v);
+            else if(std::strcmp(arg, "--pin") == 0) a.server.pin_threads = true;
+            else if(auto v = value("--engine=")) a.engine = v;
+            else if(auto v = value("--capacity=")) a.capacity = std::strtoull(v, nullptr, 10);
+            else if(auto v = value("--ttl=")) a.ttl = std::strtoull(v, nullptr, 10);
+            else if(auto v = value("--backend="); v && parse_io_backend(v, a.server.backend)) {}
+            else {
+                std::fprintf(stderr,
+                    "usage: %s [--address=IP] [--port=N] [--threads=N] [--pin] [--engine=shared|local]\n"
+                    "          [--capacity=N] [--ttl=S] [--backend=auto|posix|io_uring]\n", argv[0]);
+                std::exit(2);
+            }
+        }
+        if(a.engine != "shared" && a.engine != "local") {
+            std::fprintf(stderr, "unknown engine: %s\n", a.engine.c_str());
+            std::exit(2);
+        }
+        return a;
+    }
+
+    void (*g_stop)() = nullptr;
+
+    extern "C" void on_signal(int){
+        if(g_stop) g_stop();
+    }
+
+    template<typename Engine>
+    int serve(const Args& args, Engine engine){
+        static CacheServer<Engine>* server = nullptr;
+        CacheServer<Engine> s(args.server, std::move(engine));
+        server = &s;
+        g_stop = []{ server->stop(); };
+        std::signal(SIGINT, on_signal);
+        std::signal(SIGTERM, on_signal);
+        std::printf("serving %s engine on %s:%u with %d threads (%s)\n", args.engine.c_str(), args.server.address.c_str(),
+                    s.port(), args.server.threads, to_string(s.backend()));
+        std::fflush(stdout);
+        s.run();
+        const ServerStats st = s.stats();
+        std::printf("connections %llu, requests %llu, get keys %llu (%.1f%% hit), sets %llu, deletes %llu, "
+                    "%.1f requests per recv, %.2f syscalls per request\n",
+                    static_cast<unsigned long long>(st.connections), static_cast<unsigned long long>(st.requests),
+                    static_cast<unsigned long long>(st.get_keys),
+                    st.get_keys ? 100.0 * static_cast<double>(st.get_hits) / static_cast<double>(st.get_keys) : 0.0,
+                    static_cast<unsigned long long>(st.sets), static_cast<unsigned long long>(st.deletes),
+                    static_cast<double>(st.requests) / static_cast<double>(st.recv_calls ? st.recv_calls : 1),
+                    static_cast<double>(st.syscalls) / static_cast<double>(st.requests ? st.requests : 1));
+        return 0;
+    }
+}
+
+int main(int argc, char** argv){
+    const Args args = parse_args(argc, argv);
+    try {
+        if(args.engine == "local") {
+            LocalCache<CacheItem>::initialize(args.capacity, args.ttl);
+            return serve(args, LocalEngine{});
+        }
+        if(args.ttl != 0) std::fprintf(stderr, "--ttl applies to the local engine only; use per-item exptime\n");
+        SharedEngine::Store store(args.capacity);
+        return serve(args, SharedEngine(store));
+    } catch(const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+}
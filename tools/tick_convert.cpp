@@ -0,0 +1,107 @@
+#include "../src/csv_ingest.hpp"
+#include "../src/tick_file.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace locallru::feed;
+
+// Converts price CSVs into one columnar tick file (see src/tick_file.hpp).
+// Each CSV becomes one symbol named after the file stem, e.g.
+//
+//   tick_convert --delta-ts ../data/ticks.bin ../data/AAPL.csv ../data/MSFT.csv
+
+namespace {
+    struct Args {
+        std::string output;
+        std::vector<std::string> inputs;
+        TickFileOptions options;
+        std::size_t time_column = 0;  // Datetime
+        std::size_t price_column = 4; // Close
+    };
+
+    [[noreturn]] void usage(const char* argv0){
+        std::fprintf(stderr,
+            "usage: %s [--delta-ts] [--time-column=N] [--price-column=N] <output> <file.csv>...\n", argv0);
+        std::exit(2);
+    }
+
+    Args parse_args(int argc, char** argv){
+        Args a;
+        std::vector<std::string> positional;
+        for(int i = 1; i < argc; i++){
+            const char* arg = argv[i];
+            auto value = [&](const char* flag) -> const char* {
+                const std::size_t n = std::strlen(flag);
+                return std::strncmp(arg, flag, n) == 0 ? arg + n : nullptr;
+            };
+            if(std::strcmp(arg, "--delta-ts") == 0) a.options.delta_timestamps = true;
+            else if(auto v = value("--time-column=")) a.time_column = std::strtoull(v, nullptr, 10);
+            else if(auto v = value("--price-column=")) a.price_column = std::strtoull(v, nullptr, 10);
+            else if(arg[0] == '-') usage(argv[0]);
+            else positional.emplace_back(arg);
+        }
+        if(positional.size() < 2) usage(argv[0]);
+        a.output = positional[0];
+        a.inputs.assign(positional.begin() + 1, positional.end());
+        return a;
+    }
+}
+
+int main(int argc, char** argv){
+    const Args args = parse_args(argc, argv);
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<TickSeries> series(args.inputs.size());
+    std::vector<std::string> errors(args.inputs.size());
+    std::vector<std::thread> loaders;
+    for(std::size_t i = 0; i < args.inputs.size(); i++){
+        loaders.emplace_back([&, i]{
+            try {
+                TickColumns cols = load_ticks(args.inputs[i], args.time_column, args.price_column);
+                series[i].symbol = std::filesystem::path(args.inputs[i]).stem().string();
+                series[i].timestamps = std::move(cols.timestamps);
+                series[i].prices = std::move(cols.prices);
+                if(cols.invalid) {
+                    errors[i] = "skipped " + std::to_string(cols.invalid) + " invalid row(s)";
+                }
+            } catch(const std::exception& e) {
+                errors[i] = e.what();
+                series[i].symbol.clear();
+            }
+        });
+    }
+    for(auto& t : loaders) t.join();
+
+    std::size_t ticks = 0;
+    for(std::size_t i = 0; i < series.size(); i++){
+        if(!errors[i].empty()) std::fprintf(stderr, "%s: %s\n", args.inputs[i].c_str(), errors[i].c_str());
+        if(series[i].symbol.empty()) return 1;
+        ticks += series[i].prices.size();
+    }
+
+    try {
+        write_tick_file(args.output, series, args.options);
+    } catch(const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    const TickFile check(args.output);
+    for(const auto& s : check.symbols()){
+        std::printf("%-8.*s %10zu ticks  timestamps %s\n", static_cast<int>(s.symbol.size()), s.symbol.data(),
+                    s.prices.size(), s.timestamps.encoded() ? "delta" : "raw");
+    }
+    std::printf("wrote %zu ticks to %s (%ju bytes) in %.1f ms\n", ticks, args.output.c_str(),
+                static_cast<std::uintmax_t>(std::filesystem::file_size(args.output)),
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    return 0;
+}